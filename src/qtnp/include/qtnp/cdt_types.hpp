@@ -32,19 +32,63 @@
 
 #include <CGAL/lloyd_optimize_mesh_2.h>
 
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <stdint.h>
+
 #include "constants.hpp"
+#include "sizing_field.hpp"
+
+/*****************************************************************************
+** Narrow integers for the cell struct
+*****************************************************************************/
+
+// Stores an int in a smaller type. Reads convert back to int, so the planning code keeps
+// working with plain ints; a write that doesn't fit throws instead of wrapping around.
+template <class T>
+class Narrow {
+  public:
+    Narrow() : value(0) {}
+    explicit Narrow(int v) : value(checked(v)) {}
+
+    Narrow &operator=(int v){
+      value = checked(v);
+      return *this;
+    }
+
+    operator int() const { return value; }
+
+  private:
+    static T checked(int v){
+      if ( (v < std::numeric_limits<T>::min()) || (v > std::numeric_limits<T>::max()) ){
+        throw std::out_of_range("cell attribute out of range for its packed type");
+      }
+      return static_cast<T>(v);
+    }
+
+    T value;
+};
 
 /*****************************************************************************
 ** CDT cell struct, defining extra info for each cell
 *****************************************************************************/
 
+// Packed into 12 bytes (it was 48) since every face of the triangulation carries one,
+// the infinite and out of domain ones too. The centre of each cell is kept in the cell
+// table of Tnp_update, indexed by id.
 struct FaceInfo2
 {
-  FaceInfo2(){}
+  FaceInfo2() :
+    id(-1), coverage_depth(constants::coverage_depth_max),
+    visited(false), numbered(false), path_visited(false), cover_depth(false), aux(false), occupied(false)
+  {}
 
-  bool visited, numbered, path_visited, cover_depth, aux, occupied;
-  int id, depth, agent_id, jumps_agent_id, coverage_depth;
-  double center_lat, center_lon;
+  // widest first, so there is no padding in between
+  int id;
+  Narrow<int16_t> depth, coverage_depth, jumps_agent_id;
+  Narrow<int8_t> agent_id;
+  bool visited : 1, numbered : 1, path_visited : 1, cover_depth : 1, aux : 1, occupied : 1;
 
   void initialize(int face_id){
     visited = numbered = path_visited = cover_depth = aux = occupied = false;
@@ -93,6 +137,102 @@ typedef CGAL::Constrained_Delaunay_triangulation_2<K, Tds, Itag> CDT;
 typedef CGAL::Delaunay_mesh_size_criteria_2<CDT> Criteria;
 typedef CGAL::Delaunay_mesher_2<CDT, Criteria> Mesher;
 
+// The usual angle and size criteria, and besides a face is too big when its longest edge is
+// longer than the sizing field asks for at its centroid. Only the attractors count, away
+// from them the size bound does, so a region meshed coarser than the field's background
+// stays coarse. The field is not copied, it has to outlive the mesher.
+class Graded_criteria : public Criteria {
+  public:
+    Graded_criteria(double aspect_bound = 0.125, double size_bound = 0, const qtnp::Sizing_field *field = NULL) :
+        CGAL::Delaunay_mesh_criteria_2<CDT>(aspect_bound), // virtual base, the most derived class sets it
+        Criteria(aspect_bound, size_bound),
+        field(field)
+    {}
+
+    class Is_bad : public Criteria::Is_bad {
+      public:
+        Is_bad(const Criteria::Is_bad &base, const Graded_criteria &criteria) :
+            Criteria::Is_bad(base),
+            field(criteria.field)
+        {}
+
+        CGAL::Mesh_2::Face_badness operator()(const Quality q) const {
+            return Criteria::Is_bad::operator()(q);
+        }
+
+        CGAL::Mesh_2::Face_badness operator()(const CDT::Face_handle &fh, Quality &q) const {
+            CGAL::Mesh_2::Face_badness badness = Criteria::Is_bad::operator()(fh, q);
+            if ((field == NULL) || (badness == CGAL::Mesh_2::IMPERATIVELY_BAD)) return badness;
+
+            const CDT::Point &a = fh->vertex(0)->point();
+            const CDT::Point &b = fh->vertex(1)->point();
+            const CDT::Point &c = fh->vertex(2)->point();
+            double size = field->size_at((a.x() + b.x() + c.x()) / 3, (a.y() + b.y() + c.y()) / 3);
+            if (size >= field->background_size()) return badness;
+            double longest = std::max(CGAL::squared_distance(a, b),
+                                      std::max(CGAL::squared_distance(b, c), CGAL::squared_distance(c, a)));
+            if (longest > size * size){
+                // as the size criterion of cgal marks its own
+                q.first = 1;
+                q.second = longest / (size * size);
+                return CGAL::Mesh_2::IMPERATIVELY_BAD;
+            }
+            return badness;
+        }
+
+      private:
+        const qtnp::Sizing_field *field;
+    };
+
+    Is_bad is_bad_object() const { return Is_bad(Criteria::is_bad_object(), *this); }
+
+  private:
+    const qtnp::Sizing_field *field;
+};
+typedef CGAL::Delaunay_mesher_2<CDT, Graded_criteria> Graded_mesher;
+
+// The graded criteria, applied only to faces whose centroid lies in a box. Everything
+// outside counts as good, so refining after a local change (a new hole) leaves the rest of
+// the mesh, and the cells on it, alone.
+class Local_criteria : public Graded_criteria {
+  public:
+    Local_criteria(double aspect_bound = 0.125, double size_bound = 0,
+                   double min_x = 0, double min_y = 0, double max_x = 0, double max_y = 0,
+                   const qtnp::Sizing_field *field = NULL) :
+        CGAL::Delaunay_mesh_criteria_2<CDT>(aspect_bound), // virtual base, the most derived class sets it
+        Graded_criteria(aspect_bound, size_bound, field),
+        min_x(min_x), min_y(min_y), max_x(max_x), max_y(max_y)
+    {}
+
+    class Is_bad : public Graded_criteria::Is_bad {
+      public:
+        Is_bad(const Graded_criteria::Is_bad &base, const Local_criteria &criteria) :
+            Graded_criteria::Is_bad(base),
+            min_x(criteria.min_x), min_y(criteria.min_y), max_x(criteria.max_x), max_y(criteria.max_y)
+        {}
+
+        CGAL::Mesh_2::Face_badness operator()(const Quality q) const {
+            return Graded_criteria::Is_bad::operator()(q);
+        }
+
+        CGAL::Mesh_2::Face_badness operator()(const CDT::Face_handle &fh, Quality &q) const {
+            double x = (fh->vertex(0)->point().x() + fh->vertex(1)->point().x() + fh->vertex(2)->point().x()) / 3;
+            double y = (fh->vertex(0)->point().y() + fh->vertex(1)->point().y() + fh->vertex(2)->point().y()) / 3;
+            if ((x < min_x) || (x > max_x) || (y < min_y) || (y > max_y)) return CGAL::Mesh_2::NOT_BAD;
+            return Graded_criteria::Is_bad::operator()(fh, q);
+        }
+
+      private:
+        double min_x, min_y, max_x, max_y;
+    };
+
+    Is_bad is_bad_object() const { return Is_bad(Graded_criteria::is_bad_object(), *this); }
+
+  private:
+    double min_x, min_y, max_x, max_y;
+};
+typedef CGAL::Delaunay_mesher_2<CDT, Local_criteria> Local_mesher;
+
 typedef std::vector<kernel_Point_2> CDT_Point_2_vector;
 
 
@@ -0,0 +1,191 @@
+/**
+ * @file /include/qtnp/cell_table.hpp
+ *
+ * @brief Per cell data kept next to the mesh, indexed by the cell id
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_CELL_TABLE_HPP_
+#define qtnp_CELL_TABLE_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+#include <geometry_msgs/Point.h>
+
+#include "cdt_types.hpp"
+#include "geo_transform.hpp"
+#include "terrain_model.hpp"
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Class
+*****************************************************************************/
+
+// Filled once while the in-domain faces are numbered, so FaceInfo2::id is the index.
+// Only the planning code reads it, the face sweeps don't have to carry it around.
+// Centroids and areas are in mesh (rviz) coordinates and each kept in one array, so the
+// nearest cell scans run over them with the batch kernels instead of rebuilding triangles.
+// A local mesh change (a new hole) vacates the ids of the faces it destroyed and fills
+// them again with the new ones, so the ids of the cells it didn't touch stay the same.
+// A vacant id has no face and its centroid is at infinity, never the nearest one.
+class Cell_table {
+  public:
+    void clear(){
+        faces.clear();
+        free_ids.clear();
+        center_x.clear();
+        center_y.clear();
+        cell_area.clear();
+        center_lat.clear();
+        center_lon.clear();
+        center_ground.clear();
+    }
+
+    void reserve(int cells){
+        faces.reserve(cells);
+        center_x.reserve(cells);
+        center_y.reserve(cells);
+        cell_area.reserve(cells);
+        center_lat.reserve(cells);
+        center_lon.reserve(cells);
+    }
+
+    // returns the id of the new cell, its lat, lon come with update_coordinates
+    int add(CDT::Face_handle face, const CDT::Triangle &triangle){
+        faces.push_back(face);
+        center_x.push_back(0);
+        center_y.push_back(0);
+        cell_area.push_back(0);
+        set_geometry((int) faces.size() - 1, triangle);
+        return (int) faces.size() - 1;
+    }
+
+    // like add, into the lowest vacant id if there is one
+    int place(CDT::Face_handle face, const CDT::Triangle &triangle){
+        if (free_ids.empty()) return add(face, triangle);
+        std::pop_heap(free_ids.begin(), free_ids.end(), std::greater<int>());
+        int id = free_ids.back();
+        free_ids.pop_back();
+        faces[id] = face;
+        set_geometry(id, triangle);
+        return id;
+    }
+
+    // a vacant id after the last one, as a restored snapshot has them
+    void add_vacant(){
+        faces.push_back(CDT::Face_handle());
+        center_x.push_back(std::numeric_limits<double>::infinity());
+        center_y.push_back(std::numeric_limits<double>::infinity());
+        cell_area.push_back(0);
+        free_ids.push_back((int) faces.size() - 1);
+        std::push_heap(free_ids.begin(), free_ids.end(), std::greater<int>());
+    }
+
+    void vacate(int id){
+        if (is_vacant(id)) return;
+        faces[id] = CDT::Face_handle();
+        center_x[id] = center_y[id] = std::numeric_limits<double>::infinity();
+        cell_area[id] = 0;
+        free_ids.push_back(id);
+        std::push_heap(free_ids.begin(), free_ids.end(), std::greater<int>());
+    }
+
+    bool is_vacant(int id) const { return faces[id] == CDT::Face_handle(); }
+
+    // still the same triangle as when it was numbered; flips and moved vertices change the centroid
+    bool holds(int id, CDT::Face_handle face, const CDT::Triangle &triangle) const {
+        if ((id < 0) || (id >= size()) || (faces[id] != face)) return false;
+        const CDT::Point &a = triangle[0];
+        const CDT::Point &b = triangle[1];
+        const CDT::Point &c = triangle[2];
+        return (center_x[id] == (a.x() + b.x() + c.x()) / 3) && (center_y[id] == (a.y() + b.y() + c.y()) / 3);
+    }
+
+    // lat, lon of every centroid in one batch, once all the cells are added
+    void update_coordinates(const Geo_transform &geo){
+        center_lat.resize(center_x.size());
+        center_lon.resize(center_y.size());
+        if (!center_x.empty()) geo.to_geo(&center_x[0], &center_y[0], size(), &center_lat[0], &center_lon[0]);
+    }
+
+    // the ground under every centroid in one batch, after update_coordinates; NaN without terrain.
+    // center_lat holds the real longitude (see Geo_transform), the raster wants (lat, lon)
+    void update_ground(Terrain_model &terrain){
+        center_ground.assign(size(), std::numeric_limits<double>::quiet_NaN());
+        if (!center_lat.empty()) terrain.sample(&center_lon[0], &center_lat[0], size(), &center_ground[0]);
+    }
+
+    // ids in use run from 0 to size() - 1, vacant ones included
+    int size() const { return (int) faces.size(); }
+    int count() const { return (int) (faces.size() - free_ids.size()); }
+
+    CDT::Face_handle face(int id) const { return faces[id]; }
+
+    // what the arrays hold on to, capacity included
+    size_t memory_bytes() const {
+        return faces.capacity() * sizeof(CDT::Face_handle) + free_ids.capacity() * sizeof(int) +
+               (center_x.capacity() + center_y.capacity() + cell_area.capacity() + center_lat.capacity() +
+                center_lon.capacity() + center_ground.capacity()) * sizeof(double);
+    }
+
+    double x(int id) const { return center_x[id]; }
+    double y(int id) const { return center_y[id]; }
+    double area(int id) const { return cell_area[id]; }
+    geometry_msgs::Point center_point(int id) const {
+        geometry_msgs::Point point;
+        point.x = center_x[id];
+        point.y = center_y[id];
+        point.z = 0;
+        return point;
+    }
+    // the arrays themselves, for the batch kernels
+    const double *xs() const { return center_x.empty() ? 0 : &center_x[0]; }
+    const double *ys() const { return center_y.empty() ? 0 : &center_y[0]; }
+
+    double lat(int id) const { return center_lat[id]; }
+    double lon(int id) const { return center_lon[id]; }
+    // (lat, lon), the order of the coordinate paths
+    std::pair<double, double> center(int id) const { return std::make_pair(center_lat[id], center_lon[id]); }
+    // metres above sea level
+    double ground(int id) const {
+        return (id < center_ground.size()) ? center_ground[id] : std::numeric_limits<double>::quiet_NaN();
+    }
+
+  private:
+    void set_geometry(int id, const CDT::Triangle &triangle){
+        const CDT::Point &a = triangle[0];
+        const CDT::Point &b = triangle[1];
+        const CDT::Point &c = triangle[2];
+        center_x[id] = (a.x() + b.x() + c.x()) / 3;
+        center_y[id] = (a.y() + b.y() + c.y()) / 3;
+        cell_area[id] = std::fabs((b.x() - a.x()) * (c.y() - a.y()) - (c.x() - a.x()) * (b.y() - a.y())) / 2;
+    }
+
+    std::vector<CDT::Face_handle> faces;
+    std::vector<int> free_ids; // min heap
+    std::vector<double> center_x, center_y, cell_area;
+    std::vector<double> center_lat, center_lon;
+    std::vector<double> center_ground;
+};
+
+} // namespace qtnp
+
+#endif /* qtnp_CELL_TABLE_HPP_ */
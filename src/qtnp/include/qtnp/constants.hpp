@@ -27,6 +27,31 @@ namespace constants
 
     const double angle_criterion_default(0.125);
     const double edge_criterion_default(50.0);
+    // cells one region may be remeshed into, a finer cell size is raised to stay below
+    const int region_cells_max(2000000);
+    // metres the cell size grows by per metre away from a sizing attractor, overridden by ~size_grading
+    const double size_grading_default(0.3);
+
+    // flight time weighting of the partition, overridden by ~cruise_speed and ~waypoint_turn_time
+    const double cruise_speed_default(10.0);      // m/s
+    const double waypoint_turn_time_default(2.0); // s
+
+    // seconds of 2-opt/Or-opt per coverage path, overridden by ~tour_optimization_budget
+    const double tour_budget_default(0.5);
+    // metres, Douglas-Peucker tolerance of the waypoint lists, overridden by ~waypoint_tolerance;
+    // below 0 it follows the size of the cells along each path
+    const double waypoint_tolerance_default(-1.0);
+    // metres above the ground of the mission legs, overridden by ~flight_altitude
+    const double flight_altitude_default(100.0);
+    // metres above home of the home and landing waypoints, as the missions always had them
+    const double home_waypoint_altitude(285.0);
+    const double landing_waypoint_altitude(580.0);
+
+    // vehicles a mission upload goes out to at the same time, on threads of their own
+    const int upload_threads(4);
+
+    // missions with an id next to the one of the gui, overridden by ~max_missions
+    const int max_missions_default(8);
 
     const double PI = 3.1415926;
     const static double r_earth = 6378.137; // in kilometers
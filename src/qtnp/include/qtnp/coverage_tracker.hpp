@@ -0,0 +1,80 @@
+/**
+ * @file /include/qtnp/coverage_tracker.hpp
+ *
+ * @brief Cells flown over by the vehicles, from their position fixes
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_COVERAGE_TRACKER_HPP_
+#define qtnp_COVERAGE_TRACKER_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <map>
+#include <vector>
+#include <stdint.h>
+
+#include "cdt_types.hpp"
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Class
+*****************************************************************************/
+
+// Every vehicle remembers the face of its last fix, and a new fix is found by walking
+// from there along the segment between the two fixes. Consecutive fixes are a few cells
+// apart at most, so a fix costs a handful of orientation tests whatever the mesh size,
+// and the cells crossed on the way are marked too: a fix or two that were skipped leave
+// no gap behind. A covered bit is kept per cell id.
+// Not thread safe, Tnp_update calls it under its planning mutex.
+class Coverage_tracker {
+  public:
+    Coverage_tracker() : covered_cells(0) {}
+
+    // a new mesh: nothing covered and every vehicle located again from scratch
+    void reset(int cell_count);
+    // a local mesh change renumbered these cells; their bits are cleared and the vehicles
+    // located again, their faces may be gone
+    void forget_cells(const std::vector<int> &ids, int cell_count);
+
+    // moves the vehicle to p, marking the cells on the way. Returns the cell id under p,
+    // -1 outside the domain
+    int move(CDT &cdt, int uas, const CDT::Point &p);
+
+    bool is_covered(int id) const { return (covered[id >> 6] >> (id & 63)) & 1; }
+    int covered_count() const { return covered_cells; }
+
+    // the covered bits as they are, e.g. for a snapshot, and back; the vehicles are located again
+    const std::vector<uint64_t> &covered_bits() const { return covered; }
+    void restore(const std::vector<uint64_t> &bits, int cell_count);
+
+  private:
+    struct Vehicle {
+        CDT::Face_handle face;  // finite, the face of the last fix or the nearest one to it
+        CDT::Point position;
+    };
+
+    // the face of q, or with inside false the hull face where q left the triangulation
+    CDT::Face_handle walk(CDT &cdt, CDT::Face_handle from, const CDT::Point &p, const CDT::Point &q, bool &inside);
+    void mark(CDT::Face_handle face);
+
+    std::vector<uint64_t> covered;
+    int covered_cells;
+    std::map<int, Vehicle> vehicles;
+};
+
+} // namespace qtnp
+
+#endif /* qtnp_COVERAGE_TRACKER_HPP_ */
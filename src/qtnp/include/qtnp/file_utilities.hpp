@@ -0,0 +1,53 @@
+/**
+ * @file /include/qtnp/file_utilities.hpp
+ *
+ * @brief Paths under the ROS home, directories and whole file writes
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_FILE_UTILITIES_HPP_
+#define qtnp_FILE_UTILITIES_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <string>
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+namespace files {
+
+/*****************************************************************************
+** Interface
+*****************************************************************************/
+
+// $ROS_HOME/qtnp/<name>, ~/.ros/qtnp/<name> without ROS_HOME
+std::string ros_home_path(const std::string &name);
+
+// a leading ~ to $HOME, anything else as it is
+std::string expand_home(const std::string &path);
+
+// every missing directory on the way, false with the reason if one can't be made or the
+// last one isn't a directory
+bool make_directories(const std::string &directory, std::string &error);
+// the directories above a file
+bool make_parent_directories(const std::string &path, std::string &error);
+
+// all of it into <path>.tmp, then renamed over path, so readers never see half a file; with
+// sync the data is on disk before the rename, a crash can't leave the name pointing at a
+// file that was still in the page cache only
+bool write_file(const std::string &path, const std::string &content, bool sync, std::string &error);
+
+} // namespace files
+} // namespace qtnp
+
+#endif /* qtnp_FILE_UTILITIES_HPP_ */
@@ -0,0 +1,78 @@
+/**
+ * @file /include/qtnp/geo_transform.hpp
+ *
+ * @brief Conversion between lat, lon and the mesh coordinates
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_GEO_TRANSFORM_HPP_
+#define qtnp_GEO_TRANSFORM_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <string>
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Class
+*****************************************************************************/
+
+// Both projections are one scale and one offset per axis, worked out once when the area
+// is known, so a point costs a subtraction and a multiply-add. The mesh x axis follows the
+// "lat" and y the "lon" arguments, as the mesh always had. Those are the placemark fields:
+// kml_parsing stores the first KML coordinate, the longitude, as latitude, so "lat" holds the
+// real longitude and "lon" the real latitude. A fix from a GPS goes in as (lon, lat).
+//   Normalized: the bounding box of the area stretched onto the rviz range (0..500)
+//   Local_enu:  metres east and north of the south west corner, on the plane tangent at
+//               the centre of the area (fine for areas of a few kilometres)
+class Geo_transform {
+  public:
+    enum Projection { Normalized, Local_enu };
+
+    Geo_transform();
+
+    // "normalized" or "local_enu", false for anything else
+    static bool parse_projection(const std::string &name, Projection &projection);
+
+    void set_projection(Projection projection);
+    Projection projection() const { return current_projection; }
+
+    // fits the transform to the bounding box of the constrained area
+    void fit(double min_lat, double max_lat, double min_lon, double max_lon);
+
+    void to_mesh(double lat, double lon, double &x, double &y) const;
+    void to_geo(double x, double y, double &lat, double &lon) const;
+
+    // whole arrays at once, SSE2 where the compiler targets it
+    void to_mesh(const double *lat, const double *lon, int count, double *x, double *y) const;
+    void to_geo(const double *x, const double *y, int count, double *lat, double *lon) const;
+
+    // a length in metres in mesh units. Exact with Local_enu; with Normalized the two axes
+    // have different scales and their mean is used
+    double mesh_length(double metres) const;
+    double metres(double mesh_length) const;
+
+  private:
+    Projection current_projection;
+    double origin_lat, origin_lon;         // geo coordinates of the mesh origin
+    double start_x, start_y;               // mesh coordinates of the origin
+    double scale_x, scale_y;               // mesh units per degree
+    double inverse_x, inverse_y;           // degrees per mesh unit
+    double metres_per_unit_x, metres_per_unit_y;
+};
+
+} // namespace qtnp
+
+#endif /* qtnp_GEO_TRANSFORM_HPP_ */
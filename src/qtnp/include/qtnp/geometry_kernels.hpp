@@ -0,0 +1,46 @@
+/**
+ * @file /include/qtnp/geometry_kernels.hpp
+ *
+ * @brief Batch distance kernels over the coordinate arrays of the cell table
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_GEOMETRY_KERNELS_HPP_
+#define qtnp_GEOMETRY_KERNELS_HPP_
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+namespace kernels {
+
+/*****************************************************************************
+** Interface
+*****************************************************************************/
+
+// SSE2 (two doubles per instruction) where the compiler targets it, plain loops otherwise.
+// Results are identical either way, the loops do the same operations in the same order.
+
+// out[i] = |(xs[i], ys[i]) - (qx, qy)| for i < count
+void distances(const double *xs, const double *ys, int count, double qx, double qy, float *out);
+
+// out[k] = |(xs[ids[k]], ys[ids[k]]) - (qx, qy)| for k < count
+void distances_gather(const double *xs, const double *ys, const int *ids, int count,
+                      double qx, double qy, float *out);
+
+// index (into xs/ys) of the point closest to (qx, qy), the first one on ties; -1 if count is 0
+int nearest(const double *xs, const double *ys, int count, double qx, double qy);
+
+// position k of the closest ids[k], the first one on ties; -1 if count is 0
+int nearest_gather(const double *xs, const double *ys, const int *ids, int count, double qx, double qy);
+
+} // namespace kernels
+} // namespace qtnp
+
+#endif /* qtnp_GEOMETRY_KERNELS_HPP_ */
@@ -0,0 +1,97 @@
+/**
+ * @file /include/qtnp/log_model.hpp
+ *
+ * @brief Fixed size log for the gui, fed from any thread
+ *
+ * @date October 2026
+ **/
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_LOG_MODEL_HPP_
+#define qtnp_LOG_MODEL_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <ros/ros.h>
+#include <atomic>
+#include <deque>
+#include <string>
+#include <vector>
+#include <QAbstractListModel>
+#include <QString>
+#include <QTimer>
+
+#include "mpsc_queue.hpp"
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Types
+*****************************************************************************/
+
+struct Log_entry {
+    int level;  // QNode::LogLevel
+    ros::Time stamp;
+    std::string text;
+};
+
+/*****************************************************************************
+** Class
+*****************************************************************************/
+
+// Producers only move the message into a lock-free queue. A timer in the gui thread drains
+// it in batches into a ring of the last rows, so the memory stays the same however long
+// the session runs. Messages arriving while the queue is full are counted and reported.
+class Log_model : public QAbstractListModel {
+    Q_OBJECT
+public:
+    Log_model(std::size_t row_capacity = 2000, std::size_t queue_capacity = 4096, QObject *parent = 0);
+
+    // any thread
+    void push(int level, const std::string &text);
+
+    // rows below this level stay in the ring but are not shown
+    void set_minimum_level(int level);
+    int minimum_level() const { return shown_level; }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role) const;
+
+Q_SIGNALS:
+    void rowsAppended();
+
+public Q_SLOTS:
+    void drain();
+
+private:
+    struct Row {
+        int level;
+        QString text;
+    };
+
+    void append(std::vector<Log_entry> &batch);
+    const Row &row_at(int row) const { return ring[visible[row] % ring.size()]; }
+
+    Bounded_mpsc_queue<Log_entry> queue;
+    std::atomic<unsigned int> dropped;
+
+    // ring[sequence % size] holds the row with that sequence number
+    std::vector<Row> ring;
+    unsigned long long first_sequence, next_sequence;
+    std::deque<unsigned long long> visible; // sequences of the shown rows, ascending
+    int shown_level;
+
+    QTimer drain_timer;
+};
+
+}  // namespace qtnp
+
+#endif /* qtnp_LOG_MODEL_HPP_ */
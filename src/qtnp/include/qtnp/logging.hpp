@@ -0,0 +1,165 @@
+/**
+ * @file /include/qtnp/logging.hpp
+ *
+ * @brief Leveled logging for the planning code, per subsystem and rate limited
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_LOGGING_HPP_
+#define qtnp_LOGGING_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <ros/ros.h>
+#include <atomic>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/function.hpp>
+
+/*****************************************************************************
+** Build flags
+*****************************************************************************/
+
+// Debug statements are compiled out of release builds (NDEBUG), their arguments are not even
+// evaluated. Define QTNP_LOG_DEBUG_ENABLED to 0 or 1 to override.
+#ifndef QTNP_LOG_DEBUG_ENABLED
+#  ifdef NDEBUG
+#    define QTNP_LOG_DEBUG_ENABLED 0
+#  else
+#    define QTNP_LOG_DEBUG_ENABLED 1
+#  endif
+#endif
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+namespace logging {
+
+/*****************************************************************************
+** Types
+*****************************************************************************/
+
+enum Level { Debug, Info, Warn, Error, Fatal, Off };
+
+enum Subsystem { General, Meshing, Partitioning, Coverage, Path_to_goal, Waypoints, Subsystem_count };
+
+// Summaries (and everything at Warn and above) are also handed to this sink, the qnode
+// installs one that shows them in the gui log
+typedef boost::function<void(Level, const std::string &)> summary_sink;
+
+/*****************************************************************************
+** Interface
+*****************************************************************************/
+
+const char *subsystem_name(Subsystem subsystem);
+const char *level_name(Level level);
+
+// the threshold of every subsystem is Info until configured. Debug lowers the rosconsole
+// logger of the package to debug as well, or rosout would never see the messages
+void set_level(Subsystem subsystem, Level level);
+Level get_level(Subsystem subsystem);
+// reads ~log_levels/<subsystem> ("debug", "info", "warn", "error", "fatal" or "off")
+void configure(ros::NodeHandle &private_n);
+
+void set_summary_sink(summary_sink sink);
+
+// the cheap check the macros do before formatting anything
+bool is_enabled(Subsystem subsystem, Level level);
+
+// to rosout and, for summaries and warnings, to the summary sink
+void write(Subsystem subsystem, Level level, const std::string &message, bool summary);
+
+// Lets one message through per period, one instance per call site. The number of
+// messages dropped in between is added to the next one that passes.
+class Rate_limiter {
+  public:
+    explicit Rate_limiter(double period_seconds);
+
+    bool allow(int &suppressed);
+
+  private:
+    long long period_ns;
+    std::atomic<long long> next_allowed_ns;
+    std::atomic<int> suppressed_count;
+};
+
+// streams a vector as "a b c", e.g. QTNP_DEBUG(Partitioning, "path: [" << join(path) << "]")
+template <class T>
+struct Joined {
+    const std::vector<T> &values;
+};
+
+template <class T>
+Joined<T> join(const std::vector<T> &values){
+    Joined<T> joined = { values };
+    return joined;
+}
+
+template <class T>
+std::ostream &operator<<(std::ostream &out, const Joined<T> &joined){
+    for (std::size_t i = 0; i < joined.values.size(); i++){
+        if (i > 0) out << ' ';
+        out << joined.values[i];
+    }
+    return out;
+}
+
+} // namespace logging
+} // namespace qtnp
+
+/*****************************************************************************
+** Macros
+*****************************************************************************/
+
+#define QTNP_LOG_IMPL(subsystem, level, summary, args) \
+    do { \
+        if (::qtnp::logging::is_enabled(::qtnp::logging::subsystem, ::qtnp::logging::level)) { \
+            std::ostringstream qtnp_log_stream; \
+            qtnp_log_stream << args; \
+            ::qtnp::logging::write(::qtnp::logging::subsystem, ::qtnp::logging::level, qtnp_log_stream.str(), summary); \
+        } \
+    } while (0)
+
+#define QTNP_LOG_THROTTLE_IMPL(subsystem, level, period, args) \
+    do { \
+        if (::qtnp::logging::is_enabled(::qtnp::logging::subsystem, ::qtnp::logging::level)) { \
+            static ::qtnp::logging::Rate_limiter qtnp_log_limiter(period); \
+            int qtnp_log_suppressed(0); \
+            if (qtnp_log_limiter.allow(qtnp_log_suppressed)) { \
+                std::ostringstream qtnp_log_stream; \
+                qtnp_log_stream << args; \
+                if (qtnp_log_suppressed > 0) qtnp_log_stream << " (" << qtnp_log_suppressed << " similar suppressed)"; \
+                ::qtnp::logging::write(::qtnp::logging::subsystem, ::qtnp::logging::level, qtnp_log_stream.str(), false); \
+            } \
+        } \
+    } while (0)
+
+// e.g. QTNP_DEBUG(Partitioning, "moved " << cells << " cells");
+#if QTNP_LOG_DEBUG_ENABLED
+#  define QTNP_DEBUG(subsystem, args) QTNP_LOG_IMPL(subsystem, Debug, false, args)
+#  define QTNP_DEBUG_THROTTLE(subsystem, period, args) QTNP_LOG_THROTTLE_IMPL(subsystem, Debug, period, args)
+#else
+#  define QTNP_DEBUG(subsystem, args) do {} while (0)
+#  define QTNP_DEBUG_THROTTLE(subsystem, period, args) do {} while (0)
+#endif
+
+#define QTNP_INFO(subsystem, args) QTNP_LOG_IMPL(subsystem, Info, false, args)
+#define QTNP_INFO_THROTTLE(subsystem, period, args) QTNP_LOG_THROTTLE_IMPL(subsystem, Info, period, args)
+#define QTNP_WARN(subsystem, args) QTNP_LOG_IMPL(subsystem, Warn, true, args)
+#define QTNP_ERROR(subsystem, args) QTNP_LOG_IMPL(subsystem, Error, true, args)
+
+// one line at the end of a planning step, also shown in the gui log
+#define QTNP_SUMMARY(subsystem, args) QTNP_LOG_IMPL(subsystem, Info, true, args)
+
+#endif /* qtnp_LOGGING_HPP_ */
@@ -16,6 +16,7 @@
 #include <QtGui/QStandardItemModel>
 #include "ui_main_window.h"
 #include "qnode.hpp"
+#include "planning_thread.hpp"
 
 /*****************************************************************************
 ** Namespace
@@ -70,15 +71,23 @@ public Q_SLOTS:
 
     void on_button_save_uas_config_clicked(bool check);
     void on_button_load_last_uas_conf_clicked(bool check);
+    void on_button_cancel_planning_clicked(bool check);
+    void on_combo_log_level_currentIndexChanged(int index);
 
     /******************************************
     ** Manual connections
     *******************************************/
     void updateLoggingView(); // no idea why this can't connect automatically
+    void updatePlanningProgress(QString stage, int done, int total);
+    void planningFinished(QString stage_name, bool completed, QString message);
 
 private:
+    bool start_planning(const QString &stage_name, boost::function<void()> job);
+    void set_planning_buttons_enabled(bool enabled);
+
 	Ui::MainWindowDesign ui;
 	QNode qnode;
+    Planning_thread planning_thread;
 
     QStandardItemModel *model;
     QString kml_filename;
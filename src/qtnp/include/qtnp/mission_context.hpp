@@ -0,0 +1,99 @@
+/**
+ * @file /include/qtnp/mission_context.hpp
+ *
+ * @brief One named mission: its own mesh, partition, paths, publishers and action servers
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_MISSION_CONTEXT_HPP_
+#define qtnp_MISSION_CONTEXT_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <ros/ros.h>
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "mavros_msgs/WaypointList.h"
+#include "qtnp/Coordinates.h"
+
+#include "mission_writer.hpp"
+#include "planning_action_server.hpp"
+#include "rviz_objects.hpp"
+#include "thread_pool.hpp"
+#include "tnp_update.hpp"
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Class
+*****************************************************************************/
+
+// A mission of its own next to the one of the gui, for the areas a ground station plans at
+// the same time. Everything of it lives under missions/<id>/: the rviz topics, the tnp_*
+// action servers and, below the mission directory, its mission files. Its requests run one
+// after the other on the shared planning pool, the requests of different missions in
+// parallel.
+class Mission_context : private boost::noncopyable {
+  public:
+    Mission_context(const std::string &id, Thread_pool &pool);
+    // a running request is cancelled at its next checkpoint and waited for
+    ~Mission_context();
+
+    // letters, digits and underscores, a letter first, so it makes a ros namespace
+    static bool is_valid_id(const std::string &id);
+
+    // the publishers and the action servers; the planning settings are set on planning() before
+    void start(ros::NodeHandle &n, ros::NodeHandle &private_n);
+
+    const std::string &id() const { return mission_id; }
+    Tnp_update &planning(){ return tnp_update; }
+    Mission_writer &writer(){ return mission_writer; }
+    int cell_count(){ return rviz_objects.count_cells(); }
+
+    // a tnp_polygon_def message of this mission, meshed on the pool
+    void mesh_async(const std::vector<Coordinates> &placemarks);
+
+    // publishes what the last request left for rviz and writes the new waypoint lists, which
+    // come back for the upload. True when anything was published
+    bool publish(std::map<int, mavros_msgs::WaypointList> &waypoint_lists);
+
+    // of the mission and its rviz objects, false while a request holds the mission
+    bool memory_usage(size_t &bytes);
+
+  private:
+    void mesh(std::vector<Coordinates> placemarks);
+
+    Thread_pool &pool_ref;
+    std::string mission_id;
+    Rviz_objects rviz_objects;
+    Tnp_update tnp_update;
+    Mission_writer mission_writer;
+
+    // the topic requests; the action servers queue their own and the planning mutex of the
+    // mission keeps the two apart
+    Serial_queue topic_queue;
+    std::atomic<bool> closing;
+    boost::shared_ptr<Planning_action_server> action_server;
+
+    ros::Publisher edges_pub, polygon_pub, triangulation_mesh_pub, center_pub, path_pub;
+};
+
+} // namespace qtnp
+
+#endif /* qtnp_MISSION_CONTEXT_HPP_ */
@@ -0,0 +1,91 @@
+/**
+ * @file /include/qtnp/mission_formats.hpp
+ *
+ * @brief File formats for the exported missions
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_MISSION_FORMATS_HPP_
+#define qtnp_MISSION_FORMATS_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <string>
+#include <boost/shared_ptr.hpp>
+
+#include "mavros_msgs/WaypointList.h"
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Types
+*****************************************************************************/
+
+struct Mission_record {
+    int uas_id;
+    int sequence;       // running number of the missions handed to the writer
+    std::string stamp;  // local time of the hand over, YYYY-MM-DD_HH-MM-SS
+    mavros_msgs::WaypointList waypoint_list;  // waypoint 0 is the home position
+};
+
+/*****************************************************************************
+** Class
+*****************************************************************************/
+
+// A format appends the complete file content to the given buffer, the writer does the io.
+// Formats are stateless, one instance is shared by all writer threads.
+class Mission_format {
+  public:
+    virtual ~Mission_format() {}
+
+    virtual const char *name() const = 0;
+    virtual const char *extension() const = 0;
+    virtual void write(const Mission_record &record, std::string &out) const = 0;
+};
+
+// QGroundControl / Mission Planner waypoint file, "QGC WPL 110"
+class Qgc_wpl_format : public Mission_format {
+  public:
+    const char *name() const { return "wpl"; }
+    const char *extension() const { return ".waypoints"; }
+    void write(const Mission_record &record, std::string &out) const;
+};
+
+// QGroundControl .plan (json), home position plus simple items
+class Qgc_plan_format : public Mission_format {
+  public:
+    const char *name() const { return "plan"; }
+    const char *extension() const { return ".plan"; }
+    void write(const Mission_record &record, std::string &out) const;
+};
+
+// Little endian records for tools and replays:
+// "QTNPMSN1", u32 version, i32 uas id, u32 waypoint count, then per waypoint
+// u8 frame, u16 command, u8 flags (1: current, 2: autocontinue), f32 param1..4,
+// f64 x_lat, f64 y_long, f32 z_alt
+class Binary_mission_format : public Mission_format {
+  public:
+    static const unsigned int version = 1;
+
+    const char *name() const { return "bin"; }
+    const char *extension() const { return ".bin"; }
+    void write(const Mission_record &record, std::string &out) const;
+};
+
+// "wpl", "plan" or "bin", a null pointer for anything else
+boost::shared_ptr<Mission_format> make_mission_format(const std::string &name);
+
+} // namespace qtnp
+
+#endif /* qtnp_MISSION_FORMATS_HPP_ */
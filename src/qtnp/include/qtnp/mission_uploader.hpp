@@ -0,0 +1,89 @@
+/**
+ * @file /include/qtnp/mission_uploader.hpp
+ *
+ * @brief Asynchronous upload of the waypoint lists to the mavros instance of each UAS
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_MISSION_UPLOADER_HPP_
+#define qtnp_MISSION_UPLOADER_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <ros/ros.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "mavros_msgs/WaypointList.h"
+
+#include "thread_pool.hpp"
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Types
+*****************************************************************************/
+
+struct Upload_settings {
+    double service_timeout;  // seconds to wait for the push service of a vehicle, per attempt
+    int retries;             // extra attempts after the first one
+    double retry_delay;      // seconds between attempts
+    std::string namespace_prefix;            // used for vehicles without an explicit namespace: <prefix><id>/mavros
+    std::vector<std::string> mavros_namespaces; // index uas_id - 1, e.g. "/mavros" for a single vehicle
+};
+
+/*****************************************************************************
+** Class
+*****************************************************************************/
+
+// Every list goes out in a single WaypointPush call. Uploads to different vehicles run in
+// parallel on the given pool, uploads to the same vehicle one after the other. The calls block
+// while they wait for the services and between retries, so the pool should be one of its own.
+class Mission_uploader {
+  public:
+    // uas id, success and a message for the operator
+    typedef boost::function<void(int, bool, const std::string &)> result_callback;
+
+    Mission_uploader(Thread_pool &pool);
+    // waits for the uploads still running, retries included
+    ~Mission_uploader();
+
+    // reads the upload_* and mavros_* parameters from the given (private) node handle
+    void configure(ros::NodeHandle &private_n);
+    void set_result_callback(result_callback callback){ on_result = callback; }
+
+    void upload_async(int uas_id, const mavros_msgs::WaypointList &waypoint_list);
+    void upload_all_async(const std::map<int, mavros_msgs::WaypointList> &waypoint_lists);
+
+    std::string mavros_namespace(int uas_id);
+
+  private:
+    void upload(int uas_id, mavros_msgs::WaypointList waypoint_list);
+    Serial_queue &vehicle_queue(int uas_id);
+
+    Thread_pool &pool_ref;
+    Upload_settings settings;
+    result_callback on_result;
+
+    boost::mutex queues_mutex;
+    std::map<int, boost::shared_ptr<Serial_queue> > vehicle_queues;
+};
+
+} // namespace qtnp
+
+#endif /* qtnp_MISSION_UPLOADER_HPP_ */
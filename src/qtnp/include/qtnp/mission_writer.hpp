@@ -0,0 +1,91 @@
+/**
+ * @file /include/qtnp/mission_writer.hpp
+ *
+ * @brief Writes the produced missions to disk in the background
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_MISSION_WRITER_HPP_
+#define qtnp_MISSION_WRITER_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <ros/ros.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "mavros_msgs/WaypointList.h"
+
+#include "mission_formats.hpp"
+#include "thread_pool.hpp"
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Class
+*****************************************************************************/
+
+// Every mission is written once per configured format, to
+// <directory>/mission_uas<id>_<stamp>_<sequence><extension>. The missions of different
+// vehicles are written in parallel on the planning pool, each file through a temporary
+// file and a rename, so readers never see half a mission.
+class Mission_writer {
+  public:
+    // uas id, success and a message for the operator
+    typedef boost::function<void(int, bool, const std::string &)> result_callback;
+
+    Mission_writer(Thread_pool &pool);
+    // waits for the files still being written
+    ~Mission_writer();
+
+    // reads ~write_missions, ~mission_directory and ~mission_formats (list of "wpl", "plan", "bin")
+    void configure(ros::NodeHandle &private_n);
+    void set_result_callback(result_callback callback){ on_result = callback; }
+
+    void set_directory(const std::string &directory);
+    std::string directory();
+    void add_format(boost::shared_ptr<Mission_format> format);
+    void clear_formats();
+    bool is_enabled();
+
+    void write_async(int uas_id, const mavros_msgs::WaypointList &waypoint_list);
+    void write_all_async(const std::map<int, mavros_msgs::WaypointList> &waypoint_lists);
+
+  private:
+    typedef std::vector<boost::shared_ptr<Mission_format> > format_list;
+
+    void write(Mission_record record, format_list formats, std::string directory);
+    Serial_queue &vehicle_queue(int uas_id);
+
+    Thread_pool &pool_ref;
+    result_callback on_result;
+
+    // the settings are copied into every job, so configure() may run while files are written
+    boost::mutex settings_mutex;
+    bool enabled;
+    std::string mission_directory;
+    format_list formats;
+    int sequence;
+
+    boost::mutex queues_mutex;
+    std::map<int, boost::shared_ptr<Serial_queue> > vehicle_queues;
+};
+
+} // namespace qtnp
+
+#endif /* qtnp_MISSION_WRITER_HPP_ */
@@ -0,0 +1,109 @@
+/**
+ * @file /include/qtnp/mpsc_queue.hpp
+ *
+ * @brief Bounded lock-free queue, many producers and one consumer
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_MPSC_QUEUE_HPP_
+#define qtnp_MPSC_QUEUE_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Class
+*****************************************************************************/
+
+// Array of slots with a sequence number each (Vyukov's bounded queue). A producer claims a
+// slot with one compare and swap on the tail, writes the value and publishes it through the
+// slot sequence; nobody ever waits on a lock. A full queue rejects the value instead of
+// growing, the caller decides what to do with it.
+template <class T>
+class Bounded_mpsc_queue {
+  public:
+    // rounded up to a power of two
+    explicit Bounded_mpsc_queue(std::size_t capacity) :
+        slots(power_of_two(capacity)),
+        mask(slots.size() - 1),
+        head(0),
+        tail(0)
+    {
+        for (std::size_t i = 0; i < slots.size(); i++) slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // any thread
+    bool try_push(T &&value){
+        std::size_t position = tail.load(std::memory_order_relaxed);
+        for (;;){
+            Slot &slot = slots[position & mask];
+            std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t difference = (std::ptrdiff_t) sequence - (std::ptrdiff_t) position;
+            if (difference == 0){
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)){
+                    slot.value = std::move(value);
+                    slot.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0){
+                return false; // full
+            } else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // the consumer thread only
+    bool try_pop(T &value){
+        Slot &slot = slots[head & mask];
+        std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != head + 1) return false; // empty, or the producer is still writing
+        value = std::move(slot.value);
+        slot.sequence.store(head + mask + 1, std::memory_order_release);
+        head++;
+        return true;
+    }
+
+    std::size_t capacity() const { return mask + 1; }
+
+  private:
+    struct Slot {
+        std::atomic<std::size_t> sequence;
+        T value;
+
+        Slot() : sequence(0) {}
+    };
+
+    static std::size_t power_of_two(std::size_t capacity){
+        std::size_t size = 2;
+        while (size < capacity) size <<= 1;
+        return size;
+    }
+
+    std::vector<Slot> slots;
+    std::size_t mask;
+    std::size_t head; // consumer side only
+    char padding[64];  // keeps the producers' tail off the consumer's cache line
+    std::atomic<std::size_t> tail;
+};
+
+} // namespace qtnp
+
+#endif /* qtnp_MPSC_QUEUE_HPP_ */
@@ -0,0 +1,92 @@
+/**
+ * @file /include/qtnp/multilevel_partitioner.hpp
+ *
+ * @brief Multilevel k-way partitioning of the cell graph
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_MULTILEVEL_PARTITIONER_HPP_
+#define qtnp_MULTILEVEL_PARTITIONER_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <vector>
+
+#include "planning_control.hpp"
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Types
+*****************************************************************************/
+
+// compressed adjacency lists: the neighbours of v are adjncy[xadj[v]] to adjncy[xadj[v+1] - 1]
+struct Partition_graph {
+    std::vector<int> xadj;
+    std::vector<int> adjncy;
+    std::vector<int> adjwgt;  // weight of each of those edges
+    std::vector<int> vwgt;    // weight of each vertex
+
+    int size() const { return (int) vwgt.size(); }
+};
+
+/*****************************************************************************
+** Class
+*****************************************************************************/
+
+// In the way of METIS: the graph is coarsened by heavy edge matching until it is a few
+// vertices per part, the coarsest graph is grown into parts from the pinned vertices, and
+// on the way back up every level is refined with greedy boundary moves (the k-way variant
+// of FM/KL). Where that stalls, with the pins close together, weight is handed along chains
+// of neighbouring parts until every part is within the tolerance of its target. The parts
+// come out connected: neither step splits a part, and a piece the growing left apart is
+// handed to the part around it.
+class Multilevel_partitioner {
+  public:
+    Multilevel_partitioner(Planning_control &control) : planning_control(control), imbalance_reached(0) {}
+
+    // the part of every vertex, 0 to targets.size() - 1. targets are the shares of the total
+    // vertex weight, normalized here; pinned[p] is a vertex that stays in part p, -1 for none
+    std::vector<int> partition(const Partition_graph &graph, const std::vector<double> &targets,
+                               const std::vector<int> &pinned);
+
+    // evens a given partition out towards the targets with boundary moves on the graph itself,
+    // e.g. one from another partitioner; the parts stay connected. Vertices of part -1 stay out
+    void balance(const Partition_graph &graph, const std::vector<double> &targets, const std::vector<int> &pinned,
+                 std::vector<int> &part, int passes);
+
+    // of the last partition or balance: the largest deviation from a target weight relative to it.
+    // Within a few percent unless a part is walled in, e.g. by the corridors of the parts around
+    // a tight cluster of pins
+    double imbalance() const { return imbalance_reached; }
+
+  private:
+    void set_targets(const Partition_graph &graph, const std::vector<double> &targets, const std::vector<int> &pinned,
+                     std::vector<int> &pin);
+    void coarsen(const Partition_graph &fine, const std::vector<int> &fine_pin, int max_vertex_weight,
+                 Partition_graph &coarse, std::vector<int> &coarse_of, std::vector<int> &coarse_pin);
+    void grow(const Partition_graph &graph, const std::vector<int> &pin, std::vector<int> &part);
+    void refine(const Partition_graph &graph, const std::vector<int> &pin, std::vector<int> &part, int passes);
+    void reconnect(const Partition_graph &graph, const std::vector<int> &pin, std::vector<int> &part);
+    void settle(const Partition_graph &graph, const std::vector<int> &pin, std::vector<int> &part);
+
+    Planning_control &planning_control;
+    int parts;
+    std::vector<double> target_weight, allowed_weight, least_weight;
+    double imbalance_reached;
+};
+
+} // namespace qtnp
+
+#endif /* qtnp_MULTILEVEL_PARTITIONER_HPP_ */
@@ -0,0 +1,129 @@
+/**
+ * @file /include/qtnp/planning_action_server.hpp
+ *
+ * @brief Actionlib servers for meshing, hole editing, partitioning, repartitioning, coverage and go to goal
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_PLANNING_ACTION_SERVER_HPP_
+#define qtnp_PLANNING_ACTION_SERVER_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <ros/ros.h>
+#include <actionlib/server/simple_action_server.h>
+#include <boost/thread/mutex.hpp>
+
+#include "qtnp/MeshAction.h"
+#include "qtnp/PartitionAction.h"
+#include "qtnp/CoverageAction.h"
+#include "qtnp/GoToGoalAction.h"
+#include "qtnp/EditHoleAction.h"
+#include "qtnp/RepartitionAction.h"
+
+#include "rviz_objects.hpp"
+#include "tnp_update.hpp"
+#include "thread_pool.hpp"
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Class
+*****************************************************************************/
+
+// Every server waits in its own actionlib thread while the planning itself runs on the
+// planning pool, one request at a time. Every request is a Tnp_update::Planning_job with a
+// control of its own: its progress is streamed as feedback, and a preempt (or a newer goal)
+// cancels it, and only it, at the next planning checkpoint.
+class Planning_action_server {
+  public:
+    Planning_action_server(ros::NodeHandle &n, Tnp_update &tnpReference, Rviz_objects &rvizReference, Thread_pool &pool);
+    ~Planning_action_server();
+
+  private:
+    typedef actionlib::SimpleActionServer<MeshAction> Mesh_server;
+    typedef actionlib::SimpleActionServer<PartitionAction> Partition_server;
+    typedef actionlib::SimpleActionServer<CoverageAction> Coverage_server;
+    typedef actionlib::SimpleActionServer<GoToGoalAction> Go_to_goal_server;
+    typedef actionlib::SimpleActionServer<EditHoleAction> Edit_hole_server;
+    typedef actionlib::SimpleActionServer<RepartitionAction> Repartition_server;
+
+    enum Request_kind { NONE, MESH, PARTITION, COVERAGE, GO_TO_GOAL, EDIT_HOLE, REPARTITION };
+    enum Outcome { COMPLETED, CANCELLED, FAILED };
+
+    void execute_mesh(const MeshGoalConstPtr &goal);
+    void execute_partition(const PartitionGoalConstPtr &goal);
+    void execute_coverage(const CoverageGoalConstPtr &goal);
+    void execute_go_to_goal(const GoToGoalGoalConstPtr &goal);
+    void execute_edit_hole(const EditHoleGoalConstPtr &goal);
+    void execute_repartition(const RepartitionGoalConstPtr &goal);
+
+    typedef boost::function<void(Tnp_update::Planning_job &)> job_type;
+
+    void mesh_job(const MeshGoalConstPtr &goal, MeshResult &result, Tnp_update::Planning_job &job);
+    void partition_job(const PartitionGoalConstPtr &goal, PartitionResult &result, Tnp_update::Planning_job &job);
+    void coverage_job(const CoverageGoalConstPtr &goal, CoverageResult &result, Tnp_update::Planning_job &job);
+    void go_to_goal_job(const GoToGoalGoalConstPtr &goal, GoToGoalResult &result, Tnp_update::Planning_job &job);
+    void edit_hole_job(const EditHoleGoalConstPtr &goal, EditHoleResult &result, Tnp_update::Planning_job &job);
+    void repartition_job(const RepartitionGoalConstPtr &goal, RepartitionResult &result, Tnp_update::Planning_job &job);
+
+    // the waiting actionlib thread and the pool job that signals it
+    struct Completion;
+
+    Outcome run_on_pool(Request_kind kind, job_type job, boost::function<bool()> preempt_requested,
+                        Planning_control::progress_callback feedback, std::string &message);
+    void run_request(Request_kind kind, job_type job, boost::function<bool()> preempt_requested,
+                     Planning_control::progress_callback feedback, Completion *completion);
+    void preempt(Request_kind kind);
+
+    template <class Server, class Feedback>
+    void publish_feedback(Server *server, const std::string &stage, int done, int total){
+        Feedback feedback;
+        feedback.stage = stage;
+        feedback.done = done;
+        feedback.total = total;
+        server->publishFeedback(feedback);
+    }
+
+    template <class Server, class Result>
+    void finish(Server &server, const Result &result, Outcome outcome, const std::string &message){
+        switch (outcome){
+            case COMPLETED: server.setSucceeded(result); break;
+            case CANCELLED: server.setPreempted(result, message); break;
+            default: server.setAborted(result, message); break;
+        }
+    }
+
+    Tnp_update &tnp_update_ref;
+    Rviz_objects &rviz_objects_ref;
+
+    // all requests share the Tnp_update, so they queue up behind each other
+    Serial_queue planning_queue;
+    // the request on the pool and its control, for the preempts and the shutdown
+    boost::mutex running_mutex;
+    bool shutting_down;
+    Request_kind running_kind;
+    Planning_control *running_control;
+
+    Mesh_server mesh_server;
+    Partition_server partition_server;
+    Coverage_server coverage_server;
+    Go_to_goal_server go_to_goal_server;
+    Edit_hole_server edit_hole_server;
+    Repartition_server repartition_server;
+};
+
+} // namespace qtnp
+
+#endif /* qtnp_PLANNING_ACTION_SERVER_HPP_ */
@@ -0,0 +1,120 @@
+/**
+ * @file /include/qtnp/planning_control.hpp
+ *
+ * @brief Progress reporting and cooperative cancellation of planning runs
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_PLANNING_CONTROL_HPP_
+#define qtnp_PLANNING_CONTROL_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <atomic>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Types
+*****************************************************************************/
+
+// thrown from a checkpoint when the running operation has been asked to stop.
+// It unwinds the planning loops, the caller decides what to tell the operator.
+class Planning_cancelled : public std::runtime_error {
+  public:
+    explicit Planning_cancelled(const std::string &stage) :
+        std::runtime_error("Planning cancelled during: " + stage), stage_name(stage) {}
+    virtual ~Planning_cancelled() throw() {}
+
+    const std::string &stage() const { return stage_name; }
+
+  private:
+    std::string stage_name;
+};
+
+/*****************************************************************************
+** Class
+*****************************************************************************/
+
+// One per planning job, owned by whoever started it (see Tnp_update::Planning_job), so a
+// cancel or the progress of one job never reaches another. The loops of Tnp_update call
+// checkpoint(), which costs a few relaxed atomic loads while nothing changes, forwards
+// progress only when the per mille moves and throws Planning_cancelled once a cancel was requested.
+class Planning_control {
+  public:
+    // total == 0 means the amount of work is not known in advance (e.g. meshing)
+    typedef boost::function<void(const std::string &stage, int done, int total)> progress_callback;
+
+    Planning_control() : cancel_requested(false), last_stage(0), last_permille(-1), last_done(0), next_listener_id(0) {}
+
+    // the returned id removes the listener
+    int add_progress_listener(progress_callback callback){
+        boost::lock_guard<boost::mutex> lock(callback_mutex);
+        listeners[next_listener_id] = callback;
+        return next_listener_id++;
+    }
+
+    void remove_progress_listener(int listener_id){
+        boost::lock_guard<boost::mutex> lock(callback_mutex);
+        listeners.erase(listener_id);
+    }
+
+    void request_cancel(){ cancel_requested.store(true); }
+    bool is_cancel_requested() const { return cancel_requested.load(); }
+
+    // stage is expected to be a string literal, it is compared by address
+    void checkpoint(const char *stage, int done, int total){
+
+        if (cancel_requested.load(std::memory_order_relaxed)) throw Planning_cancelled(stage);
+
+        // only forward when something visible changes, the GUI doesn't need every cell
+        int permille = (total > 0) ? (int)((1000.0 * done) / total) : -1;
+        if (last_stage.load(std::memory_order_relaxed) == stage){
+            if (total > 0 && permille == last_permille.load(std::memory_order_relaxed)) return;
+            int previous = last_done.load(std::memory_order_relaxed);
+            if (total <= 0 && done >= previous && (done - previous) < unknown_total_step) return;
+        }
+
+        boost::lock_guard<boost::mutex> lock(callback_mutex);
+        last_stage.store(stage);
+        last_permille.store(permille);
+        last_done.store(done);
+        std::string stage_name(stage);
+        for (std::map<int, progress_callback>::iterator it = listeners.begin(); it != listeners.end(); it++){
+            it->second(stage_name, done, total);
+        }
+    }
+
+  private:
+    static const int unknown_total_step = 500;
+
+    std::atomic<bool> cancel_requested;
+    std::atomic<const char*> last_stage;
+    std::atomic<int> last_permille;
+    std::atomic<int> last_done;
+
+    boost::mutex callback_mutex;
+    std::map<int, progress_callback> listeners;
+    int next_listener_id;
+};
+
+} // namespace qtnp
+
+#endif /* qtnp_PLANNING_CONTROL_HPP_ */
@@ -0,0 +1,71 @@
+/**
+ * @file /include/qtnp/planning_thread.hpp
+ *
+ * @brief Runs the long planning operations away from the gui thread
+ *
+ * @date October 2026
+ **/
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_PLANNING_THREAD_HPP_
+#define qtnp_PLANNING_THREAD_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <QThread>
+#include <QMutex>
+#include <QString>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "tnp_update.hpp"
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Class
+*****************************************************************************/
+
+// One job at a time: the gui gathers the inputs, hands a bound Tnp_update call here and
+// gets progress and the outcome back through (queued) signals. Every job runs with a control
+// of its own, the action servers and the topics never see its progress or its cancel.
+class Planning_thread : public QThread {
+    Q_OBJECT
+public:
+    Planning_thread(Tnp_update &tnpReference, QObject *parent = 0);
+    virtual ~Planning_thread();
+
+    // returns false if another job is still running
+    bool submit(const QString &stage_name, boost::function<void()> job);
+    void cancel();
+    bool is_busy();
+
+    void run();
+
+Q_SIGNALS:
+    void progressUpdated(QString stage, int done, int total);
+    void planningFinished(QString stage_name, bool completed, QString message);
+
+private:
+    void on_progress(const std::string &stage, int done, int total);
+
+    Tnp_update &tnp_update_ref;
+
+    QMutex job_mutex;
+    QString job_name;
+    boost::function<void()> job;
+    boost::shared_ptr<Planning_control> job_control;
+    bool busy;
+};
+
+}  // namespace qtnp
+
+#endif /* qtnp_PLANNING_THREAD_HPP_ */
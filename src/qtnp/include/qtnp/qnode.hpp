@@ -21,11 +21,20 @@
 #include <ros/ros.h>
 #include <string>
 #include <QThread>
-#include <QStringListModel>
 #include <QString>
+#include <boost/shared_ptr.hpp>
 
+#include "log_model.hpp"
 #include "rviz_objects.hpp"
 #include "tnp_update.hpp"
+#include "telemetry_listener.hpp"
+#include "thread_pool.hpp"
+#include "planning_action_server.hpp"
+#include "mission_uploader.hpp"
+#include "mission_context.hpp"
+#include "mission_writer.hpp"
+#include "session_snapshot.hpp"
+#include "logging.hpp"
 
 /*****************************************************************************
 ** Namespaces
@@ -47,6 +56,19 @@ public:
 	void run();
 
     void init_publishers(ros::NodeHandle n);
+    void init_action_servers(ros::NodeHandle n);
+    void init_mission_upload();
+    void init_mission_export();
+    void init_logging();
+    // the planning settings, of the gui mission and of every mission started later
+    void init_planning(Tnp_update &update);
+    void init_mesh_projection(Tnp_update &update);
+    void init_partition_weight(Tnp_update &update);
+    void init_path_options(Tnp_update &update);
+    void init_terrain(Tnp_update &update);
+    void init_missions();
+    void init_session_snapshot();
+    void init_telemetry();
 
     Tnp_update *get_tnp_update_pointer(){ return &tnp_update; }
     Rviz_objects *get_rviz_objects_pointer(){ return &rviz_objects; }
@@ -62,25 +84,53 @@ public:
 	         Fatal
 	 };
 
-	QStringListModel* loggingModel() { return &logging_model; }
+	Log_model* loggingModel() { return &logging_model; }
 	void log( const LogLevel &level, const std::string &msg);
+    void log_upload_result(int uas_id, bool success, const std::string &msg);
+    void log_export_result(int uas_id, bool success, const std::string &msg);
+    void log_snapshot_result(bool success, const std::string &msg);
+    // planning summaries and warnings, already on rosout
+    void log_summary(logging::Level level, const std::string &msg);
 
 Q_SIGNALS:
 	void loggingUpdated();
     void rosShutdown();
 
 private:
+    void append_log_row(const LogLevel &level, const std::string &msg);
+    // the gui mission without a mission id, else the mission of that id, started on first use
+    void polygon_def_callback(const Placemarks::ConstPtr &msg);
+    boost::shared_ptr<Mission_context> find_or_start_mission(const std::string &id);
+    void log_memory_usage(const std::string &mission, int cells, size_t bytes);
+
 	int init_argc;
 	char** init_argv;
 
     Rviz_objects rviz_objects;
     Tnp_update tnp_update;
 
+    // declared before the action servers, they wait for their pool jobs when destroyed
+    Thread_pool planning_pool;
+    boost::shared_ptr<Planning_action_server> action_server;
+    // the uploads wait on the mavros services and between retries, not on the planning threads
+    Thread_pool upload_pool;
+    Mission_uploader mission_uploader;
+    Mission_writer mission_writer;
+    Session_snapshot session_snapshot;
+    // the last snapshot is restored once, on the first init()
+    bool session_restored;
+    // by id; only the ros thread of run() starts and looks at them, they go after it stopped
+    std::map<std::string, boost::shared_ptr<Mission_context> > missions;
+    int max_missions;
+    // after tnp_update, it stops feeding it before it goes
+    Telemetry_listener telemetry_listener;
+    bool upload_missions;
+
     ros::Publisher chatter_publisher, edges_pub, polygon_pub, triangulation_mesh_pub, center_pub, path_pub;
     ros::Subscriber home_spot_sub, polygon_def_sub;
-    ros::ServiceClient waypoints_s_client;
 
-    QStringListModel logging_model;
+    // bounded, filled by a timer in the gui thread; log() itself may be called from any thread
+    Log_model logging_model;
 };
 
 }  // namespace qtnp
@@ -101,6 +101,13 @@ public:
     }
 
     int count_cells(){ return center_points.points.size(); }
+    // what the markers and the path hold on to, capacity included
+    size_t memory_bytes(){
+        return (edges.points.capacity() + center_points.points.capacity() + triangulation_mesh.points.capacity()) *
+                   sizeof(geometry_msgs::Point) + triangulation_mesh.colors.capacity() * sizeof(std_msgs::ColorRGBA) +
+               polygon.points.capacity() * sizeof(geometry_msgs::Point32) + path.poses.capacity() * sizeof(geometry_msgs::PoseStamped) +
+               center_points_with_cell_id.capacity() * sizeof(std::pair<int, geometry_msgs::Point>);
+    }
     void set_polygon_ready (bool option){ polygon_ready = option; }
     void set_planning_ready (bool option){ planning_ready = option; }
 
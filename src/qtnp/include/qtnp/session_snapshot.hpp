@@ -0,0 +1,197 @@
+/**
+ * @file /include/qtnp/session_snapshot.hpp
+ *
+ * @brief The planning session in one versioned, checksummed binary file
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_SESSION_SNAPSHOT_HPP_
+#define qtnp_SESSION_SNAPSHOT_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <ros/ros.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "thread_pool.hpp"
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Sections
+*****************************************************************************/
+
+// four characters, e.g. snapshot_tag("CELL")
+inline uint32_t snapshot_tag(const char *name){
+    return (uint32_t) (unsigned char) name[0] | ((uint32_t) (unsigned char) name[1] << 8) |
+           ((uint32_t) (unsigned char) name[2] << 16) | ((uint32_t) (unsigned char) name[3] << 24);
+}
+
+uint32_t crc32(const void *data, size_t size);
+
+// Plain values and arrays of them, back to back in the byte order of the host (the file
+// records it and isn't read on a host of the other order)
+class Snapshot_buffer {
+  public:
+    template <class T> void put(const T &value){
+        bytes.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+    // the count first, as a uint64_t
+    template <class T> void put_array(const std::vector<T> &values){
+        put((uint64_t) values.size());
+        if (!values.empty()) bytes.append(reinterpret_cast<const char *>(&values[0]), values.size() * sizeof(T));
+    }
+    void put_bytes(const std::string &more){
+        put((uint64_t) more.size());
+        bytes.append(more);
+    }
+
+    const std::string &data() const { return bytes; }
+
+  private:
+    std::string bytes;
+};
+
+// reads back what a Snapshot_buffer holds; every get is false, and the cursor stays put,
+// past the end of the section
+class Snapshot_cursor {
+  public:
+    Snapshot_cursor(const unsigned char *data, size_t size) : at(data), end(data + size) {}
+
+    template <class T> bool get(T &value){
+        if (end - at < (ptrdiff_t) sizeof(T)) return false;
+        std::memcpy(&value, at, sizeof(T));
+        at += sizeof(T);
+        return true;
+    }
+    template <class T> bool get_array(std::vector<T> &values){
+        uint64_t count;
+        const unsigned char *start = at;
+        if (!get(count) || (count > (uint64_t) (end - at) / sizeof(T))){
+            at = start;
+            return false;
+        }
+        values.resize(count);
+        if (count > 0) std::memcpy(&values[0], at, count * sizeof(T));
+        at += count * sizeof(T);
+        return true;
+    }
+    bool get_bytes(std::string &more){
+        uint64_t count;
+        const unsigned char *start = at;
+        if (!get(count) || (count > (uint64_t) (end - at))){
+            at = start;
+            return false;
+        }
+        more.assign(reinterpret_cast<const char *>(at), count);
+        at += count;
+        return true;
+    }
+    bool at_end() const { return at == end; }
+
+  private:
+    const unsigned char *at, *end;
+};
+
+/*****************************************************************************
+** Files
+*****************************************************************************/
+
+// The file is a header (magic, format version, byte order, section count), a table of
+// sections (tag, offset, size, CRC-32), and the sections themselves, each starting on an
+// 8 byte boundary so that an array in it can be read in place from the mapped file.
+// A CRC-32 over the header and the table comes last in the header.
+class Snapshot_file {
+  public:
+    void add(uint32_t tag, const Snapshot_buffer &section){ sections[tag] = section.data(); }
+    void add(uint32_t tag, const std::string &section){ sections[tag] = section; }
+    // the whole file
+    std::string bytes() const;
+
+  private:
+    std::map<uint32_t, std::string> sections;
+};
+
+// The file mapped read only; open() checks the header, the table and every section against
+// its checksum before anything is used
+class Snapshot_reader : private boost::noncopyable {
+  public:
+    Snapshot_reader() : data(NULL), data_size(0) {}
+    ~Snapshot_reader(){ close(); }
+
+    bool open(const std::string &path, std::string &error);
+    void close();
+
+    bool has(uint32_t tag) const { return sections.count(tag) > 0; }
+    // a cursor over the section, an empty one if there is no such section
+    Snapshot_cursor section(uint32_t tag) const;
+
+  private:
+    const unsigned char *data;
+    size_t data_size;
+    std::map<uint32_t, std::pair<size_t, size_t> > sections;  // offset, size
+};
+
+/*****************************************************************************
+** Class
+*****************************************************************************/
+
+// Where the session is kept and the writing of it. A snapshot is written through a temporary
+// file, synced and renamed over the last one, so a crash at any point leaves a whole file
+// behind. The writes run on the pool one after the other, a later snapshot never loses to
+// an older one. The file is put together into bytes and checksummed on the pool as well,
+// the caller only hands over its sections.
+class Session_snapshot {
+  public:
+    // success and a message for the operator
+    typedef boost::function<void(bool, const std::string &)> result_callback;
+
+    explicit Session_snapshot(Thread_pool &pool);
+    // waits for a snapshot still being written
+    ~Session_snapshot(){ queue.wait_idle(); }
+
+    // reads ~session_snapshot (on by default) and ~session_snapshot_path
+    void configure(ros::NodeHandle &private_n);
+    void set_result_callback(result_callback callback){ on_result = callback; }
+
+    bool is_enabled();
+    std::string path();
+
+    // the file is not touched after this
+    void write_async(boost::shared_ptr<const Snapshot_file> file);
+
+  private:
+    void write(boost::shared_ptr<const Snapshot_file> file, std::string target);
+
+    Serial_queue queue;
+    result_callback on_result;
+
+    boost::mutex settings_mutex;
+    bool enabled;
+    std::string snapshot_path;
+};
+
+} // namespace qtnp
+
+#endif /* qtnp_SESSION_SNAPSHOT_HPP_ */
@@ -0,0 +1,88 @@
+/**
+ * @file /include/qtnp/sizing_field.hpp
+ *
+ * @brief The cell size wanted at any point of the mesh, graded away from attractors
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_SIZING_FIELD_HPP_
+#define qtnp_SIZING_FIELD_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <vector>
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Class
+*****************************************************************************/
+
+// Attractors with a target size each: points (launch sites, points of interest), polylines
+// (hole outlines) and polygons (the size holds inside). Away from an attractor the size
+// grows by grading times the distance, up to the background size:
+//
+//   size(p) = min(background, min_i(size_i + grading * distance(p, attractor_i)))
+//
+// All in mesh units. A bucket grid over the area lists, for every bucket, the attractors
+// that can be below the background in it, so a lookup only visits those few.
+class Sizing_field {
+  public:
+    Sizing_field();
+
+    void add_point(double x, double y, double size);
+    // open, the last point is not joined to the first
+    void add_polyline(const std::vector<double> &x, const std::vector<double> &y, double size);
+    void add_polygon(const std::vector<double> &x, const std::vector<double> &y, double size);
+
+    // sets up the lookup over the box where sizes are asked for; a background of 0 means no
+    // bound away from the attractors
+    void build(double grading, double background, double min_x, double min_y, double max_x, double max_y);
+
+    bool empty() const { return segments.empty(); }
+    int attractor_count() const { return attractors; }
+    double smallest_size() const;
+    double background_size() const { return background; }
+
+    // outside the box the lookup may give a larger size than the formula, never a smaller one
+    double size_at(double x, double y) const;
+
+  private:
+    struct Segment {
+        double ax, ay, bx, by, size;
+    };
+    struct Polygon {
+        std::vector<double> x, y;
+        double size;
+        double min_x, min_y, max_x, max_y;
+    };
+
+    int bucket_of(double x, double y) const;
+    static bool is_inside(const Polygon &polygon, double x, double y);
+
+    std::vector<Segment> segments;
+    std::vector<Polygon> polygons;
+    int attractors;
+    double grading, background;
+
+    // buckets row by row; the attractors of bucket b are entries[first[b]] to entries[first[b+1]-1]
+    double grid_x, grid_y, bucket_size;
+    int columns, rows;
+    std::vector<int> segment_first, segment_entries;
+    std::vector<int> polygon_first, polygon_entries;
+};
+
+} // namespace qtnp
+
+#endif /* qtnp_SIZING_FIELD_HPP_ */
@@ -0,0 +1,73 @@
+/**
+ * @file /include/qtnp/telemetry_listener.hpp
+ *
+ * @brief Position fixes of the vehicles in, coverage progress out
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_TELEMETRY_LISTENER_HPP_
+#define qtnp_TELEMETRY_LISTENER_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "sensor_msgs/NavSatFix.h"
+
+#include "tnp_update.hpp"
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Class
+*****************************************************************************/
+
+// Subscribes to <mavros namespace>/global_position/global of every vehicle and publishes
+// tnp_coverage_progress. The fixes have their own callback queue and spinner thread, the
+// 1 Hz spin of the qnode would leave them waiting.
+class Telemetry_listener {
+  public:
+    // the mavros namespace of a uas id
+    typedef boost::function<std::string(int)> namespace_resolver;
+
+    Telemetry_listener(Tnp_update &tnpReference);
+    ~Telemetry_listener();
+
+    // reads ~track_telemetry, ~telemetry_uas_count and ~coverage_progress_rate, once
+    void start(ros::NodeHandle &private_n, namespace_resolver mavros_namespace);
+
+  private:
+    void fix_callback(int uas_id, const sensor_msgs::NavSatFix::ConstPtr &fix);
+    void publish_progress(const ros::WallTimerEvent &event);
+
+    Tnp_update &tnp_update_ref;
+
+    ros::CallbackQueue telemetry_queue;
+    boost::shared_ptr<ros::AsyncSpinner> spinner;
+    std::vector<ros::Subscriber> fix_subs;
+    ros::Publisher progress_pub;
+    ros::WallTimer progress_timer;
+
+    std::atomic<int> fixes, fixes_skipped;
+};
+
+} // namespace qtnp
+
+#endif /* qtnp_TELEMETRY_LISTENER_HPP_ */
@@ -0,0 +1,86 @@
+/**
+ * @file /include/qtnp/terrain_model.hpp
+ *
+ * @brief Ground elevation from a memory mapped raster, sampled in batches
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_TERRAIN_MODEL_HPP_
+#define qtnp_TERRAIN_MODEL_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <stddef.h>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Class
+*****************************************************************************/
+
+// The raster is an ESRI GridFloat (what gdal_translate -of EHdr writes): a .flt of 32 bit
+// floats, north row first, and a .hdr with ncols, nrows, xllcorner/xllcenter,
+// yllcorner/yllcenter, cellsize, NODATA_value and byteorder, in degrees of lon (x) and
+// lat (y). The .flt is mapped, not read: only the pages of the tiles looked at are ever
+// loaded. A tile is a square of posts copied out of the map with the byte order and the
+// no data posts sorted out, one post wider than its step so that a bilinear sample never
+// needs two tiles; the most recently used ones are kept.
+class Terrain_model : private boost::noncopyable {
+  public:
+    Terrain_model();
+    ~Terrain_model();
+
+    // path of the .flt or the .hdr, the other one next to it; false with the reason otherwise,
+    // the model is then empty
+    bool load(const std::string &path, std::string &error);
+    void unload();
+    bool is_loaded();
+
+    // metres above sea level at each point, bilinear between the posts; NaN outside the
+    // raster or where all four posts around the point are no data. Any thread
+    void sample(const double *lat, const double *lon, int count, double *elevation);
+    double sample(double lat, double lon);
+
+  private:
+    struct Tile {
+        std::vector<float> posts;  // tile_posts x tile_posts, NaN for no data
+        std::list<int>::iterator used;
+    };
+
+    void clear();
+    const Tile &tile(int key);
+    void copy_posts(int column, int row, int count, float *out) const;
+
+    boost::mutex mutex;
+    const unsigned char *data;
+    size_t data_size;
+    int columns, rows, tile_columns;
+    double west, north, cell_size;  // the outer edges of the raster, degrees
+    float no_data;
+    bool swap_bytes;
+
+    std::map<int, Tile> tiles;
+    std::list<int> recently_used;  // tile keys, the most recent first
+};
+
+} // namespace qtnp
+
+#endif /* qtnp_TERRAIN_MODEL_HPP_ */
@@ -0,0 +1,91 @@
+/**
+ * @file /include/qtnp/thread_pool.hpp
+ *
+ * @brief Planning thread pool and serial job queues on top of it
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_THREAD_POOL_HPP_
+#define qtnp_THREAD_POOL_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <deque>
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Class
+*****************************************************************************/
+
+class Thread_pool {
+  public:
+    typedef boost::function<void()> job_type;
+
+    // 0 threads means one per hardware thread
+    explicit Thread_pool(int thread_count = 0);
+    ~Thread_pool();
+
+    // fire and forget, exceptions escaping the job are reported and swallowed
+    void post(const job_type &job);
+
+    // runs all jobs in parallel and returns when every one of them has finished. The calling
+    // thread works on the batch as well, so it is safe to call from inside a pool job.
+    // The first exception thrown by a job is rethrown here.
+    void run_all(const std::vector<job_type> &batch_jobs);
+
+    int size() const { return thread_count; }
+
+  private:
+    void worker();
+
+    int thread_count;
+    bool stopping;
+    std::deque<job_type> jobs;
+    boost::mutex queue_mutex;
+    boost::condition_variable queue_condition;
+    boost::thread_group threads;
+};
+
+// Jobs posted to a serial queue run one after the other, in posting order, on the threads of
+// the pool. Different queues run in parallel.
+class Serial_queue {
+  public:
+    typedef Thread_pool::job_type job_type;
+
+    explicit Serial_queue(Thread_pool &poolReference) : pool_ref(poolReference), draining(false) {}
+
+    void post(const job_type &job);
+    int pending();
+    // returns once the queue is empty and its last job has returned
+    void wait_idle();
+
+  private:
+    void drain();
+
+    Thread_pool &pool_ref;
+    std::deque<job_type> jobs;
+    boost::mutex queue_mutex;
+    boost::condition_variable idle_condition;
+    bool draining;
+};
+
+} // namespace qtnp
+
+#endif /* qtnp_THREAD_POOL_HPP_ */
@@ -18,15 +18,31 @@
 ** Includes
 *****************************************************************************/
 #include <ros/ros.h>
+#include <list>
+#include <string>
+#include <map>
+#include <atomic>
 #include "boost/ref.hpp"
+#include <boost/noncopyable.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
 #include "rviz_objects.hpp"
 #include "cdt_types.hpp"
+#include "cell_table.hpp"
+#include "coverage_tracker.hpp"
+#include "geo_transform.hpp"
+#include "planning_control.hpp"
+#include "session_snapshot.hpp"
+#include "sizing_field.hpp"
+#include "terrain_model.hpp"
+#include "thread_pool.hpp"
 
 #include "qtnp/InitialCoordinates.h"
 #include "qtnp/Coordinates.h"
 #include "qtnp/Placemarks.h"
 
 #include "mavros_msgs/WaypointList.h"
+#include "nav_msgs/Path.h"
 
 /*****************************************************************************
 ** Namespaces
@@ -64,18 +80,91 @@ class Tnp_update {
   public:
 
     // the constructor takes always a reference to the visualization objects
-    Tnp_update(Rviz_objects& rvizReference) : rviz_objects_ref(rvizReference){}
+    Tnp_update(Rviz_objects& rvizReference) :
+        rviz_objects_ref(rvizReference), next_hole_id(0), cells_renumbered(0), cells_moved(0),
+        mesh_angle_criterion(constants::angle_criterion_default), mesh_edge_criterion(constants::edge_criterion_default),
+        mesh_projection(Geo_transform::Normalized), size_grading(constants::size_grading_default),
+        partition_weight(Cell_count), partitioned_weight(Cell_count), regions_remeshed(false),
+        cruise_speed(constants::cruise_speed_default), waypoint_turn_time(constants::waypoint_turn_time_default),
+        tour_budget(constants::tour_budget_default), waypoint_tolerance(constants::waypoint_tolerance_default),
+        flight_altitude(constants::flight_altitude_default), job_ptr(NULL), snapshot_ptr(NULL), pool_ptr(NULL),
+        mesh_ready(false), partition_ready(false){}
+
+    // One planning operation of a caller (the gui, an action goal, a topic message), run with
+    // the caller's own control: the checkpoints of the planning report to that control only and
+    // only its cancel stops them. A job holds the Tnp_update from its constructor to its
+    // destructor, the jobs of all callers run one after the other.
+    class Planning_job : private boost::noncopyable {
+      public:
+        Planning_job(Tnp_update &update, Planning_control &control);
+        ~Planning_job();
+
+        Planning_control &control(){ return control_ref; }
+
+        // the path and the waypoint list of the last path planning call of the job, copied
+        // before that call let go of the planning mutex
+        nav_msgs::Path path;
+        mavros_msgs::WaypointList waypoints;
+
+      private:
+        Tnp_update &update_ref;
+        Planning_control &control_ref;
+        boost::unique_lock<boost::mutex> job_lock;
+    };
+    // stops the running job, if there is one, at its next checkpoint
+    void cancel_job();
 
     void polygon_def_callback(const Placemarks::ConstPtr& msg);
     void perform_polygon_definition(std::vector<Coordinates> placemarks_array, double angle_cons, double edge_cons);
 
+    // no fly zones added to or removed from the current mesh without remeshing it. Only the
+    // neighbourhood of the hole is refined and smoothed; the cells outside keep their ids and
+    // agents. add_hole returns the id of the hole (the kml holes are numbered first), -1 on failure
+    int add_hole(const Coordinates &hole_coordinates);
+    bool remove_hole(int hole_id);
+    // cells renumbered by the last hole change
+    int get_cells_renumbered(){ return cells_renumbered; }
+
     void path_planning_callback(const InitialCoordinates::ConstPtr& msg);
     void path_planning_coverage(std::pair<int, std::pair<double, double> > uas);
+    // every agent of the partition from its start cell, the paths optimized in parallel
+    void path_planning_coverage_all();
+    // coverage over what is left of the region of the uas, from its current position (lat, lon):
+    // the given cell ids and, with tracked_cells, the cells the telemetry shows flown are skipped.
+    // The partition and the coverage depths stay as they are
+    void path_planning_resume(std::pair<int, std::pair<double, double> > uas, const std::vector<int> &covered_cells,
+                              bool tracked_cells);
     void path_planning_to_goal(int uas, double lat, double lon);
-    void partition(std::vector<std::pair<std::pair<double, double>, int> > uas_coords_with_percentage);
+    // Hop_growth grows the regions breadth first from the start cells and balances them after,
+    // Multilevel partitions the cell graph in the way of METIS (much faster on large meshes),
+    // Geodesic_voronoi gives every cell to the start cell nearest along the mesh, by distance
+    // plus a weight per agent tuned to the targets (compact regions)
+    enum Partitioner { Hop_growth, Multilevel, Geodesic_voronoi };
+    // "hop_growth", "multilevel" or "voronoi", false for anything else
+    static bool parse_partitioner(const std::string &name, Partitioner &partitioner);
 
-    void hop_cost_attribution(std::vector<std::pair<int, int> > id_cell_count);
+    // what the autonomy percentages are shares of: the cell count, the cell area, or the flight
+    // time over the cells (a centre to centre leg at cruise speed plus a turn, per cell)
+    enum Partition_weight { Cell_count, Cell_area, Flight_time };
+    // "cells", "area" or "flight_time", false for anything else
+    static bool parse_partition_weight(const std::string &name, Partition_weight &weight);
+
+    // the gui, and an action goal without a weight, use get_partition_weight(). With a cell size
+    // in metres for any uas (0 for none), the regions are remeshed at them after partitioning
+    void partition(std::vector<std::pair<std::pair<double, double>, int> > uas_coords_with_percentage,
+                   Partitioner partitioner, Partition_weight weight,
+                   const std::vector<double> &cell_sizes = std::vector<double>());
+    // rebalances the current partition to new autonomy percentages, one per agent id from 1 on;
+    // 0 drops the agent (a lost UAS). Only the agents that give or take cells are touched
+    void repartition(std::vector<int> autonomy_percentage);
+    // cells that changed agent in the last repartition
+    int get_cells_moved(){ return cells_moved; }
+
+    // weight_budget: the weight each agent may still take, by agent id from 1 on; the cell
+    // weights of the last partition() (all 1 without one)
+    void hop_cost_attribution(std::vector<std::pair<int, int> > id_cell_count, std::vector<double> weight_budget);
     void coverage_cost_attribution();
+    void coverage_cost_attribution(const std::vector<bool> &agents);
     void path_to_goal(int uas, int goal_cell_id);
     void complete_path_coverage(std::pair<int, std::pair<double,double> > uas);
 
@@ -95,22 +184,161 @@ class Tnp_update {
     int move(int cells, std::vector<int> path);
     void moveCOV(int cells, std::vector<int> path);
 
-    void make_mavros_waypoint_list(std::pair<double, double> uas_coords, std::vector<std::pair<double, double> > path);
-    mavros_msgs::WaypointList get_waypoint_list(){ return m_waypoint_list; }
+    // ground: metres above sea level under each point of the path, NaN where unknown; empty or
+    // unknown under the first point, every waypoint is flown at the flight altitude above home
+    void make_mavros_waypoint_list(int uas_id, std::pair<double, double> uas_coords, std::vector<std::pair<double, double> > path,
+                                   const std::vector<double> &ground);
+    mavros_msgs::WaypointList get_waypoint_list(){
+        boost::lock_guard<boost::mutex> lock(waypoint_mutex);
+        return m_waypoint_list;
+    }
+    // the lists produced since the last call, by uas id, e.g. for uploading them
+    std::map<int, mavros_msgs::WaypointList> take_updated_waypoint_lists();
+
+    // a position fix of a vehicle, from its telemetry. Marks the cells flown over since its last
+    // fix and returns the cell under it, -1 outside the area. -2: not tracked, there is no mesh
+    // or the planning holds it (the next fix catches up with the cells in between)
+    int track_position(int uas, double lat, double lon);
+    // covered and total cells per agent id (0: unassigned), false while the planning holds the mesh
+    bool coverage_progress(std::vector<int> &covered, std::vector<int> &total);
 
     void mesh_coloring();
     void init();
+    // any thread, applies from the next polygon definition on
+    void set_mesh_projection(Geo_transform::Projection projection){ mesh_projection = projection; }
+    // how fast the cells grow away from the "size" placemarks, in metres per metre; same as above
+    void set_size_grading(double grading){ size_grading = grading; }
+    // any thread, apply from the next partitioning on; speed in m/s, turn time in s per waypoint
+    void set_partition_weight(Partition_weight weight){ partition_weight = weight; }
+    Partition_weight get_partition_weight(){ return (Partition_weight) partition_weight.load(); }
+    void set_flight_model(double speed, double turn_time){ cruise_speed = speed; waypoint_turn_time = turn_time; }
+    // seconds each coverage path may spend in 2-opt/Or-opt, 0 leaves the paths as planned
+    void set_tour_budget(double seconds){ tour_budget = seconds; }
+    // metres a waypoint may be dropped by when a path is compressed, 0 keeps one per cell and
+    // below 0 it follows the cell size
+    void set_waypoint_tolerance(double metres){ waypoint_tolerance = metres; }
+    // any thread: the elevation raster the waypoint altitudes follow, and the height above the
+    // ground they are flown at. The cells get their ground with the next mesh
+    bool load_terrain(const std::string &path, std::string &error){ return terrain.load(path, error); }
+    void set_flight_altitude(double metres){ flight_altitude = metres; }
+    // parallel work inside the planning, e.g. the Voronoi weight candidates; none runs it serially
+    void set_thread_pool(Thread_pool *pool){ pool_ptr = pool; }
+    // the session is written there after every stage (mesh, hole, partition, paths); none for no snapshots
+    void set_session_snapshot(Session_snapshot *snapshot){ snapshot_ptr = snapshot; }
+    // the mesh, cells, partition, coverage depths, paths and waypoint lists of a snapshot file.
+    // False with the reason if it can't be read or doesn't fit together, the session stays as it was
+    bool restore_snapshot(const std::string &path, std::string &error);
+
+    bool is_mesh_ready(){ return mesh_ready; }
+    bool is_partition_ready(){ return partition_ready; }
+    // an estimate of the heap the mesh, the cells and the paths take; false while the planning
+    // holds them
+    bool memory_usage(size_t &bytes);
 
   private:
 
+    // a hole as it was inserted, in mesh coordinates
+    struct Hole {
+        int id;
+        std::vector<CDT::Point> outline; // consecutive points are the constrained edges
+        CDT::Point seed;
+    };
+
+    struct Mesh_box {
+        double min_x, min_y, max_x, max_y;
+        bool contains(const CDT::Point &p) const { return (p.x() >= min_x) && (p.x() <= max_x) && (p.y() >= min_y) && (p.y() <= max_y); }
+    };
+
+    // the control of the running job; outside a job nothing reads it and it is never cancelled
+    Planning_control &planning_control();
+    // the rviz path and the waypoint list into the running job, see Planning_job
+    void keep_path_results();
+
+    template <class Mesher_type>
+    void refine_with_checkpoints(Mesher_type &mesher, const char *stage);
+
+    std::list<CDT::Point> hole_seeds();
+    Mesh_box hole_neighbourhood(const Hole &hole);
+    void update_mesh_locally(const Mesh_box &box, const char *stage);
+    void smooth_locally(const Mesh_box &box, int iterations);
+    std::vector<CDT::Face_handle> renumber_changed_cells();
+    void assign_changed_cells(const std::vector<CDT::Face_handle> &changed);
+    void rebuild_center_points();
+    void number_cells();
+    void remesh_regions(const std::vector<std::pair<double, double> > &uas_coords, const std::vector<double> &cell_sizes);
+
+    std::vector<int> plan_coverage(const std::vector<int> &cell_ids, int start_id, double x, double y);
+    void publish_coverage_path(std::pair<int, std::pair<double, double> > uas, const std::vector<int> &cell_path);
+    void optimize_coverage_paths(const std::vector<int> &agents, std::vector<std::vector<int> > &paths);
+    std::vector<int> compress_path(const std::vector<int> &path);
+    // the waypoints of a cell path, with the legs that leave the domain re-routed around the
+    // holes; waypoint_of[i] is the index in path of point i, -1 for the corners put in
+    std::vector<CDT::Point> validate_path(const std::vector<int> &path, std::vector<int> &waypoint_of);
+    std::vector<int> cell_channel(int start_id, int goal_id);
+    std::vector<CDT::Point> string_pull(const std::vector<int> &channel, const CDT::Point &start, const CDT::Point &goal);
+    // true if the segment from p (in from) to q runs through domain faces only
+    bool segment_in_domain(CDT::Face_handle from, const CDT::Point &p, const CDT::Point &q);
+
+    void save_snapshot(const char *stage);
+
+    void graph_partition(const std::vector<int> &start_ids, const std::vector<int> &autonomy_percentage,
+                         Partitioner partitioner);
+    void compute_cell_weights(Partition_weight weight);
+
+    std::vector<CDT::Face_handle> agent_cells(int agent);
+    void release_cells(int agent, double amount, const std::vector<double> &deficit);
+    int grow_into_free_cells(std::vector<double> &deficit, bool limited, std::vector<bool> &affected);
+    void hop_cost_for_agent(int agent);
+
     // a reference to the rviz objects, responsible for visualization
     Rviz_objects &rviz_objects_ref;
 
     CDT cdt;
+    // centres of the in-domain cells, by FaceInfo2::id
+    Cell_table cells;
     CDT_Point_2_vector cdt_polygon_edges;
     Area_extremes area_extremes;
+    // lat, lon <-> mesh, fitted to area_extremes for every polygon definition
+    Geo_transform geo;
+    // the ground elevation, empty unless ~dem_path is set
+    Terrain_model terrain;
+    // cells flown over so far, from the telemetry
+    Coverage_tracker tracker;
+    std::vector<Hole> holes;
+    int next_hole_id, cells_renumbered, cells_moved;
+    // the criteria of the last polygon definition, local refinement uses them again
+    double mesh_angle_criterion, mesh_edge_criterion;
+    // the size attractors of the last polygon definition, the region meshers and the local
+    // refinement grade by them as the first mesh did; empty after a restored snapshot
+    Sizing_field sizing_field;
+    std::atomic<int> mesh_projection;
+    std::atomic<double> size_grading;
+    std::atomic<int> partition_weight;
+    // what the current partition balanced, repartition keeps to it
+    Partition_weight partitioned_weight;
+    // the regions were remeshed at cell sizes of their own, the cells differ in size from one
+    // region to the next and a count of them is no share of the area any more
+    bool regions_remeshed;
+    std::atomic<double> cruise_speed, waypoint_turn_time;
+    std::atomic<double> tour_budget, waypoint_tolerance, flight_altitude;
+    // the balancing weight of every cell by id, 0 for the vacant ones
+    std::vector<double> cell_weights;
 
     mavros_msgs::WaypointList m_waypoint_list;
+    std::map<int, mavros_msgs::WaypointList> updated_waypoint_lists;
+    // the last list of every uas, for the snapshots
+    std::map<int, mavros_msgs::WaypointList> waypoint_lists;
+    boost::mutex waypoint_mutex;
+
+    // the gui planning thread and the ros callbacks both end up here, one operation at a time
+    boost::mutex planning_mutex;
+    // job_mutex is held by the running Planning_job, job_ptr_mutex guards changes of job_ptr
+    boost::mutex job_mutex, job_ptr_mutex;
+    std::atomic<Planning_job *> job_ptr;
+    Planning_control idle_control;
+    Session_snapshot *snapshot_ptr;
+    Thread_pool *pool_ptr;
+    bool mesh_ready, partition_ready;
 
 };
 
@@ -0,0 +1,77 @@
+/**
+ * @file /include/qtnp/tour_optimizer.hpp
+ *
+ * @brief 2-opt and Or-opt improvement of a visiting order, under a time budget
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_TOUR_OPTIMIZER_HPP_
+#define qtnp_TOUR_OPTIMIZER_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <deque>
+#include <vector>
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Class
+*****************************************************************************/
+
+// Shortens an open path through points in the plane: the first point stays first, the end
+// is free. The moves are 2-opt (a stretch reversed) and Or-opt (one to three points taken
+// out and put in elsewhere, either way round), only towards the nearest neighbours of a
+// point, found on a bucket grid. Points whose edges changed are looked at again, until no
+// move shortens the path or the budget is spent; the path is the best so far either way.
+class Tour_optimizer {
+  public:
+    Tour_optimizer() : before(0), after(0), elapsed(0), moves_made(0), finished(true) {}
+
+    // order holds indices into xs, ys and is reordered in place; budget in seconds, 0 for none
+    void optimize(const double *xs, const double *ys, std::vector<int> &order, double budget);
+
+    // of the last optimize(), in the units of the coordinates
+    double length_before() const { return before; }
+    double length_after() const { return after; }
+    int moves() const { return moves_made; }
+    double seconds() const { return elapsed; }
+    // false when the budget ran out before a local optimum
+    bool converged() const { return finished; }
+
+  private:
+    double distance(int a, int b) const;
+    double edge(int from_position) const;
+    void find_neighbours();
+    bool two_opt(int a);
+    bool or_opt(int a);
+    void reverse(int from, int to);
+    void move_segment(int first, int length, int after_position, bool reversed);
+    void touch(int position);
+    double path_length() const;
+
+    std::vector<double> x, y;
+    // tour[position] is a point, position[point] where it is
+    std::vector<int> tour, position;
+    std::vector<int> neighbours;  // neighbour_count per point, nearest first
+    std::deque<int> queue;
+    std::vector<bool> queued;
+    double before, after, elapsed;
+    int moves_made;
+    bool finished;
+};
+
+} // namespace qtnp
+
+#endif /* qtnp_TOUR_OPTIMIZER_HPP_ */
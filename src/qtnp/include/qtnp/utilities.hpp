@@ -164,28 +164,12 @@ inline geometry_msgs::PoseStamped build_pose_stamped(geometry_msgs::Point point_
 
 }
 
-inline geometry_msgs::Point face_to_center(CDT &cdt, CDT::Face_handle face){
-
-  // create a point for each of the edges of the face.
-  CDT::Point point1 = cdt.triangle(face)[0];
-  CDT::Point point2 = cdt.triangle(face)[1];
-  CDT::Point point3 = cdt.triangle(face)[2];
-
-  return utilities::face_points_to_center(point1, point2, point3);
-
-}
-
 inline double calculate_distance(geometry_msgs::Point center1, geometry_msgs::Point center2){
 
   return hypot(abs(center1.x - center2.x),abs(center1.y - center2.y));
 
 }
 
-inline bool distance_comparison (const Distance_Entry& i, const Distance_Entry& j) {
-  if (i.first != j.first)
-    return (i.second < j.second);
-}
-
 inline bool depth_comparison  (const Distance_Entry& i, const Distance_Entry& j) {
     return (i.first->info().depth < j.first->info().depth);
 }
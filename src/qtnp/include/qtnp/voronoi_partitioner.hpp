@@ -0,0 +1,92 @@
+/**
+ * @file /include/qtnp/voronoi_partitioner.hpp
+ *
+ * @brief Additively weighted geodesic Voronoi partitioning of the cell graph
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Ifdefs
+*****************************************************************************/
+
+#ifndef qtnp_VORONOI_PARTITIONER_HPP_
+#define qtnp_VORONOI_PARTITIONER_HPP_
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <stdint.h>
+#include <vector>
+
+#include "multilevel_partitioner.hpp"
+#include "planning_control.hpp"
+#include "thread_pool.hpp"
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Class
+*****************************************************************************/
+
+// Every vertex goes to the part whose source is nearest, the distance along the edges plus
+// an offset per part. A multi-source Dijkstra (on a radix heap, the lengths are integers)
+// gives the parts in one sweep, each a shortest path tree and so connected. The offsets are
+// tuned round by round towards the target weights: a part over its target moves its border
+// in by an offset step, one under moves it out. Every part sizes its own step, longer while
+// its weight stays on one side of the target and half as long when it crosses over. Each
+// round tries a few step sizes at once on the pool and goes on from the best of them; the
+// best labeling seen is the result.
+class Voronoi_partitioner {
+  public:
+    // without a pool the candidates run one after the other
+    Voronoi_partitioner(Planning_control &control, Thread_pool *pool) :
+        planning_control(control), pool_ptr(pool), rounds_run(0), imbalance_reached(0) {}
+
+    // the part of every vertex, -1 for the ones no source reaches. The adjwgt of the graph
+    // are the edge lengths, targets the shares of the total vertex weight; pinned[p] is the
+    // source of part p, a part with none or with a zero target gets nothing
+    std::vector<int> partition(const Partition_graph &graph, const std::vector<double> &targets,
+                               const std::vector<int> &pinned);
+
+    // of the last partition: the tuning rounds, and the largest deviation from a target weight
+    // relative to it
+    int rounds() const { return rounds_run; }
+    double imbalance() const { return imbalance_reached; }
+
+  private:
+    struct Labeling {
+        std::vector<int> part;
+        std::vector<uint64_t> dist;
+        std::vector<double> weight;
+        // the farthest vertex of each part from its source, the offset left out
+        std::vector<uint64_t> reach;
+        // the weight of the vertices of each part next to another part
+        std::vector<double> border;
+        // the distance from each source to the nearest source of a neighbouring part
+        std::vector<uint64_t> gap;
+        // the largest deviation from a target relative to it, and the sum of the deviations
+        double imbalance, misplaced;
+    };
+
+    void label(const Partition_graph &graph, const std::vector<uint64_t> &offset, Labeling &labeling) const;
+    // part p within the tolerance of its target
+    bool within(const Labeling &labeling, int p) const;
+
+    Planning_control &planning_control;
+    Thread_pool *pool_ptr;
+    std::vector<int> sources;
+    std::vector<bool> source_vertex;
+    std::vector<double> target_weight;
+    int rounds_run;
+    double imbalance_reached;
+};
+
+} // namespace qtnp
+
+#endif /* qtnp_VORONOI_PARTITIONER_HPP_ */
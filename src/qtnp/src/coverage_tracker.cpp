@@ -0,0 +1,140 @@
+/**
+ * @file /src/coverage_tracker.cpp
+ *
+ * @brief Cells flown over by the vehicles, from their position fixes
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include "../include/qtnp/coverage_tracker.hpp"
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Implementation
+*****************************************************************************/
+
+void Coverage_tracker::reset(int cell_count){
+
+    covered.assign((cell_count + 63) / 64, 0);
+    covered_cells = 0;
+    vehicles.clear();
+}
+
+void Coverage_tracker::forget_cells(const std::vector<int> &ids, int cell_count){
+
+    covered.resize((cell_count + 63) / 64, 0);
+    for (int i=0; i<ids.size(); i++){
+        if (is_covered(ids[i])){
+            covered[ids[i] >> 6] &= ~((uint64_t) 1 << (ids[i] & 63));
+            covered_cells--;
+        }
+    }
+    vehicles.clear();
+}
+
+void Coverage_tracker::restore(const std::vector<uint64_t> &bits, int cell_count){
+
+    reset(cell_count);
+    for (int i=0; (i < bits.size()) && (i < covered.size()); i++){
+        covered[i] = bits[i];
+        covered_cells += __builtin_popcountll(bits[i]);
+    }
+}
+
+int Coverage_tracker::move(CDT &cdt, int uas, const CDT::Point &p){
+
+    if (cdt.dimension() < 2) return -1;
+
+    std::map<int, Vehicle>::iterator it = vehicles.find(uas);
+    CDT::Face_handle face;
+    bool inside(false);
+
+    if (it == vehicles.end()){
+        // the first fix, or the first after a mesh change: located by CGAL, nothing marked on the way
+        CDT::Locate_type lt;
+        int li;
+        face = cdt.locate(p, lt, li);
+        inside = !cdt.is_infinite(face);
+        if (!inside) face = face->neighbor(face->index(cdt.infinite_vertex()));
+        Vehicle vehicle = { face, p };
+        vehicles.insert(std::make_pair(uas, vehicle));
+    } else {
+        face = walk(cdt, it->second.face, it->second.position, p, inside);
+        it->second.face = face;
+        it->second.position = p;
+    }
+    if (inside) mark(face);
+
+    if (!inside || !face->is_in_domain()) return -1;
+    return face->info().id;
+}
+
+// A straight walk: from each face it leaves through the edge the segment p q crosses, with
+// q on the far side. Where the segment runs through a vertex any edge facing q is taken,
+// which is still a visibility walk. That one ends on a Delaunay triangulation; the
+// constrained one may not be, hence the step limit. The start face was marked with the
+// previous fix (or the fix was outside), it is left as it is.
+CDT::Face_handle Coverage_tracker::walk(CDT &cdt, CDT::Face_handle from, const CDT::Point &p, const CDT::Point &q,
+                                        bool &inside){
+
+    CDT::Face_handle face = from;
+    int limit = cdt.number_of_faces();
+
+    for (int step = 0; step < limit; step++){
+
+        if (step > 0) mark(face);
+
+        int exit(-1);
+        for (int i=0; i<3; i++){
+            const CDT::Point &a = face->vertex(CDT::ccw(i))->point();
+            const CDT::Point &b = face->vertex(CDT::cw(i))->point();
+            if (CGAL::orientation(a, b, q) != CGAL::RIGHT_TURN) continue;
+            if (exit < 0) exit = i;
+            CGAL::Orientation side_a = CGAL::orientation(p, q, a);
+            CGAL::Orientation side_b = CGAL::orientation(p, q, b);
+            if ((side_a != side_b) || (side_a == CGAL::COLLINEAR)){
+                exit = i;
+                break;
+            }
+        }
+
+        if (exit < 0){
+            inside = true;
+            return face;
+        }
+        CDT::Face_handle next = face->neighbor(exit);
+        if (cdt.is_infinite(next)){
+            inside = false;
+            return face;
+        }
+        face = next;
+    }
+
+    // only for a broken walk; nothing is marked from here
+    CDT::Locate_type lt;
+    int li;
+    face = cdt.locate(q, lt, li, from);
+    inside = !cdt.is_infinite(face);
+    if (!inside) face = face->neighbor(face->index(cdt.infinite_vertex()));
+    return face;
+}
+
+void Coverage_tracker::mark(CDT::Face_handle face){
+
+    if (!face->is_in_domain()) return;
+    int id = face->info().id;
+    if ((id < 0) || ((id >> 6) >= (int) covered.size()) || is_covered(id)) return;
+    covered[id >> 6] |= (uint64_t) 1 << (id & 63);
+    covered_cells++;
+}
+
+} // namespace qtnp
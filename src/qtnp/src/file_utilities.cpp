@@ -0,0 +1,113 @@
+/**
+ * @file /src/file_utilities.cpp
+ *
+ * @brief Paths under the ROS home, directories and whole file writes
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "../include/qtnp/file_utilities.hpp"
+
+namespace qtnp {
+namespace files {
+
+/*****************************************************************************
+** Implementation
+*****************************************************************************/
+
+std::string ros_home_path(const std::string &name){
+
+    const char *ros_home = std::getenv("ROS_HOME");
+    if (ros_home && *ros_home) return std::string(ros_home) + "/qtnp/" + name;
+    const char *home = std::getenv("HOME");
+    return std::string(home ? home : ".") + "/.ros/qtnp/" + name;
+}
+
+std::string expand_home(const std::string &path){
+
+    const char *home = std::getenv("HOME");
+    if (home && (path == "~" || path.compare(0, 2, "~/") == 0)) return std::string(home) + path.substr(1);
+    return path;
+}
+
+bool make_directories(const std::string &directory, std::string &error){
+
+    std::string::size_type position = 0;
+    while (position != std::string::npos){
+        position = directory.find('/', position + 1);
+        std::string partial = directory.substr(0, position);
+        if (partial.empty()) continue;
+        if ( (mkdir(partial.c_str(), 0755) != 0) && (errno != EEXIST) ){
+            error = "cannot create " + partial + ": " + std::strerror(errno);
+            return false;
+        }
+    }
+
+    struct stat status;
+    if ( (stat(directory.c_str(), &status) != 0) || !S_ISDIR(status.st_mode) ){
+        error = directory + " is not a directory";
+        return false;
+    }
+    return true;
+}
+
+bool make_parent_directories(const std::string &path, std::string &error){
+
+    std::string::size_type slash = path.rfind('/');
+    // a relative name in the working directory, or a file right under /
+    if ((slash == std::string::npos) || (slash == 0)) return true;
+    return make_directories(path.substr(0, slash), error);
+}
+
+bool write_file(const std::string &path, const std::string &content, bool sync, std::string &error){
+
+    std::string temporary = path + ".tmp";
+    int descriptor = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (descriptor < 0){
+        error = "cannot open " + temporary + ": " + std::strerror(errno);
+        return false;
+    }
+    size_t written(0);
+    while (written < content.size()){
+        ssize_t count = ::write(descriptor, content.data() + written, content.size() - written);
+        if (count < 0){
+            if (errno == EINTR) continue;
+            break;
+        }
+        written += count;
+    }
+    bool complete = (written == content.size()) && (!sync || (fsync(descriptor) == 0));
+    int write_errno = errno;
+    if ((::close(descriptor) != 0) && complete){
+        complete = false;
+        write_errno = errno;
+    }
+    if (!complete){
+        error = "cannot write " + temporary + ": " + std::strerror(write_errno);
+        std::remove(temporary.c_str());
+        return false;
+    }
+
+    if (std::rename(temporary.c_str(), path.c_str()) != 0){
+        error = "cannot rename " + temporary + ": " + std::strerror(errno);
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace files
+} // namespace qtnp
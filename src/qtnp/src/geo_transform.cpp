@@ -0,0 +1,132 @@
+/**
+ * @file /src/geo_transform.cpp
+ *
+ * @brief Conversion between lat, lon and the mesh coordinates
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <cmath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "../include/qtnp/geo_transform.hpp"
+#include "../include/qtnp/constants.hpp"
+
+/*****************************************************************************
+** Helpers
+*****************************************************************************/
+
+namespace {
+
+const double metres_per_degree(constants::r_earth * 1000.0 * constants::PI / 180.0);
+
+// out[i] = start + (in[i] - origin) * scale, the order of operations of convert_range
+void affine(const double *in, int count, double origin, double scale, double start, double *out){
+
+    int i(0);
+#ifdef __SSE2__
+    const __m128d origin_v = _mm_set1_pd(origin);
+    const __m128d scale_v = _mm_set1_pd(scale);
+    const __m128d start_v = _mm_set1_pd(start);
+    for (; i + 2 <= count; i += 2){
+        __m128d value = _mm_loadu_pd(in + i);
+        _mm_storeu_pd(out + i, _mm_add_pd(start_v, _mm_mul_pd(_mm_sub_pd(value, origin_v), scale_v)));
+    }
+#endif
+    for (; i < count; i++){
+        out[i] = start + (in[i] - origin) * scale;
+    }
+}
+
+}
+
+namespace qtnp {
+
+/*****************************************************************************
+** Implementation
+*****************************************************************************/
+
+Geo_transform::Geo_transform() :
+    current_projection(Normalized),
+    origin_lat(0), origin_lon(0),
+    start_x(0), start_y(0),
+    scale_x(1), scale_y(1),
+    inverse_x(1), inverse_y(1),
+    metres_per_unit_x(metres_per_degree), metres_per_unit_y(metres_per_degree)
+{}
+
+bool Geo_transform::parse_projection(const std::string &name, Projection &projection){
+
+    if (name == "normalized") projection = Normalized;
+    else if (name == "local_enu") projection = Local_enu;
+    else return false;
+    return true;
+}
+
+// takes effect with the next fit
+void Geo_transform::set_projection(Projection projection){
+    current_projection = projection;
+}
+
+void Geo_transform::fit(double min_lat, double max_lat, double min_lon, double max_lon){
+
+    origin_lat = min_lat;
+    origin_lon = min_lon;
+    // "lat" is the real longitude and "lon" the real latitude (see the class comment), so the
+    // degrees along x shrink with the cosine of the latitude in the second coordinate
+    double lon_shrink = std::cos(((min_lon + max_lon) / 2) * (constants::PI / 180));
+
+    if (current_projection == Local_enu){
+        start_x = start_y = 0;
+        scale_x = metres_per_degree * lon_shrink;
+        scale_y = metres_per_degree;
+        inverse_x = 1 / scale_x;
+        inverse_y = 1 / scale_y;
+        metres_per_unit_x = metres_per_unit_y = 1;
+    } else {
+        start_x = start_y = constants::rviz_range_min;
+        double range = constants::rviz_range_max - constants::rviz_range_min;
+        scale_x = range / (max_lat - min_lat);
+        scale_y = range / (max_lon - min_lon);
+        inverse_x = (max_lat - min_lat) / range;
+        inverse_y = (max_lon - min_lon) / range;
+        metres_per_unit_x = metres_per_degree * lon_shrink * inverse_x;
+        metres_per_unit_y = metres_per_degree * inverse_y;
+    }
+}
+
+void Geo_transform::to_mesh(double lat, double lon, double &x, double &y) const {
+    x = start_x + (lat - origin_lat) * scale_x;
+    y = start_y + (lon - origin_lon) * scale_y;
+}
+
+void Geo_transform::to_geo(double x, double y, double &lat, double &lon) const {
+    lat = origin_lat + (x - start_x) * inverse_x;
+    lon = origin_lon + (y - start_y) * inverse_y;
+}
+
+void Geo_transform::to_mesh(const double *lat, const double *lon, int count, double *x, double *y) const {
+    affine(lat, count, origin_lat, scale_x, start_x, x);
+    affine(lon, count, origin_lon, scale_y, start_y, y);
+}
+
+void Geo_transform::to_geo(const double *x, const double *y, int count, double *lat, double *lon) const {
+    affine(x, count, start_x, inverse_x, origin_lat, lat);
+    affine(y, count, start_y, inverse_y, origin_lon, lon);
+}
+
+double Geo_transform::mesh_length(double metres) const {
+    return metres * 2 / (metres_per_unit_x + metres_per_unit_y);
+}
+
+double Geo_transform::metres(double mesh_length) const {
+    return mesh_length * (metres_per_unit_x + metres_per_unit_y) / 2;
+}
+
+} // namespace qtnp
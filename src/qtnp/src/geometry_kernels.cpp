@@ -0,0 +1,150 @@
+/**
+ * @file /src/geometry_kernels.cpp
+ *
+ * @brief Batch distance kernels over the coordinate arrays of the cell table
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <cmath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "../include/qtnp/geometry_kernels.hpp"
+
+/*****************************************************************************
+** Helpers
+*****************************************************************************/
+
+namespace {
+
+inline double squared_distance(double x, double y, double qx, double qy){
+    double dx = x - qx;
+    double dy = y - qy;
+    return dx * dx + dy * dy;
+}
+
+#ifdef __SSE2__
+// two squared distances, lanes in memory order
+inline __m128d squared_distance_pair(__m128d x, __m128d y, __m128d qx, __m128d qy){
+    __m128d dx = _mm_sub_pd(x, qx);
+    __m128d dy = _mm_sub_pd(y, qy);
+    return _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+}
+
+inline void store_distance_pair(__m128d squared, float *out){
+    _mm_storel_pi((__m64 *) out, _mm_cvtpd_ps(_mm_sqrt_pd(squared)));
+}
+#endif
+
+}
+
+namespace qtnp {
+namespace kernels {
+
+/*****************************************************************************
+** Implementation
+*****************************************************************************/
+
+void distances(const double *xs, const double *ys, int count, double qx, double qy, float *out){
+
+    int i(0);
+#ifdef __SSE2__
+    const __m128d query_x = _mm_set1_pd(qx);
+    const __m128d query_y = _mm_set1_pd(qy);
+    for (; i + 2 <= count; i += 2){
+        store_distance_pair(squared_distance_pair(_mm_loadu_pd(xs + i), _mm_loadu_pd(ys + i), query_x, query_y),
+                            out + i);
+    }
+#endif
+    for (; i < count; i++){
+        out[i] = (float) std::sqrt(squared_distance(xs[i], ys[i], qx, qy));
+    }
+}
+
+void distances_gather(const double *xs, const double *ys, const int *ids, int count,
+                      double qx, double qy, float *out){
+
+    int k(0);
+#ifdef __SSE2__
+    const __m128d query_x = _mm_set1_pd(qx);
+    const __m128d query_y = _mm_set1_pd(qy);
+    for (; k + 2 <= count; k += 2){
+        __m128d x = _mm_set_pd(xs[ids[k + 1]], xs[ids[k]]);
+        __m128d y = _mm_set_pd(ys[ids[k + 1]], ys[ids[k]]);
+        store_distance_pair(squared_distance_pair(x, y, query_x, query_y), out + k);
+    }
+#endif
+    for (; k < count; k++){
+        out[k] = (float) std::sqrt(squared_distance(xs[ids[k]], ys[ids[k]], qx, qy));
+    }
+}
+
+// squared distances are enough to compare, no square roots here
+int nearest(const double *xs, const double *ys, int count, double qx, double qy){
+
+    int best(-1);
+    double best_distance(0);
+    int i(0);
+#ifdef __SSE2__
+    const __m128d query_x = _mm_set1_pd(qx);
+    const __m128d query_y = _mm_set1_pd(qy);
+    double pair[2];
+    for (; i + 2 <= count; i += 2){
+        _mm_storeu_pd(pair, squared_distance_pair(_mm_loadu_pd(xs + i), _mm_loadu_pd(ys + i), query_x, query_y));
+        for (int lane = 0; lane < 2; lane++){
+            if (best < 0 || pair[lane] < best_distance){
+                best = i + lane;
+                best_distance = pair[lane];
+            }
+        }
+    }
+#endif
+    for (; i < count; i++){
+        double distance = squared_distance(xs[i], ys[i], qx, qy);
+        if (best < 0 || distance < best_distance){
+            best = i;
+            best_distance = distance;
+        }
+    }
+    return best;
+}
+
+int nearest_gather(const double *xs, const double *ys, const int *ids, int count, double qx, double qy){
+
+    int best(-1);
+    double best_distance(0);
+    int k(0);
+#ifdef __SSE2__
+    const __m128d query_x = _mm_set1_pd(qx);
+    const __m128d query_y = _mm_set1_pd(qy);
+    double pair[2];
+    for (; k + 2 <= count; k += 2){
+        __m128d x = _mm_set_pd(xs[ids[k + 1]], xs[ids[k]]);
+        __m128d y = _mm_set_pd(ys[ids[k + 1]], ys[ids[k]]);
+        _mm_storeu_pd(pair, squared_distance_pair(x, y, query_x, query_y));
+        for (int lane = 0; lane < 2; lane++){
+            if (best < 0 || pair[lane] < best_distance){
+                best = k + lane;
+                best_distance = pair[lane];
+            }
+        }
+    }
+#endif
+    for (; k < count; k++){
+        double distance = squared_distance(xs[ids[k]], ys[ids[k]], qx, qy);
+        if (best < 0 || distance < best_distance){
+            best = k;
+            best_distance = distance;
+        }
+    }
+    return best;
+}
+
+} // namespace kernels
+} // namespace qtnp
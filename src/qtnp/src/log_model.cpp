@@ -0,0 +1,156 @@
+/**
+ * @file /src/log_model.cpp
+ *
+ * @brief Fixed size log for the gui, fed from any thread
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <algorithm>
+#include <sstream>
+#include <QBrush>
+#include <QColor>
+
+#include "../include/qtnp/log_model.hpp"
+
+/*****************************************************************************
+** Helpers
+*****************************************************************************/
+
+namespace {
+
+const char *level_tags[] = { "[DEBUG]", "[INFO]", "[WARN]", "[ERROR]", "[FATAL]" };
+const int warn_level(2);
+const std::size_t drain_batch(1024);  // rows per timer tick, the rest waits for the next one
+const int drain_interval_ms(100);
+
+}
+
+namespace qtnp {
+
+/*****************************************************************************
+** Implementation
+*****************************************************************************/
+
+Log_model::Log_model(std::size_t row_capacity, std::size_t queue_capacity, QObject *parent) :
+    QAbstractListModel(parent),
+    queue(queue_capacity),
+    dropped(0),
+    ring(std::max<std::size_t>(row_capacity, 1)),
+    first_sequence(0),
+    next_sequence(0),
+    shown_level(0)
+{
+    QObject::connect(&drain_timer, SIGNAL(timeout()), this, SLOT(drain()));
+    drain_timer.start(drain_interval_ms);
+}
+
+void Log_model::push(int level, const std::string &text){
+
+    Log_entry entry;
+    entry.level = std::min(std::max(level, 0), 4);
+    entry.stamp = ros::Time::now();
+    entry.text = text;
+    if (!queue.try_push(std::move(entry))) dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Log_model::set_minimum_level(int level){
+
+    beginResetModel();
+    shown_level = level;
+    visible.clear();
+    for (unsigned long long sequence = first_sequence; sequence < next_sequence; sequence++){
+        if (ring[sequence % ring.size()].level >= shown_level) visible.push_back(sequence);
+    }
+    endResetModel();
+}
+
+int Log_model::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : (int) visible.size();
+}
+
+QVariant Log_model::data(const QModelIndex &index, int role) const {
+
+    if (!index.isValid() || index.row() < 0 || index.row() >= (int) visible.size()) return QVariant();
+
+    const Row &row = row_at(index.row());
+    switch (role){
+        case Qt::DisplayRole:
+            return row.text;
+        case Qt::ForegroundRole:
+            if (row.level == 0) return QBrush(Qt::gray);
+            if (row.level == warn_level) return QBrush(QColor(200, 110, 0));
+            if (row.level > warn_level) return QBrush(Qt::red);
+            return QVariant();
+        default:
+            return QVariant();
+    }
+}
+
+// gui thread, on the timer
+void Log_model::drain(){
+
+    std::vector<Log_entry> batch;
+    Log_entry entry;
+    while (batch.size() < drain_batch && queue.try_pop(entry)){
+        batch.push_back(std::move(entry));
+    }
+
+    unsigned int lost = dropped.exchange(0);
+    if (lost > 0){
+        std::stringstream ss;
+        ss << lost << " log messages dropped, the log queue was full";
+        entry.level = warn_level;
+        entry.stamp = ros::Time::now();
+        entry.text = ss.str();
+        batch.push_back(entry);
+    }
+
+    if (batch.empty()) return;
+    append(batch);
+    Q_EMIT rowsAppended();
+}
+
+void Log_model::append(std::vector<Log_entry> &batch){
+
+    const std::size_t capacity = ring.size();
+    if (batch.size() > capacity) batch.erase(batch.begin(), batch.end() - capacity);
+
+    // make room first, the new rows overwrite the oldest slots
+    unsigned long long end_sequence = next_sequence + batch.size();
+    unsigned long long new_first = (end_sequence > capacity) ? std::max(first_sequence, end_sequence - capacity)
+                                                             : first_sequence;
+    int evicted_rows(0);
+    while (evicted_rows < (int) visible.size() && visible[evicted_rows] < new_first) evicted_rows++;
+    if (evicted_rows > 0){
+        beginRemoveRows(QModelIndex(), 0, evicted_rows - 1);
+        visible.erase(visible.begin(), visible.begin() + evicted_rows);
+        endRemoveRows();
+    }
+    first_sequence = new_first;
+
+    int shown_rows(0);
+    for (std::size_t i = 0; i < batch.size(); i++){
+        if (batch[i].level >= shown_level) shown_rows++;
+    }
+    if (shown_rows > 0) beginInsertRows(QModelIndex(), (int) visible.size(), (int) visible.size() + shown_rows - 1);
+
+    for (std::size_t i = 0; i < batch.size(); i++){
+        std::stringstream text;
+        text << level_tags[batch[i].level] << " [" << batch[i].stamp << "]: " << batch[i].text;
+
+        Row &row = ring[next_sequence % capacity];
+        row.level = batch[i].level;
+        row.text = QString::fromUtf8(text.str().c_str());
+        if (row.level >= shown_level) visible.push_back(next_sequence);
+        next_sequence++;
+    }
+
+    if (shown_rows > 0) endInsertRows();
+}
+
+}  // namespace qtnp
@@ -0,0 +1,143 @@
+/**
+ * @file /src/logging.cpp
+ *
+ * @brief Leveled logging for the planning code, per subsystem and rate limited
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <chrono>
+#include <ros/console.h>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "../include/qtnp/logging.hpp"
+
+/*****************************************************************************
+** Helpers
+*****************************************************************************/
+
+namespace {
+
+const char *subsystem_names[] = { "general", "meshing", "partitioning", "coverage", "path_to_goal", "waypoints" };
+const char *level_names[] = { "debug", "info", "warn", "error", "fatal", "off" };
+
+std::atomic<int> subsystem_levels[qtnp::logging::Subsystem_count] = {
+    { qtnp::logging::Info }, { qtnp::logging::Info }, { qtnp::logging::Info },
+    { qtnp::logging::Info }, { qtnp::logging::Info }, { qtnp::logging::Info }
+};
+
+boost::mutex sink_mutex;
+qtnp::logging::summary_sink current_sink;
+
+long long steady_now_ns(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+namespace qtnp {
+namespace logging {
+
+/*****************************************************************************
+** Implementation
+*****************************************************************************/
+
+const char *subsystem_name(Subsystem subsystem){
+    return (subsystem >= 0 && subsystem < Subsystem_count) ? subsystem_names[subsystem] : "unknown";
+}
+
+const char *level_name(Level level){
+    return (level >= Debug && level <= Off) ? level_names[level] : "unknown";
+}
+
+void set_level(Subsystem subsystem, Level level){
+
+    if (subsystem < 0 || subsystem >= Subsystem_count) return;
+    subsystem_levels[subsystem].store(level);
+
+    // rosconsole drops debug messages below its own level (info by default), the subsystem
+    // levels do the filtering, so the logger of the package goes down to debug with the first
+    // subsystem that does. It is never raised again, it may have been lowered on purpose
+    if ( (level == Debug) &&
+         ros::console::set_logger_level(ROSCONSOLE_DEFAULT_NAME, ros::console::levels::Debug) ){
+        ros::console::notifyLoggerLevelsChanged();
+    }
+}
+
+Level get_level(Subsystem subsystem){
+    return (Level) subsystem_levels[subsystem].load(std::memory_order_relaxed);
+}
+
+void configure(ros::NodeHandle &private_n){
+
+    for (int s = 0; s < Subsystem_count; s++){
+        std::string configured;
+        if (!private_n.getParam(std::string("log_levels/") + subsystem_names[s], configured)) continue;
+
+        bool known(false);
+        for (int l = Debug; l <= Off; l++){
+            if (configured == level_names[l]){
+                set_level((Subsystem) s, (Level) l);
+                known = true;
+            }
+        }
+        if (!known) ROS_WARN_STREAM("Unknown log level '" << configured << "' for " << subsystem_names[s]);
+    }
+}
+
+void set_summary_sink(summary_sink sink){
+
+    boost::lock_guard<boost::mutex> lock(sink_mutex);
+    current_sink = sink;
+}
+
+bool is_enabled(Subsystem subsystem, Level level){
+    return level >= subsystem_levels[subsystem].load(std::memory_order_relaxed);
+}
+
+void write(Subsystem subsystem, Level level, const std::string &message, bool summary){
+
+    switch (level){
+        case Debug: ROS_DEBUG_STREAM("[" << subsystem_names[subsystem] << "] " << message); break;
+        case Info:  ROS_INFO_STREAM("[" << subsystem_names[subsystem] << "] " << message); break;
+        case Warn:  ROS_WARN_STREAM("[" << subsystem_names[subsystem] << "] " << message); break;
+        case Error: ROS_ERROR_STREAM("[" << subsystem_names[subsystem] << "] " << message); break;
+        case Fatal: ROS_FATAL_STREAM("[" << subsystem_names[subsystem] << "] " << message); break;
+        default: return;
+    }
+
+    if (!summary) return;
+    summary_sink sink;
+    {
+        boost::lock_guard<boost::mutex> lock(sink_mutex);
+        sink = current_sink;
+    }
+    if (sink) sink(level, message);
+}
+
+Rate_limiter::Rate_limiter(double period_seconds) :
+    period_ns((long long) (period_seconds * 1e9)),
+    next_allowed_ns(0),
+    suppressed_count(0)
+{}
+
+bool Rate_limiter::allow(int &suppressed){
+
+    long long now = steady_now_ns();
+    long long next = next_allowed_ns.load(std::memory_order_relaxed);
+    if ( (now >= next) && next_allowed_ns.compare_exchange_strong(next, now + period_ns) ){
+        suppressed = suppressed_count.exchange(0);
+        return true;
+    }
+    suppressed_count.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+} // namespace logging
+} // namespace qtnp
@@ -19,7 +19,9 @@
 #include <QDomDocument>
 #include <QTableView>
 #include <boost/algorithm/string/trim.hpp>
+#include <boost/bind.hpp>
 #include <iostream>
+#include <algorithm>
 #include "../include/qtnp/main_window.hpp"
 
 /*****************************************************************************
@@ -64,9 +66,22 @@ qtnp::Placemarks kml_parsing(const QString &filename) {
             placemark_coordinates.seed_longitude = ::atof(seed_tokens[1].c_str());
         }
 
-        // pushing all coordinates to form the shape
+        // metres, of a "size" placemark and of any outline that wants cells of this size along it
+        placemark_coordinates.target_size = placemark.firstChildElement("size").text().toDouble();
+
+        // pushing all coordinates to form the shape; a size placemark may be a point or a line too
         std::string all_coordinates = placemark.namedItem("Polygon").namedItem("LinearRing")
                 .firstChildElement("coordinates").text().toStdString();
+        placemark_coordinates.geometry_type = "Polygon";
+        if (all_coordinates.empty()){
+            all_coordinates = placemark.namedItem("Point").firstChildElement("coordinates").text().toStdString();
+            placemark_coordinates.geometry_type = "Point";
+        }
+        if (all_coordinates.empty()){
+            // a line stays open, it is not closed into a polygon
+            all_coordinates = placemark.namedItem("LineString").firstChildElement("coordinates").text().toStdString();
+            placemark_coordinates.geometry_type = "LineString";
+        }
         split_char = '\n';
         boost::algorithm::trim(all_coordinates);
         std::istringstream split(all_coordinates);
@@ -94,6 +109,7 @@ qtnp::Placemarks kml_parsing(const QString &filename) {
 MainWindow::MainWindow(int argc, char** argv, QWidget *parent)
 	: QMainWindow(parent)
 	, qnode(argc,argv)
+	, planning_thread(*qnode.get_tnp_update_pointer())
 {
 	ui.setupUi(this); // Calling this incidentally connects all ui's triggers to on_...() callbacks in this class.
 
@@ -125,6 +141,14 @@ MainWindow::MainWindow(int argc, char** argv, QWidget *parent)
 	ui.view_logging->setModel(qnode.loggingModel());
     QObject::connect(&qnode, SIGNAL(loggingUpdated()), this, SLOT(updateLoggingView()));
 
+    /*********************
+    ** Planning thread
+    **********************/
+    QObject::connect(&planning_thread, SIGNAL(progressUpdated(QString,int,int)),
+                     this, SLOT(updatePlanningProgress(QString,int,int)));
+    QObject::connect(&planning_thread, SIGNAL(planningFinished(QString,bool,QString)),
+                     this, SLOT(planningFinished(QString,bool,QString)));
+
     /*********************
     ** Auto Start
     **********************/
@@ -133,7 +157,10 @@ MainWindow::MainWindow(int argc, char** argv, QWidget *parent)
     }
 }
 
-MainWindow::~MainWindow() {}
+MainWindow::~MainWindow() {
+    planning_thread.cancel();
+    planning_thread.wait();
+}
 
 /*****************************************************************************
 ** Implementation [Slots]
@@ -246,8 +273,8 @@ void MainWindow::on_button_perform_cdt_clicked(bool check ) {
             edge_cons = ui.line_edit_edge_constr->text() == "" ?
                         angle_cons : ui.line_edit_edge_constr->text().remove(QRegExp(" .*")).toDouble();
 
-            qnode.get_tnp_update_pointer()->perform_polygon_definition
-                    (kml_parsing(kml_filename).placemarks, angle_cons, edge_cons);
+            start_planning("Meshing", boost::bind(&Tnp_update::perform_polygon_definition, qnode.get_tnp_update_pointer(),
+                                                  kml_parsing(kml_filename).placemarks, angle_cons, edge_cons));
         }
     }
 
@@ -267,6 +294,8 @@ void MainWindow::on_button_partition_clicked(bool check ) {
     int uas_count = ui.table_view_uas->model()->rowCount();
     std::vector<std::pair<double,double> > uas_coords;
     std::vector<std::pair< std::pair<double,double> , int > > uas_coords_with_percentage;
+    // metres, 0 where the cell is empty; any above 0 remeshes the regions at them
+    std::vector<double> cell_sizes;
 
     for (int i=0; i<uas_count; i++){
 
@@ -285,6 +314,7 @@ void MainWindow::on_button_partition_clicked(bool check ) {
         coord_item_percentage.first = coord_item;
         coord_item_percentage.second = percentage;
         uas_coords_with_percentage.push_back((coord_item_percentage));
+        cell_sizes.push_back(std::max(0.0, ui.table_view_uas->model()->data(QModelIndex(ui.table_view_uas->model()->index(i, 1))).toDouble()));
 
 
         std::cout << setiosflags(std::ios::fixed | std::ios::showpoint) <<
@@ -300,7 +330,11 @@ void MainWindow::on_button_partition_clicked(bool check ) {
                   ui.check_box_borders->isChecked(),
                   ui.check_box_waypoints->isChecked());
 
-      qnode.get_tnp_update_pointer()->partition(uas_coords_with_percentage);
+      // the combo box lists the engines in the order of Tnp_update::Partitioner
+      Tnp_update::Partitioner partitioner = (Tnp_update::Partitioner) ui.combo_partitioner->currentIndex();
+      start_planning("Partitioning", boost::bind(&Tnp_update::partition, qnode.get_tnp_update_pointer(),
+                                                 uas_coords_with_percentage, partitioner,
+                                                 qnode.get_tnp_update_pointer()->get_partition_weight(), cell_sizes));
 }
 
 
@@ -319,7 +353,8 @@ void MainWindow::on_button_coverage_clicked(bool checked){
         coverage_for.first = uas;
         coverage_for.second = coords;
 
-        qnode.get_tnp_update_pointer()->path_planning_coverage(coverage_for);
+        start_planning("Coverage", boost::bind(&Tnp_update::path_planning_coverage, qnode.get_tnp_update_pointer(),
+                                               coverage_for));
     }
 }
 
@@ -331,7 +366,8 @@ void MainWindow::on_button_go_to_goal_clicked(bool checked){
     std::cout << setiosflags(std::ios::fixed | std::ios::showpoint) <<
                  std::setprecision(6) << "uas: " << uas << " lat: " << lat << " lon: " << lon << std::endl;
     if ((uas < 1) || (uas > ui.table_view_uas->model()->rowCount()) ) showGenericMessage("Please select a valid UAS");
-    else qnode.get_tnp_update_pointer()->path_planning_to_goal(uas, lat, lon);
+    else start_planning("Go to goal", boost::bind(&Tnp_update::path_planning_to_goal, qnode.get_tnp_update_pointer(),
+                                                  uas, lat, lon));
 
 }
 
@@ -373,6 +409,45 @@ void MainWindow::on_button_load_last_uas_conf_clicked(bool check){
 
 }
 
+void MainWindow::on_button_cancel_planning_clicked(bool check){
+
+    planning_thread.cancel();
+    ui.button_cancel_planning->setEnabled(false);
+    ui.progress_bar_planning->setFormat("Cancelling...");
+}
+
+// rows below the chosen severity stay in the log, they are only hidden
+void MainWindow::on_combo_log_level_currentIndexChanged(int index){
+    qnode.loggingModel()->set_minimum_level(index);
+}
+
+/*****************************************************************************
+** Implementation [Planning]
+*****************************************************************************/
+
+bool MainWindow::start_planning(const QString &stage_name, boost::function<void()> job){
+
+    if (!planning_thread.submit(stage_name, job)){
+        showGenericMessage("A planning operation is still running. Wait for it or cancel it first.");
+        return false;
+    }
+    set_planning_buttons_enabled(false);
+    ui.progress_bar_planning->setRange(0, 0);
+    ui.progress_bar_planning->setFormat(stage_name + "...");
+    qnode.log(QNode::Info, std::string("Started: ") + stage_name.toStdString());
+    return true;
+}
+
+void MainWindow::set_planning_buttons_enabled(bool enabled){
+
+    ui.button_perform_cdt->setEnabled(enabled);
+    ui.button_partition->setEnabled(enabled);
+    ui.combo_partitioner->setEnabled(enabled);
+    ui.button_coverage->setEnabled(enabled);
+    ui.button_go_to_goal->setEnabled(enabled);
+    ui.button_cancel_planning->setEnabled(!enabled);
+}
+
 /*****************************************************************************
 ** Implemenation [Slots][manually connected]
 *****************************************************************************/
@@ -386,6 +461,33 @@ void MainWindow::updateLoggingView() {
         ui.view_logging->scrollToBottom();
 }
 
+/**
+ * Signalled (queued) from the planning loops. An unknown total shows the busy indicator
+ * along with the amount of work done so far.
+ */
+void MainWindow::updatePlanningProgress(QString stage, int done, int total) {
+
+    if (total > 0){
+        ui.progress_bar_planning->setRange(0, total);
+        ui.progress_bar_planning->setValue(std::min(done, total));
+        ui.progress_bar_planning->setFormat(stage + ": %p%");
+    } else {
+        ui.progress_bar_planning->setRange(0, 0);
+        ui.progress_bar_planning->setFormat(stage + ": " + QString::number(done));
+    }
+}
+
+void MainWindow::planningFinished(QString stage_name, bool completed, QString message) {
+
+    set_planning_buttons_enabled(true);
+    ui.progress_bar_planning->setRange(0, 100);
+    ui.progress_bar_planning->setValue(completed ? 100 : 0);
+    ui.progress_bar_planning->setFormat(completed ? stage_name + ": done" : stage_name + ": aborted");
+
+    if (completed) qnode.log(QNode::Info, std::string("Finished: ") + stage_name.toStdString());
+    else qnode.log(QNode::Warn, message.toStdString());
+}
+
 /*****************************************************************************
 ** Implementation [Menu]
 *****************************************************************************/
@@ -411,6 +513,7 @@ void MainWindow::ReadSettings() {
     ui.line_edit_master->setText(master_url);
     ui.line_edit_host->setText(host_url);
     //ui.line_edit_topic->setText(topic_name);
+    ui.combo_partitioner->setCurrentIndex(settings.value("partitioner", 0).toInt());
     bool remember = settings.value("remember_settings", false).toBool();
     ui.checkbox_remember_settings->setChecked(remember);
     bool checked = settings.value("use_environment_variables", false).toBool();
@@ -431,6 +534,7 @@ void MainWindow::WriteSettings() {
     settings.setValue("geometry", saveGeometry());
     settings.setValue("windowState", saveState());
     settings.setValue("remember_settings",QVariant(ui.checkbox_remember_settings->isChecked()));
+    settings.setValue("partitioner", ui.combo_partitioner->currentIndex());
 
 }
 
@@ -0,0 +1,116 @@
+/**
+ * @file /src/mission_context.cpp
+ *
+ * @brief One named mission: its own mesh, partition, paths, publishers and action servers
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <cctype>
+#include <boost/bind.hpp>
+
+#include "../include/qtnp/logging.hpp"
+#include "../include/qtnp/mission_context.hpp"
+
+namespace qtnp {
+
+/*****************************************************************************
+** Implementation
+*****************************************************************************/
+
+Mission_context::Mission_context(const std::string &id, Thread_pool &pool) :
+    pool_ref(pool),
+    mission_id(id),
+    tnp_update(rviz_objects),
+    mission_writer(pool),
+    topic_queue(pool),
+    closing(false)
+{
+    rviz_objects.init();
+    tnp_update.set_thread_pool(&pool);
+}
+
+Mission_context::~Mission_context(){
+
+    closing = true;
+    tnp_update.cancel_job();
+    action_server.reset();
+    topic_queue.wait_idle();
+}
+
+bool Mission_context::is_valid_id(const std::string &id){
+
+    if (id.empty() || !std::isalpha((unsigned char) id[0])) return false;
+    for (int i=1; i<id.size(); i++){
+        if (!std::isalnum((unsigned char) id[i]) && (id[i] != '_')) return false;
+    }
+    return true;
+}
+
+void Mission_context::start(ros::NodeHandle &n, ros::NodeHandle &private_n){
+
+    ros::NodeHandle mission_n(n, "missions/" + mission_id);
+    edges_pub = mission_n.advertise<visualization_msgs::Marker>("visualization_marker", 10);
+    polygon_pub = mission_n.advertise<geometry_msgs::PolygonStamped>("visualization_polygon", 10);
+    triangulation_mesh_pub = mission_n.advertise<visualization_msgs::Marker>("triangulation_mesh", 300);
+    center_pub = mission_n.advertise<visualization_msgs::Marker>("center_points", 150);
+    path_pub = mission_n.advertise<nav_msgs::Path>("path_planning", 150);
+
+    // the files of the mission go below the mission directory of the node
+    mission_writer.configure(private_n);
+    mission_writer.set_directory(mission_writer.directory() + "/" + mission_id);
+
+    action_server.reset(new Planning_action_server(mission_n, tnp_update, rviz_objects, pool_ref));
+}
+
+void Mission_context::mesh_async(const std::vector<Coordinates> &placemarks){
+
+    topic_queue.post(boost::bind(&Mission_context::mesh, this, placemarks));
+}
+
+void Mission_context::mesh(std::vector<Coordinates> placemarks){
+
+    Planning_control control;
+    try {
+        Tnp_update::Planning_job job(tnp_update, control);
+        // the messages still queued, or waiting for the job, when the mission goes
+        if (closing) return;
+        tnp_update.perform_polygon_definition(placemarks, constants::angle_criterion_default, constants::edge_criterion_default);
+    } catch (const Planning_cancelled &e) {
+        QTNP_WARN(Meshing, "Mission " << mission_id << ": " << e.what());
+    }
+}
+
+bool Mission_context::publish(std::map<int, mavros_msgs::WaypointList> &waypoint_lists){
+
+    bool published(false);
+    if (rviz_objects.is_polygon_ready()){
+        polygon_pub.publish(rviz_objects.get_polygonStamped());
+        edges_pub.publish(rviz_objects.get_edges());
+        center_pub.publish(rviz_objects.get_center_points());
+        rviz_objects.set_polygon_ready(false);
+        published = true;
+    }
+    if (rviz_objects.is_planning_ready()){
+        triangulation_mesh_pub.publish(rviz_objects.get_triangulation_mesh());
+        path_pub.publish(rviz_objects.get_path());
+        waypoint_lists = tnp_update.take_updated_waypoint_lists();
+        if (!waypoint_lists.empty()) mission_writer.write_all_async(waypoint_lists);
+        rviz_objects.set_planning_ready(false);
+        published = true;
+    }
+    return published;
+}
+
+bool Mission_context::memory_usage(size_t &bytes){
+
+    if (!tnp_update.memory_usage(bytes)) return false;
+    bytes += rviz_objects.memory_bytes();
+    return true;
+}
+
+} // namespace qtnp
@@ -0,0 +1,255 @@
+/**
+ * @file /src/mission_formats.cpp
+ *
+ * @brief File formats for the exported missions
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdint.h>
+
+#include "../include/qtnp/mission_formats.hpp"
+
+/*****************************************************************************
+** Helpers [Numbers without iostreams or locales]
+*****************************************************************************/
+
+namespace {
+
+const unsigned long long powers_of_ten[] = { 1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL,
+                                             1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL };
+
+void append_uint(std::string &out, unsigned long long value){
+
+    char digits[20];
+    int count(0);
+    do {
+        digits[count++] = (char) ('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (count > 0) out += digits[--count];
+}
+
+void append_int(std::string &out, long long value){
+
+    if (value < 0){
+        out += '-';
+        append_uint(out, 0ULL - (unsigned long long) value);
+    } else {
+        append_uint(out, (unsigned long long) value);
+    }
+}
+
+// fixed point with 0..9 decimals; coordinates and mission parameters never reach the
+// printf fallback, it is only there for non finite and huge values
+void append_fixed(std::string &out, double value, int decimals){
+
+    if (decimals < 0) decimals = 0;
+    if (decimals > 9) decimals = 9;
+
+    if (!std::isfinite(value) || std::fabs(value) >= 1e9){
+        char buffer[64];
+        int length = std::snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+        if (length > 0) out.append(buffer, std::min(length, (int) sizeof(buffer) - 1));
+        return;
+    }
+
+    unsigned long long scaled = (unsigned long long) (std::fabs(value) * powers_of_ten[decimals] + 0.5);
+    unsigned long long integer_part = scaled / powers_of_ten[decimals];
+    unsigned long long fraction = scaled % powers_of_ten[decimals];
+
+    if (value < 0 && scaled != 0) out += '-';
+    append_uint(out, integer_part);
+    if (decimals > 0){
+        char digits[9];
+        for (int i = decimals - 1; i >= 0; i--){
+            digits[i] = (char) ('0' + fraction % 10);
+            fraction /= 10;
+        }
+        out += '.';
+        out.append(digits, decimals);
+    }
+}
+
+// integral values as integers, the rest with up to 7 decimals
+void append_number(std::string &out, double value){
+
+    if (std::isfinite(value) && value == std::floor(value) && std::fabs(value) < 1e15){
+        append_int(out, (long long) value);
+        return;
+    }
+    std::string::size_type start = out.size();
+    append_fixed(out, value, 7);
+    if (!std::isfinite(value) || out.find('.', start) == std::string::npos) return;
+    while (out[out.size() - 1] == '0') out.erase(out.size() - 1);
+    if (out[out.size() - 1] == '.') out.erase(out.size() - 1);
+}
+
+void append_json_number(std::string &out, double value){
+
+    if (std::isfinite(value)) append_number(out, value);
+    else out += "null";
+}
+
+void append_u8(std::string &out, unsigned int value){
+    out += (char) (value & 0xff);
+}
+
+void append_u16(std::string &out, unsigned int value){
+    append_u8(out, value);
+    append_u8(out, value >> 8);
+}
+
+void append_u32(std::string &out, uint32_t value){
+    append_u16(out, value & 0xffff);
+    append_u16(out, value >> 16);
+}
+
+void append_u64(std::string &out, uint64_t value){
+    append_u32(out, (uint32_t) (value & 0xffffffffULL));
+    append_u32(out, (uint32_t) (value >> 32));
+}
+
+void append_f32(std::string &out, float value){
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    append_u32(out, bits);
+}
+
+void append_f64(std::string &out, double value){
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    append_u64(out, bits);
+}
+
+}
+
+namespace qtnp {
+
+/*****************************************************************************
+** Implementation
+*****************************************************************************/
+
+void Qgc_wpl_format::write(const Mission_record &record, std::string &out) const {
+
+    const std::vector<mavros_msgs::Waypoint> &waypoints = record.waypoint_list.waypoints;
+    out.reserve(out.size() + 16 + waypoints.size() * 96);
+
+    out += "QGC WPL 110\n";
+    for (std::size_t i = 0; i < waypoints.size(); i++){
+        const mavros_msgs::Waypoint &waypoint = waypoints[i];
+        // seq current frame command param1..4 lat lon alt autocontinue
+        append_uint(out, i);                     out += '\t';
+        out += waypoint.is_current ? '1' : '0';  out += '\t';
+        append_uint(out, waypoint.frame);        out += '\t';
+        append_uint(out, waypoint.command);      out += '\t';
+        append_number(out, waypoint.param1);     out += '\t';
+        append_number(out, waypoint.param2);     out += '\t';
+        append_number(out, waypoint.param3);     out += '\t';
+        append_number(out, waypoint.param4);     out += '\t';
+        append_fixed(out, waypoint.x_lat, 8);    out += '\t';
+        append_fixed(out, waypoint.y_long, 8);   out += '\t';
+        append_number(out, waypoint.z_alt);      out += '\t';
+        out += waypoint.autocontinue ? '1' : '0';
+        out += '\n';
+    }
+}
+
+void Qgc_plan_format::write(const Mission_record &record, std::string &out) const {
+
+    const std::vector<mavros_msgs::Waypoint> &waypoints = record.waypoint_list.waypoints;
+    out.reserve(out.size() + 512 + waypoints.size() * 160);
+
+    out += "{\n"
+           "    \"fileType\": \"Plan\",\n"
+           "    \"geoFence\": { \"circles\": [], \"polygons\": [], \"version\": 2 },\n"
+           "    \"groundStation\": \"qtnp\",\n"
+           "    \"mission\": {\n"
+           "        \"cruiseSpeed\": 15,\n"
+           "        \"firmwareType\": 3,\n"
+           "        \"hoverSpeed\": 5,\n"
+           "        \"items\": [";
+
+    // waypoint 0 is the home position, not a mission item
+    for (std::size_t i = 1; i < waypoints.size(); i++){
+        const mavros_msgs::Waypoint &waypoint = waypoints[i];
+        out += (i == 1) ? "\n" : ",\n";
+        out += "            { \"autoContinue\": ";
+        out += waypoint.autocontinue ? "true" : "false";
+        out += ", \"command\": ";
+        append_uint(out, waypoint.command);
+        out += ", \"doJumpId\": ";
+        append_uint(out, i);
+        out += ", \"frame\": ";
+        append_uint(out, waypoint.frame);
+        out += ", \"params\": [";
+        append_json_number(out, waypoint.param1);  out += ", ";
+        append_json_number(out, waypoint.param2);  out += ", ";
+        append_json_number(out, waypoint.param3);  out += ", ";
+        append_json_number(out, waypoint.param4);  out += ", ";
+        append_fixed(out, waypoint.x_lat, 8);      out += ", ";
+        append_fixed(out, waypoint.y_long, 8);     out += ", ";
+        append_json_number(out, waypoint.z_alt);
+        out += "], \"type\": \"SimpleItem\" }";
+    }
+
+    out += "\n        ],\n"
+           "        \"plannedHomePosition\": [";
+    if (!waypoints.empty()){
+        append_fixed(out, waypoints[0].x_lat, 8);   out += ", ";
+        append_fixed(out, waypoints[0].y_long, 8);  out += ", ";
+        append_json_number(out, waypoints[0].z_alt);
+    } else {
+        out += "0, 0, 0";
+    }
+    out += "],\n"
+           "        \"vehicleType\": 1,\n"
+           "        \"version\": 2\n"
+           "    },\n"
+           "    \"rallyPoints\": { \"points\": [], \"version\": 2 },\n"
+           "    \"version\": 1\n"
+           "}\n";
+}
+
+void Binary_mission_format::write(const Mission_record &record, std::string &out) const {
+
+    const std::vector<mavros_msgs::Waypoint> &waypoints = record.waypoint_list.waypoints;
+    out.reserve(out.size() + 20 + waypoints.size() * 40);
+
+    out.append("QTNPMSN1", 8);
+    append_u32(out, version);
+    append_u32(out, (uint32_t) record.uas_id);
+    append_u32(out, (uint32_t) waypoints.size());
+
+    for (std::size_t i = 0; i < waypoints.size(); i++){
+        const mavros_msgs::Waypoint &waypoint = waypoints[i];
+        append_u8(out, waypoint.frame);
+        append_u16(out, waypoint.command);
+        append_u8(out, (waypoint.is_current ? 1 : 0) | (waypoint.autocontinue ? 2 : 0));
+        append_f32(out, waypoint.param1);
+        append_f32(out, waypoint.param2);
+        append_f32(out, waypoint.param3);
+        append_f32(out, waypoint.param4);
+        append_f64(out, waypoint.x_lat);
+        append_f64(out, waypoint.y_long);
+        append_f32(out, waypoint.z_alt);
+    }
+}
+
+boost::shared_ptr<Mission_format> make_mission_format(const std::string &name){
+
+    if (name == "wpl") return boost::shared_ptr<Mission_format>(new Qgc_wpl_format);
+    if (name == "plan") return boost::shared_ptr<Mission_format>(new Qgc_plan_format);
+    if (name == "bin") return boost::shared_ptr<Mission_format>(new Binary_mission_format);
+    return boost::shared_ptr<Mission_format>();
+}
+
+} // namespace qtnp
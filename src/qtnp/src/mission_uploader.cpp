@@ -0,0 +1,130 @@
+/**
+ * @file /src/mission_uploader.cpp
+ *
+ * @brief Asynchronous upload of the waypoint lists to the mavros instance of each UAS
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <sstream>
+#include <boost/bind.hpp>
+
+#include "../include/qtnp/mission_uploader.hpp"
+
+#include "mavros_msgs/WaypointPush.h"
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Implementation
+*****************************************************************************/
+
+Mission_uploader::Mission_uploader(Thread_pool &pool) : pool_ref(pool) {
+
+    settings.service_timeout = 5.0;
+    settings.retries = 2;
+    settings.retry_delay = 1.0;
+    settings.namespace_prefix = "/uas";
+}
+
+Mission_uploader::~Mission_uploader(){
+
+    // the jobs still queued use this uploader, they have to be through before it goes
+    std::vector<boost::shared_ptr<Serial_queue> > queues;
+    {
+        boost::lock_guard<boost::mutex> lock(queues_mutex);
+        for (std::map<int, boost::shared_ptr<Serial_queue> >::iterator it = vehicle_queues.begin(); it != vehicle_queues.end(); ++it){
+            queues.push_back(it->second);
+        }
+    }
+    for (int i=0; i<queues.size(); i++) queues[i]->wait_idle();
+}
+
+void Mission_uploader::configure(ros::NodeHandle &private_n){
+
+    private_n.param("upload_service_timeout", settings.service_timeout, settings.service_timeout);
+    private_n.param("upload_retries", settings.retries, settings.retries);
+    private_n.param("upload_retry_delay", settings.retry_delay, settings.retry_delay);
+    private_n.param("mavros_namespace_prefix", settings.namespace_prefix, settings.namespace_prefix);
+    private_n.getParam("mavros_namespaces", settings.mavros_namespaces);
+}
+
+std::string Mission_uploader::mavros_namespace(int uas_id){
+
+    if ( (uas_id >= 1) && (uas_id <= (int) settings.mavros_namespaces.size()) ){
+        return settings.mavros_namespaces[uas_id - 1];
+    }
+    std::stringstream ns;
+    ns << settings.namespace_prefix << uas_id << "/mavros";
+    return ns.str();
+}
+
+Serial_queue &Mission_uploader::vehicle_queue(int uas_id){
+
+    boost::lock_guard<boost::mutex> lock(queues_mutex);
+    boost::shared_ptr<Serial_queue> &queue = vehicle_queues[uas_id];
+    if (!queue) queue.reset(new Serial_queue(pool_ref));
+    return *queue;
+}
+
+void Mission_uploader::upload_async(int uas_id, const mavros_msgs::WaypointList &waypoint_list){
+
+    vehicle_queue(uas_id).post(boost::bind(&Mission_uploader::upload, this, uas_id, waypoint_list));
+}
+
+void Mission_uploader::upload_all_async(const std::map<int, mavros_msgs::WaypointList> &waypoint_lists){
+
+    for (std::map<int, mavros_msgs::WaypointList>::const_iterator it = waypoint_lists.begin();
+         it != waypoint_lists.end(); it++){
+        upload_async(it->first, it->second);
+    }
+}
+
+// runs on a pool thread
+void Mission_uploader::upload(int uas_id, mavros_msgs::WaypointList waypoint_list){
+
+    std::string service_name = mavros_namespace(uas_id) + "/mission/push";
+    std::stringstream message;
+    bool success(false);
+
+    mavros_msgs::WaypointPush push_srv;
+    push_srv.request.waypoints = waypoint_list.waypoints;
+
+    for (int attempt = 0; attempt <= settings.retries && !success && ros::ok(); attempt++){
+
+        if (attempt > 0) ros::Duration(settings.retry_delay).sleep();
+
+        message.str("");
+        if (!ros::service::waitForService(service_name, ros::Duration(settings.service_timeout))){
+            message << service_name << " not available after " << settings.service_timeout << " s";
+            continue;
+        }
+
+        // mavros answers once the mission protocol with the autopilot is done (or timed out there)
+        ros::ServiceClient client = ros::NodeHandle().serviceClient<mavros_msgs::WaypointPush>(service_name);
+        ros::WallTime started = ros::WallTime::now();
+        if (!client.call(push_srv)){
+            message << "call to " << service_name << " failed";
+        } else if (!push_srv.response.success){
+            message << service_name << " rejected the mission, " << push_srv.response.wp_transfered
+                    << " of " << waypoint_list.waypoints.size() << " waypoints transfered";
+        } else {
+            success = true;
+            message << "uploaded " << push_srv.response.wp_transfered << " waypoints to " << service_name
+                    << " in " << (ros::WallTime::now() - started).toSec() << " s";
+        }
+    }
+
+    if (!success) message << " (giving up after " << settings.retries + 1 << " attempts)";
+    if (on_result) on_result(uas_id, success, message.str());
+}
+
+} // namespace qtnp
@@ -0,0 +1,180 @@
+/**
+ * @file /src/mission_writer.cpp
+ *
+ * @brief Writes the produced missions to disk in the background
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <ctime>
+#include <sstream>
+#include <boost/bind.hpp>
+
+#include "../include/qtnp/file_utilities.hpp"
+#include "../include/qtnp/mission_writer.hpp"
+
+/*****************************************************************************
+** Helpers
+*****************************************************************************/
+
+namespace {
+
+// YYYY-MM-DD_HH-MM-SS, no colons so the names are valid everywhere
+std::string current_stamp(){
+
+    time_t now = time(0);
+    struct tm local;
+    localtime_r(&now, &local);
+    char buffer[32];
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d_%H-%M-%S", &local);
+    return buffer;
+}
+
+}
+
+namespace qtnp {
+
+/*****************************************************************************
+** Implementation
+*****************************************************************************/
+
+Mission_writer::Mission_writer(Thread_pool &pool) :
+    pool_ref(pool),
+    enabled(true),
+    mission_directory(files::ros_home_path("missions")),
+    sequence(0)
+{
+    formats.push_back(make_mission_format("wpl"));
+}
+
+Mission_writer::~Mission_writer(){
+
+    // the jobs still queued use this writer, they have to be through before it goes
+    std::vector<boost::shared_ptr<Serial_queue> > queues;
+    {
+        boost::lock_guard<boost::mutex> lock(queues_mutex);
+        for (std::map<int, boost::shared_ptr<Serial_queue> >::iterator it = vehicle_queues.begin(); it != vehicle_queues.end(); ++it){
+            queues.push_back(it->second);
+        }
+    }
+    for (int i=0; i<queues.size(); i++) queues[i]->wait_idle();
+}
+
+void Mission_writer::configure(ros::NodeHandle &private_n){
+
+    bool write_missions;
+    std::string directory;
+    std::vector<std::string> format_names;
+
+    private_n.param("write_missions", write_missions, true);
+    private_n.param("mission_directory", directory, files::ros_home_path("missions"));
+    if (!private_n.getParam("mission_formats", format_names)) format_names.push_back("wpl");
+
+    format_list configured;
+    for (std::size_t i = 0; i < format_names.size(); i++){
+        boost::shared_ptr<Mission_format> format = make_mission_format(format_names[i]);
+        if (format) configured.push_back(format);
+        else ROS_WARN_STREAM("Unknown mission format '" << format_names[i] << "', expected wpl, plan or bin");
+    }
+
+    boost::lock_guard<boost::mutex> lock(settings_mutex);
+    enabled = write_missions;
+    mission_directory = files::expand_home(directory);
+    formats.swap(configured);
+}
+
+void Mission_writer::set_directory(const std::string &directory){
+
+    boost::lock_guard<boost::mutex> lock(settings_mutex);
+    mission_directory = files::expand_home(directory);
+}
+
+std::string Mission_writer::directory(){
+
+    boost::lock_guard<boost::mutex> lock(settings_mutex);
+    return mission_directory;
+}
+
+void Mission_writer::add_format(boost::shared_ptr<Mission_format> format){
+
+    boost::lock_guard<boost::mutex> lock(settings_mutex);
+    if (format) formats.push_back(format);
+}
+
+void Mission_writer::clear_formats(){
+
+    boost::lock_guard<boost::mutex> lock(settings_mutex);
+    formats.clear();
+}
+
+bool Mission_writer::is_enabled(){
+
+    boost::lock_guard<boost::mutex> lock(settings_mutex);
+    return enabled && !formats.empty();
+}
+
+Serial_queue &Mission_writer::vehicle_queue(int uas_id){
+
+    boost::lock_guard<boost::mutex> lock(queues_mutex);
+    boost::shared_ptr<Serial_queue> &queue = vehicle_queues[uas_id];
+    if (!queue) queue.reset(new Serial_queue(pool_ref));
+    return *queue;
+}
+
+void Mission_writer::write_async(int uas_id, const mavros_msgs::WaypointList &waypoint_list){
+
+    Mission_record record;
+    record.uas_id = uas_id;
+    record.stamp = current_stamp();
+    record.waypoint_list = waypoint_list;
+
+    format_list job_formats;
+    std::string job_directory;
+    {
+        boost::lock_guard<boost::mutex> lock(settings_mutex);
+        if (!enabled || formats.empty()) return;
+        record.sequence = ++sequence;
+        job_formats = formats;
+        job_directory = mission_directory;
+    }
+
+    vehicle_queue(uas_id).post(boost::bind(&Mission_writer::write, this, record, job_formats, job_directory));
+}
+
+void Mission_writer::write_all_async(const std::map<int, mavros_msgs::WaypointList> &waypoint_lists){
+
+    for (std::map<int, mavros_msgs::WaypointList>::const_iterator it = waypoint_lists.begin();
+         it != waypoint_lists.end(); it++){
+        write_async(it->first, it->second);
+    }
+}
+
+// runs on a pool thread
+void Mission_writer::write(Mission_record record, format_list job_formats, std::string directory){
+
+    std::string error;
+    if (!files::make_directories(directory, error)){
+        if (on_result) on_result(record.uas_id, false, error);
+        return;
+    }
+
+    std::stringstream base_name;
+    base_name << directory << "/mission_uas" << record.uas_id << "_" << record.stamp << "_" << record.sequence;
+
+    std::string content;
+    for (std::size_t i = 0; i < job_formats.size(); i++){
+
+        content.clear();
+        job_formats[i]->write(record, content);
+
+        std::string path = base_name.str() + job_formats[i]->extension();
+        bool success = files::write_file(path, content, false, error);
+        if (on_result) on_result(record.uas_id, success, success ? "wrote " + path : error);
+    }
+}
+
+} // namespace qtnp
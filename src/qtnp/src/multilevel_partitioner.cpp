@@ -0,0 +1,645 @@
+/**
+ * @file /src/multilevel_partitioner.cpp
+ *
+ * @brief Multilevel k-way partitioning of the cell graph
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <random>
+
+#include "../include/qtnp/multilevel_partitioner.hpp"
+
+/*****************************************************************************
+** Helpers
+*****************************************************************************/
+
+namespace {
+
+// the coarsening stops at about this many vertices per part
+const int coarsest_vertices_per_part(20);
+// or when a level is hardly smaller than the one before
+const double least_coarsening(0.95);
+// a part may go this much over its target weight (plus one vertex)
+const double imbalance_tolerance(1.03);
+const int refine_passes(4);
+const int coarsest_refine_passes(50);
+// hand overs along chains of parts at most, per part
+const int settle_rounds_per_part(10);
+// a move is only taken when the part it leaves is seen to stay connected within this many vertices
+const int connectivity_budget(64);
+
+struct Is_assigned
+{
+    Is_assigned(const std::vector<int> &assignment) : part(assignment) { }
+
+    bool operator () (int v) const
+    {
+        return (part[v] >= 0);
+    }
+
+    const std::vector<int> &part;
+};
+
+// v joins part p; conn[p * n + u] is the edge weight from an unassigned u to part p
+void take(const qtnp::Partition_graph &graph, int v, int p, std::vector<int> &part, std::vector<double> &weight,
+          std::vector<int> &conn, std::vector<std::vector<int> > &frontier){
+
+    int n = graph.size();
+    part[v] = p;
+    weight[p] += graph.vwgt[v];
+    for (int e = graph.xadj[v]; e < graph.xadj[v + 1]; e++){
+        int u = graph.adjncy[e];
+        if (part[u] >= 0) continue;
+        if (conn[p * n + u] == 0) frontier[p].push_back(u);
+        conn[p * n + u] += graph.adjwgt[e];
+    }
+}
+
+// true if the neighbours of v in part from still reach each other without v. The search
+// stays near v and gives up (false) past the budget, a move that can't be checked isn't made
+bool keeps_connected(const qtnp::Partition_graph &graph, const std::vector<int> &part, int v, int from,
+                     std::vector<int> &seen, int &stamp, std::vector<int> &queue){
+
+    int targets(0), first(-1);
+    stamp++;
+    for (int e = graph.xadj[v]; e < graph.xadj[v + 1]; e++){
+        int u = graph.adjncy[e];
+        if ((part[u] != from) || (seen[u] == -stamp)) continue;
+        seen[u] = -stamp;  // still to be reached
+        if (first < 0) first = u;
+        targets++;
+    }
+    if (targets <= 1) return true;
+
+    queue.clear();
+    queue.push_back(first);
+    seen[first] = stamp;
+    targets--;
+    for (int head = 0; (head < queue.size()) && (head < connectivity_budget); head++){
+        int u = queue[head];
+        for (int e = graph.xadj[u]; e < graph.xadj[u + 1]; e++){
+            int x = graph.adjncy[e];
+            if ((x == v) || (part[x] != from) || (seen[x] == stamp)) continue;
+            if (seen[x] == -stamp) {
+                if (--targets == 0) return true;
+            }
+            seen[x] = stamp;
+            queue.push_back(x);
+        }
+    }
+    return false;
+}
+
+// true if v is the last vertex of part from next to the pinned vertex of from, taking it
+// would leave the pinned vertex with no way out of its part
+bool holds_pin(const qtnp::Partition_graph &graph, const std::vector<int> &part, const std::vector<int> &pin, int v, int from){
+
+    for (int e = graph.xadj[v]; e < graph.xadj[v + 1]; e++){
+        int u = graph.adjncy[e];
+        if (pin[u] != from) continue;
+        bool other(false);
+        for (int f = graph.xadj[u]; (f < graph.xadj[u + 1]) && !other; f++){
+            int x = graph.adjncy[f];
+            other = (x != v) && (part[x] == from);
+        }
+        if (!other) return true;
+    }
+    return false;
+}
+
+}
+
+namespace qtnp {
+
+/*****************************************************************************
+** Implementation
+*****************************************************************************/
+
+std::vector<int> Multilevel_partitioner::partition(const Partition_graph &graph, const std::vector<double> &targets,
+                                                   const std::vector<int> &pinned){
+
+    int n = graph.size();
+    if (targets.empty() || (n == 0)) return std::vector<int>(n, 0);
+
+    std::vector<int> pin;
+    set_targets(graph, targets, pinned, pin);
+    double total(0);
+    for (int v=0; v<n; v++) total += graph.vwgt[v];
+
+    // levels[0] is the graph itself, coarse_of[l] maps the vertices of level l to level l + 1
+    std::vector<Partition_graph> levels(1, graph);
+    std::vector<std::vector<int> > pins(1, pin);
+    std::vector<std::vector<int> > coarse_of;
+    int coarsest = std::max(coarsest_vertices_per_part * parts, 2 * coarsest_vertices_per_part);
+    int max_vertex_weight = std::max(1, (int) (1.5 * total / coarsest));
+
+    while (levels.back().size() > coarsest){
+        planning_control.checkpoint("Coarsening", levels.size(), 0);
+        Partition_graph coarse;
+        std::vector<int> map, coarse_pin;
+        coarsen(levels.back(), pins.back(), max_vertex_weight, coarse, map, coarse_pin);
+        if (coarse.size() > least_coarsening * levels.back().size()) break;
+        levels.push_back(Partition_graph());
+        levels.back().xadj.swap(coarse.xadj);
+        levels.back().adjncy.swap(coarse.adjncy);
+        levels.back().adjwgt.swap(coarse.adjwgt);
+        levels.back().vwgt.swap(coarse.vwgt);
+        pins.push_back(coarse_pin);
+        coarse_of.push_back(map);
+    }
+
+    std::vector<int> part;
+    grow(levels.back(), pins.back(), part);
+    // the growing leaves the parts uneven when the pins are close together, the coarsest
+    // level is cheap to even out
+    refine(levels.back(), pins.back(), part, coarsest_refine_passes);
+
+    for (int l = (int) levels.size() - 2; l >= 0; l--){
+        planning_control.checkpoint("Refining partitions", levels.size() - 1 - l, levels.size() - 1);
+        std::vector<int> finer(levels[l].size());
+        for (int v=0; v<finer.size(); v++) finer[v] = part[coarse_of[l][v]];
+        part.swap(finer);
+        refine(levels[l], pins[l], part, refine_passes);
+    }
+
+    reconnect(graph, pin, part);
+    // close together pins box some parts in, which the boundary moves can't make up for
+    settle(graph, pin, part);
+    return part;
+}
+
+void Multilevel_partitioner::balance(const Partition_graph &graph, const std::vector<double> &targets,
+                                     const std::vector<int> &pinned, std::vector<int> &part, int passes){
+
+    if (targets.empty() || (graph.size() == 0)) return;
+
+    std::vector<int> pin;
+    set_targets(graph, targets, pinned, pin);
+    refine(graph, pin, part, passes);
+    settle(graph, pin, part);
+}
+
+void Multilevel_partitioner::set_targets(const Partition_graph &graph, const std::vector<double> &targets,
+                                         const std::vector<int> &pinned, std::vector<int> &pin){
+
+    parts = targets.size();
+    int n = graph.size();
+
+    double total(0), shares(0);
+    for (int v=0; v<n; v++) total += graph.vwgt[v];
+    for (int p=0; p<parts; p++) shares += std::max(0.0, targets[p]);
+    target_weight.resize(parts);
+    for (int p=0; p<parts; p++){
+        target_weight[p] = (shares > 0) ? total * std::max(0.0, targets[p]) / shares : total / parts;
+    }
+
+    pin.assign(n, -1);
+    for (int p=0; p<parts; p++){
+        if ((p < pinned.size()) && (pinned[p] >= 0) && (pinned[p] < n) && (pin[pinned[p]] < 0)) pin[pinned[p]] = p;
+    }
+}
+
+// Heavy edge matching: every vertex, in a fixed shuffled order, is merged with the unmatched
+// neighbour it shares the heaviest edge with. Two pinned vertices never merge, so the pins
+// survive to the coarsest level, and no merged vertex gets heavier than max_vertex_weight.
+void Multilevel_partitioner::coarsen(const Partition_graph &fine, const std::vector<int> &fine_pin, int max_vertex_weight,
+                                     Partition_graph &coarse, std::vector<int> &coarse_of, std::vector<int> &coarse_pin){
+
+    int n = fine.size();
+    std::vector<int> order(n);
+    for (int v=0; v<n; v++) order[v] = v;
+    std::mt19937 rng(n);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    std::vector<int> match(n, -1);
+    for (int i=0; i<n; i++){
+        int u = order[i];
+        if (match[u] >= 0) continue;
+        int best(-1), best_weight(-1);
+        for (int e = fine.xadj[u]; e < fine.xadj[u + 1]; e++){
+            int v = fine.adjncy[e];
+            if ((v == u) || (match[v] >= 0)) continue;
+            if ((fine_pin[u] >= 0) && (fine_pin[v] >= 0)) continue;
+            if (fine.vwgt[u] + fine.vwgt[v] > max_vertex_weight) continue;
+            if (fine.adjwgt[e] > best_weight){
+                best = v;
+                best_weight = fine.adjwgt[e];
+            }
+        }
+        if (best >= 0){
+            match[u] = best;
+            match[best] = u;
+        } else {
+            match[u] = u;
+        }
+    }
+
+    coarse_of.assign(n, -1);
+    std::vector<int> first, second;
+    for (int u=0; u<n; u++){
+        if (coarse_of[u] >= 0) continue;
+        coarse_of[u] = first.size();
+        coarse_of[match[u]] = first.size();
+        first.push_back(u);
+        second.push_back(match[u]);
+    }
+
+    int cn = first.size();
+    coarse.xadj.assign(1, 0);
+    coarse.adjncy.clear();
+    coarse.adjwgt.clear();
+    coarse.vwgt.assign(cn, 0);
+    coarse_pin.assign(cn, -1);
+    std::vector<int> slot(cn, -1);
+
+    for (int c=0; c<cn; c++){
+        int members[2] = { first[c], second[c] };
+        int count = (first[c] == second[c]) ? 1 : 2;
+        int row_start = coarse.adjncy.size();
+        for (int m=0; m<count; m++){
+            int u = members[m];
+            coarse.vwgt[c] += fine.vwgt[u];
+            coarse_pin[c] = std::max(coarse_pin[c], fine_pin[u]);
+            for (int e = fine.xadj[u]; e < fine.xadj[u + 1]; e++){
+                int d = coarse_of[fine.adjncy[e]];
+                if (d == c) continue;
+                if (slot[d] < 0){
+                    slot[d] = coarse.adjncy.size();
+                    coarse.adjncy.push_back(d);
+                    coarse.adjwgt.push_back(fine.adjwgt[e]);
+                } else {
+                    coarse.adjwgt[slot[d]] += fine.adjwgt[e];
+                }
+            }
+        }
+        for (int e = row_start; e < coarse.adjncy.size(); e++) slot[coarse.adjncy[e]] = -1;
+        coarse.xadj.push_back(coarse.adjncy.size());
+    }
+}
+
+// Graph growing on the coarsest level: the part furthest below its target takes the
+// frontier vertex most connected to it, until the parts are full or can't grow any more.
+// A part without a pinned vertex starts from the vertex farthest from the others.
+void Multilevel_partitioner::grow(const Partition_graph &graph, const std::vector<int> &pin, std::vector<int> &part){
+
+    int n = graph.size();
+    part.assign(n, -1);
+    std::vector<double> weight(parts, 0);
+    std::vector<int> conn(parts * n, 0);
+    std::vector<std::vector<int> > frontier(parts);
+    std::vector<bool> seeded(parts, false);
+
+    for (int v=0; v<n; v++){
+        if (pin[v] < 0) continue;
+        take(graph, v, pin[v], part, weight, conn, frontier);
+        seeded[pin[v]] = true;
+    }
+
+    for (int p=0; p<parts; p++){
+        if (seeded[p]) continue;
+        std::vector<int> distance(n, -1);
+        std::deque<int> queue;
+        for (int v=0; v<n; v++){
+            if (part[v] >= 0){
+                distance[v] = 0;
+                queue.push_back(v);
+            }
+        }
+        int farthest(-1);
+        while (!queue.empty()){
+            int v = queue.front();
+            queue.pop_front();
+            if (part[v] < 0) farthest = v;
+            for (int e = graph.xadj[v]; e < graph.xadj[v + 1]; e++){
+                int u = graph.adjncy[e];
+                if (distance[u] >= 0) continue;
+                distance[u] = distance[v] + 1;
+                queue.push_back(u);
+            }
+        }
+        for (int v=0; (v<n) && (farthest < 0); v++){
+            if (part[v] < 0) farthest = v;
+        }
+        if (farthest < 0) break;
+        take(graph, farthest, p, part, weight, conn, frontier);
+        seeded[p] = true;
+    }
+
+    for (;;){
+        int best_part(-1);
+        for (int p=0; p<parts; p++){
+            std::vector<int> &edge = frontier[p];
+            edge.erase(std::remove_if(edge.begin(), edge.end(), Is_assigned(part)), edge.end());
+            if (edge.empty() || (weight[p] >= target_weight[p])) continue;
+            if ((best_part < 0) || (weight[p] - target_weight[p] < weight[best_part] - target_weight[best_part])) best_part = p;
+        }
+        if (best_part < 0) break;
+
+        std::vector<int> &edge = frontier[best_part];
+        int best = edge[0];
+        for (int i=1; i<edge.size(); i++){
+            if (conn[best_part * n + edge[i]] > conn[best_part * n + best]) best = edge[i];
+        }
+        take(graph, best, best_part, part, weight, conn, frontier);
+    }
+
+    // what is left joins the neighbouring part furthest below its target; a piece no part
+    // reached starts in the lightest part and is then taken in from there
+    for (;;){
+        bool changed(false);
+        for (int v=0; v<n; v++){
+            if (part[v] >= 0) continue;
+            int best_part(-1);
+            for (int e = graph.xadj[v]; e < graph.xadj[v + 1]; e++){
+                int p = part[graph.adjncy[e]];
+                if ((p >= 0) && ((best_part < 0) || (weight[p] - target_weight[p] < weight[best_part] - target_weight[best_part]))){
+                    best_part = p;
+                }
+            }
+            if (best_part < 0) continue;
+            take(graph, v, best_part, part, weight, conn, frontier);
+            changed = true;
+        }
+        if (changed) continue;
+
+        int stranded(-1);
+        for (int v=0; (v<n) && (stranded < 0); v++){
+            if (part[v] < 0) stranded = v;
+        }
+        if (stranded < 0) break;
+        int lightest(0);
+        for (int p=1; p<parts; p++){
+            if (weight[p] - target_weight[p] < weight[lightest] - target_weight[lightest]) lightest = p;
+        }
+        take(graph, stranded, lightest, part, weight, conn, frontier);
+    }
+}
+
+// Greedy k-way boundary refinement: a boundary vertex moves to the neighbouring part that
+// cuts the most edge weight, if that part has room for it. A zero gain move is taken when
+// it evens out the weights. An overweight part gives away its boundary at any gain and an
+// underweight one takes in its neighbours' boundary, so a part boxed in by the others
+// pulls cells through them, one layer per pass. No move splits the part it leaves, so the parts grown connected stay connected.
+void Multilevel_partitioner::refine(const Partition_graph &graph, const std::vector<int> &pin, std::vector<int> &part, int passes){
+
+    int n = graph.size();
+    std::vector<double> weight(parts, 0);
+    int heaviest(0);
+    for (int v=0; v<n; v++){
+        if (part[v] >= 0) weight[part[v]] += graph.vwgt[v];
+        heaviest = std::max(heaviest, graph.vwgt[v]);
+    }
+    allowed_weight.resize(parts);
+    least_weight.resize(parts);
+    for (int p=0; p<parts; p++){
+        allowed_weight[p] = target_weight[p] * imbalance_tolerance + heaviest;
+        least_weight[p] = target_weight[p] / imbalance_tolerance - heaviest;
+    }
+
+    std::vector<int> conn(parts, 0);
+    std::vector<int> touched, queue;
+    std::vector<int> seen(n, 0);
+    int stamp(0);
+
+    for (int pass=0; pass<passes; pass++){
+        int moves(0);
+        for (int v=0; v<n; v++){
+            // a vertex of no part (balance() on a partition that left some out) stays out
+            if ((pin[v] >= 0) || (part[v] < 0)) continue;
+            int from = part[v];
+            touched.clear();
+            for (int e = graph.xadj[v]; e < graph.xadj[v + 1]; e++){
+                int p = part[graph.adjncy[e]];
+                if (p < 0) continue;
+                if (conn[p] == 0) touched.push_back(p);
+                conn[p] += graph.adjwgt[e];
+            }
+
+            int w = graph.vwgt[v];
+            bool overweight = weight[from] > allowed_weight[from];
+            int best(-1), best_gain(0);
+            for (int i=0; i<touched.size(); i++){
+                int to = touched[i];
+                if ((to == from) || (weight[to] + w > allowed_weight[to])) continue;
+                int gain = conn[to] - conn[from];
+                bool evens_out = (weight[to] + w - target_weight[to]) < (weight[from] - target_weight[from]);
+                bool underweight = weight[to] < least_weight[to];
+                if (!overweight && !((gain > 0) || (((gain == 0) || underweight) && evens_out))) continue;
+                if ((best < 0) || (gain > best_gain) ||
+                    ((gain == best_gain) && (weight[to] - target_weight[to] < weight[best] - target_weight[best]))){
+                    best = to;
+                    best_gain = gain;
+                }
+            }
+            for (int i=0; i<touched.size(); i++) conn[touched[i]] = 0;
+
+            if ((best >= 0) && !holds_pin(graph, part, pin, v, from) && keeps_connected(graph, part, v, from, seen, stamp, queue)){
+                part[v] = best;
+                weight[from] -= w;
+                weight[best] += w;
+                moves++;
+            }
+        }
+        if (moves == 0) break;
+    }
+}
+
+// Evens the parts out to the tolerance where the boundary moves stall, a part boxed in by full
+// ones can only grow through them: the part furthest off its target trades with the nearest part
+// off the other way, counted in parts crossed, and every part in between passes the same weight
+// on. A pair that can't hand over most of what is asked is left out of the chains until a
+// chain goes through.
+void Multilevel_partitioner::settle(const Partition_graph &graph, const std::vector<int> &pin, std::vector<int> &part){
+
+    int n = graph.size();
+    std::vector<double> weight(parts, 0);
+    int heaviest(0);
+    for (int v=0; v<n; v++){
+        if (part[v] >= 0) weight[part[v]] += graph.vwgt[v];
+        heaviest = std::max(heaviest, graph.vwgt[v]);
+    }
+
+    std::vector<bool> blocked(parts * parts, false);
+    std::vector<int> seen(n, 0), offered(n, 0), queue, frontier;
+    int stamp(0), offer(0);
+
+    for (int round=0; round < settle_rounds_per_part * parts; round++){
+        planning_control.checkpoint("Balancing", round, settle_rounds_per_part * parts);
+
+        // the parts out of the tolerance, furthest first
+        std::vector<std::pair<double, int> > off;
+        for (int p=0; p<parts; p++){
+            if (!(target_weight[p] > 0)) continue;
+            if ( (weight[p] > target_weight[p] * imbalance_tolerance + heaviest) ||
+                 (weight[p] < target_weight[p] / imbalance_tolerance - heaviest) ){
+                off.push_back(std::make_pair(-std::fabs(weight[p] - target_weight[p]) / target_weight[p], p));
+            }
+        }
+        if (off.empty()) break;
+        std::sort(off.begin(), off.end());
+
+        // which parts border which, over the pairs still worth trying
+        std::vector<bool> borders(parts * parts, false);
+        for (int v=0; v<n; v++){
+            if (part[v] < 0) continue;
+            for (int e = graph.xadj[v]; e < graph.xadj[v + 1]; e++){
+                int p = part[graph.adjncy[e]];
+                if ((p >= 0) && (p != part[v])) borders[part[v] * parts + p] = true;
+            }
+        }
+
+        // a chain from the first of them that has one
+        std::vector<int> chain;
+        for (int i=0; (i<off.size()) && chain.empty(); i++){
+            int start = off[i].second;
+            bool giving = weight[start] > target_weight[start];
+            std::vector<int> previous(parts, -1);
+            std::deque<int> reached(1, start);
+            previous[start] = start;
+            int end(-1);
+            while (!reached.empty() && (end < 0)){
+                int p = reached.front();
+                reached.pop_front();
+                for (int q=0; q<parts; q++){
+                    if (previous[q] >= 0) continue;
+                    // the weight flows from the giving end to the taking one
+                    int from = giving ? p : q, to = giving ? q : p;
+                    if (!borders[from * parts + to] || blocked[from * parts + to]) continue;
+                    previous[q] = p;
+                    // the far end has more than a vertex to trade
+                    if ((giving ? target_weight[q] - weight[q] : weight[q] - target_weight[q]) > heaviest){
+                        end = q;
+                        break;
+                    }
+                    reached.push_back(q);
+                }
+            }
+            if (end < 0) continue;
+            for (int p = end; p != start; p = previous[p]) chain.push_back(p);
+            chain.push_back(start);
+            // the first part gives, the last takes
+            if (giving) std::reverse(chain.begin(), chain.end());
+        }
+        if (chain.empty()) break;
+
+        int giver = chain.front(), taker = chain.back();
+        double amount = std::min(weight[giver] - target_weight[giver], target_weight[taker] - weight[taker]);
+        bool through(true);
+        // from the taking end, so a hand over that falls short leaves the parts before it alone
+        for (int k = (int) chain.size() - 1; (k > 0) && (amount > 0); k--){
+            int from = chain[k-1], to = chain[k];
+            // the vertices of from next to to, then theirs, nearest the border first. One that
+            // can't go is offered again when a neighbour goes, the tip of a thin arm comes first
+            offer++;
+            frontier.clear();
+            for (int v=0; v<n; v++){
+                if (part[v] != from) continue;
+                for (int e = graph.xadj[v]; e < graph.xadj[v + 1]; e++){
+                    if (part[graph.adjncy[e]] != to) continue;
+                    offered[v] = offer;
+                    frontier.push_back(v);
+                    break;
+                }
+            }
+            double moved(0);
+            for (int head=0; (head < frontier.size()) && (moved < amount); head++){
+                int v = frontier[head];
+                int w = graph.vwgt[v];
+                offered[v] = 0;
+                if ((pin[v] >= 0) || (weight[from] - w <= 0) || holds_pin(graph, part, pin, v, from) ||
+                    !keeps_connected(graph, part, v, from, seen, stamp, queue)) continue;
+                part[v] = to;
+                weight[from] -= w;
+                weight[to] += w;
+                moved += w;
+                for (int e = graph.xadj[v]; e < graph.xadj[v + 1]; e++){
+                    int u = graph.adjncy[e];
+                    if ((part[u] != from) || (offered[u] == offer)) continue;
+                    offered[u] = offer;
+                    frontier.push_back(u);
+                }
+            }
+            // most of the border can't go without splitting from, its cells only come in drips
+            if (moved < amount / 2){
+                blocked[from * parts + to] = true;
+                through = false;
+            }
+            amount = moved;
+        }
+        // the borders have moved, a pair left out may trade again
+        if (through) std::fill(blocked.begin(), blocked.end(), false);
+    }
+
+    imbalance_reached = 0;
+    for (int p=0; p<parts; p++){
+        if (target_weight[p] > 0) imbalance_reached = std::max(imbalance_reached, std::fabs(weight[p] - target_weight[p]) / target_weight[p]);
+    }
+}
+
+// every part keeps the piece around its pinned vertex (the largest piece without one); the
+// cells of the other pieces go to the part that reaches them first from its kept piece
+void Multilevel_partitioner::reconnect(const Partition_graph &graph, const std::vector<int> &pin, std::vector<int> &part){
+
+    int n = graph.size();
+    std::vector<int> piece(n, -1);
+    std::vector<int> anchor(parts, -1);
+    std::vector<int> anchor_size(parts, 0);
+    std::deque<int> queue;
+    int pieces(0);
+
+    for (int v=0; v<n; v++){
+        if (piece[v] >= 0) continue;
+        int p = part[v];
+        int size(0);
+        bool pinned_piece(false);
+        piece[v] = pieces;
+        queue.push_back(v);
+        while (!queue.empty()){
+            int u = queue.front();
+            queue.pop_front();
+            size++;
+            if (pin[u] == p) pinned_piece = true;
+            for (int e = graph.xadj[u]; e < graph.xadj[u + 1]; e++){
+                int x = graph.adjncy[e];
+                if ((piece[x] >= 0) || (part[x] != p)) continue;
+                piece[x] = pieces;
+                queue.push_back(x);
+            }
+        }
+        if (pinned_piece) size = n + 1;
+        if (size > anchor_size[p]){
+            anchor[p] = pieces;
+            anchor_size[p] = size;
+        }
+        pieces++;
+    }
+
+    std::vector<bool> kept(n, false);
+    for (int v=0; v<n; v++){
+        if (piece[v] == anchor[part[v]]){
+            kept[v] = true;
+            queue.push_back(v);
+        }
+    }
+    while (!queue.empty()){
+        int u = queue.front();
+        queue.pop_front();
+        for (int e = graph.xadj[u]; e < graph.xadj[u + 1]; e++){
+            int x = graph.adjncy[e];
+            if (kept[x]) continue;
+            kept[x] = true;
+            part[x] = part[u];
+            queue.push_back(x);
+        }
+    }
+}
+
+} // namespace qtnp
@@ -0,0 +1,348 @@
+/**
+ * @file /src/planning_action_server.cpp
+ *
+ * @brief Actionlib servers for meshing, hole editing, partitioning, repartitioning, coverage and go to goal
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <stdexcept>
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include "../include/qtnp/planning_action_server.hpp"
+
+namespace qtnp {
+
+/*****************************************************************************
+** Helpers
+*****************************************************************************/
+
+// lives on the stack of the waiting actionlib thread until the pool job signalled it
+struct Planning_action_server::Completion {
+    boost::mutex completion_mutex;
+    boost::condition_variable completion_signal;
+    bool done;
+    Outcome outcome;
+    std::string message;
+
+    Completion() : done(false), outcome(FAILED) {}
+};
+
+/*****************************************************************************
+** Implementation
+*****************************************************************************/
+
+Planning_action_server::Planning_action_server(ros::NodeHandle &n, Tnp_update &tnpReference,
+                                               Rviz_objects &rvizReference, Thread_pool &pool) :
+    tnp_update_ref(tnpReference),
+    rviz_objects_ref(rvizReference),
+    planning_queue(pool),
+    shutting_down(false),
+    running_kind(NONE),
+    running_control(NULL),
+    mesh_server(n, "tnp_mesh", boost::bind(&Planning_action_server::execute_mesh, this, _1), false),
+    partition_server(n, "tnp_partition", boost::bind(&Planning_action_server::execute_partition, this, _1), false),
+    coverage_server(n, "tnp_coverage", boost::bind(&Planning_action_server::execute_coverage, this, _1), false),
+    go_to_goal_server(n, "tnp_go_to_goal", boost::bind(&Planning_action_server::execute_go_to_goal, this, _1), false),
+    edit_hole_server(n, "tnp_edit_hole", boost::bind(&Planning_action_server::execute_edit_hole, this, _1), false),
+    repartition_server(n, "tnp_repartition", boost::bind(&Planning_action_server::execute_repartition, this, _1), false)
+{
+    mesh_server.registerPreemptCallback(boost::bind(&Planning_action_server::preempt, this, MESH));
+    partition_server.registerPreemptCallback(boost::bind(&Planning_action_server::preempt, this, PARTITION));
+    coverage_server.registerPreemptCallback(boost::bind(&Planning_action_server::preempt, this, COVERAGE));
+    go_to_goal_server.registerPreemptCallback(boost::bind(&Planning_action_server::preempt, this, GO_TO_GOAL));
+    edit_hole_server.registerPreemptCallback(boost::bind(&Planning_action_server::preempt, this, EDIT_HOLE));
+    repartition_server.registerPreemptCallback(boost::bind(&Planning_action_server::preempt, this, REPARTITION));
+
+    mesh_server.start();
+    partition_server.start();
+    coverage_server.start();
+    go_to_goal_server.start();
+    edit_hole_server.start();
+    repartition_server.start();
+}
+
+Planning_action_server::~Planning_action_server(){
+
+    // queued requests are dropped, the running one stops at its next checkpoint
+    {
+        boost::lock_guard<boost::mutex> lock(running_mutex);
+        shutting_down = true;
+        if (running_control) running_control->request_cancel();
+    }
+
+    mesh_server.shutdown();
+    partition_server.shutdown();
+    coverage_server.shutdown();
+    go_to_goal_server.shutdown();
+    edit_hole_server.shutdown();
+    repartition_server.shutdown();
+
+    // the queue may still be returning from its last job on a pool thread
+    planning_queue.wait_idle();
+}
+
+/*****************************************************************************
+** Implementation [Execute callbacks, actionlib threads]
+*****************************************************************************/
+
+void Planning_action_server::execute_mesh(const MeshGoalConstPtr &goal){
+
+    MeshResult result;
+    std::string message;
+    Outcome outcome = run_on_pool(MESH,
+            boost::bind(&Planning_action_server::mesh_job, this, goal, boost::ref(result), _1),
+            boost::bind(&Mesh_server::isPreemptRequested, &mesh_server),
+            boost::bind(&Planning_action_server::publish_feedback<Mesh_server, MeshFeedback>, this, &mesh_server, _1, _2, _3),
+            message);
+    finish(mesh_server, result, outcome, message);
+}
+
+void Planning_action_server::execute_partition(const PartitionGoalConstPtr &goal){
+
+    PartitionResult result;
+    std::string message;
+    Outcome outcome = run_on_pool(PARTITION,
+            boost::bind(&Planning_action_server::partition_job, this, goal, boost::ref(result), _1),
+            boost::bind(&Partition_server::isPreemptRequested, &partition_server),
+            boost::bind(&Planning_action_server::publish_feedback<Partition_server, PartitionFeedback>, this, &partition_server, _1, _2, _3),
+            message);
+    finish(partition_server, result, outcome, message);
+}
+
+void Planning_action_server::execute_coverage(const CoverageGoalConstPtr &goal){
+
+    CoverageResult result;
+    std::string message;
+    Outcome outcome = run_on_pool(COVERAGE,
+            boost::bind(&Planning_action_server::coverage_job, this, goal, boost::ref(result), _1),
+            boost::bind(&Coverage_server::isPreemptRequested, &coverage_server),
+            boost::bind(&Planning_action_server::publish_feedback<Coverage_server, CoverageFeedback>, this, &coverage_server, _1, _2, _3),
+            message);
+    finish(coverage_server, result, outcome, message);
+}
+
+void Planning_action_server::execute_go_to_goal(const GoToGoalGoalConstPtr &goal){
+
+    GoToGoalResult result;
+    std::string message;
+    Outcome outcome = run_on_pool(GO_TO_GOAL,
+            boost::bind(&Planning_action_server::go_to_goal_job, this, goal, boost::ref(result), _1),
+            boost::bind(&Go_to_goal_server::isPreemptRequested, &go_to_goal_server),
+            boost::bind(&Planning_action_server::publish_feedback<Go_to_goal_server, GoToGoalFeedback>, this, &go_to_goal_server, _1, _2, _3),
+            message);
+    finish(go_to_goal_server, result, outcome, message);
+}
+
+void Planning_action_server::execute_edit_hole(const EditHoleGoalConstPtr &goal){
+
+    EditHoleResult result;
+    std::string message;
+    Outcome outcome = run_on_pool(EDIT_HOLE,
+            boost::bind(&Planning_action_server::edit_hole_job, this, goal, boost::ref(result), _1),
+            boost::bind(&Edit_hole_server::isPreemptRequested, &edit_hole_server),
+            boost::bind(&Planning_action_server::publish_feedback<Edit_hole_server, EditHoleFeedback>, this, &edit_hole_server, _1, _2, _3),
+            message);
+    finish(edit_hole_server, result, outcome, message);
+}
+
+void Planning_action_server::execute_repartition(const RepartitionGoalConstPtr &goal){
+
+    RepartitionResult result;
+    std::string message;
+    Outcome outcome = run_on_pool(REPARTITION,
+            boost::bind(&Planning_action_server::repartition_job, this, goal, boost::ref(result), _1),
+            boost::bind(&Repartition_server::isPreemptRequested, &repartition_server),
+            boost::bind(&Planning_action_server::publish_feedback<Repartition_server, RepartitionFeedback>, this, &repartition_server, _1, _2, _3),
+            message);
+    finish(repartition_server, result, outcome, message);
+}
+
+/*****************************************************************************
+** Implementation [Planning jobs, pool threads]
+*****************************************************************************/
+
+void Planning_action_server::mesh_job(const MeshGoalConstPtr &goal, MeshResult &result, Tnp_update::Planning_job &job){
+
+    double angle_cons = goal->angle_criterion > 0 ? goal->angle_criterion : constants::angle_criterion_default;
+    double edge_cons = goal->edge_criterion > 0 ? goal->edge_criterion : constants::edge_criterion_default;
+
+    tnp_update_ref.perform_polygon_definition(goal->placemarks, angle_cons, edge_cons);
+    if (!tnp_update_ref.is_mesh_ready()) throw std::runtime_error("Meshing did not produce a mesh");
+
+    result.cells = rviz_objects_ref.count_cells();
+}
+
+void Planning_action_server::partition_job(const PartitionGoalConstPtr &goal, PartitionResult &result, Tnp_update::Planning_job &job){
+
+    if ( (goal->latitude.size() != goal->longitude.size()) ||
+         (goal->latitude.size() != goal->autonomy_percentage.size()) || goal->latitude.empty() ){
+        throw std::invalid_argument("Partition goal needs one latitude, longitude and autonomy percentage per UAS");
+    }
+
+    std::vector<std::pair< std::pair<double,double> , int > > uas_coords_with_percentage;
+    for (int i=0; i<goal->latitude.size(); i++){
+        uas_coords_with_percentage.push_back(std::make_pair(std::make_pair(goal->latitude[i], goal->longitude[i]),
+                                                            (int) goal->autonomy_percentage[i]));
+    }
+
+    Tnp_update::Partitioner partitioner(Tnp_update::Hop_growth);
+    if (!goal->partitioner.empty() && !Tnp_update::parse_partitioner(goal->partitioner, partitioner)){
+        throw std::invalid_argument("Unknown partitioner \"" + goal->partitioner + "\", use hop_growth, multilevel or voronoi");
+    }
+
+    Tnp_update::Partition_weight weight(tnp_update_ref.get_partition_weight());
+    if (!goal->weight.empty() && !Tnp_update::parse_partition_weight(goal->weight, weight)){
+        throw std::invalid_argument("Unknown weight \"" + goal->weight + "\", use cells, area or flight_time");
+    }
+
+    std::vector<double> cell_sizes(goal->cell_size.begin(), goal->cell_size.end());
+    tnp_update_ref.partition(uas_coords_with_percentage, partitioner, weight, cell_sizes);
+    if (!tnp_update_ref.is_partition_ready()) throw std::runtime_error("No mesh to partition, send a mesh goal first");
+
+    result.cells_per_agent = tnp_update_ref.count_agent_cells();
+}
+
+void Planning_action_server::coverage_job(const CoverageGoalConstPtr &goal, CoverageResult &result, Tnp_update::Planning_job &job){
+
+    if (!tnp_update_ref.is_partition_ready()) throw std::runtime_error("No partition, send a partition goal first");
+
+    std::pair<int, std::pair<double,double> > coverage_for(goal->uas_id, std::make_pair(goal->latitude, goal->longitude));
+    if (goal->all_agents){
+        tnp_update_ref.path_planning_coverage_all();
+    } else if (goal->resume){
+        std::vector<int> covered_cells(goal->covered_cells.begin(), goal->covered_cells.end());
+        tnp_update_ref.path_planning_resume(coverage_for, covered_cells, goal->use_telemetry);
+    } else {
+        tnp_update_ref.path_planning_coverage(coverage_for);
+    }
+
+    // as the planning left them, a request queued behind this one can't change them any more
+    result.path = job.path;
+    result.waypoints = job.waypoints;
+}
+
+void Planning_action_server::go_to_goal_job(const GoToGoalGoalConstPtr &goal, GoToGoalResult &result, Tnp_update::Planning_job &job){
+
+    if (!tnp_update_ref.is_partition_ready()) throw std::runtime_error("No partition, send a partition goal first");
+
+    tnp_update_ref.path_planning_to_goal(goal->uas_id, goal->goal_latitude, goal->goal_longitude);
+
+    result.path = job.path;
+    result.waypoints = job.waypoints;
+}
+
+void Planning_action_server::edit_hole_job(const EditHoleGoalConstPtr &goal, EditHoleResult &result, Tnp_update::Planning_job &job){
+
+    if (!tnp_update_ref.is_mesh_ready()) throw std::runtime_error("No mesh to change, send a mesh goal first");
+
+    if (goal->remove){
+        if (!tnp_update_ref.remove_hole(goal->hole_id)) throw std::invalid_argument("There is no such hole");
+        result.hole_id = goal->hole_id;
+    } else {
+        result.hole_id = tnp_update_ref.add_hole(goal->hole);
+        if (result.hole_id < 0) throw std::invalid_argument("The hole needs at least three points");
+    }
+
+    result.cells = rviz_objects_ref.count_cells();
+    result.cells_renumbered = tnp_update_ref.get_cells_renumbered();
+}
+
+void Planning_action_server::repartition_job(const RepartitionGoalConstPtr &goal, RepartitionResult &result, Tnp_update::Planning_job &job){
+
+    if (!tnp_update_ref.is_partition_ready()) throw std::runtime_error("No partition, send a partition goal first");
+    if (goal->autonomy_percentage.empty()) throw std::invalid_argument("Repartition goal needs one autonomy percentage per UAS");
+
+    std::vector<int> autonomy_percentage(goal->autonomy_percentage.begin(), goal->autonomy_percentage.end());
+    for (int i=0; i<autonomy_percentage.size(); i++){
+        if ((autonomy_percentage[i] < 0) || (autonomy_percentage[i] > 100)) throw std::invalid_argument("Autonomy percentages are 0 to 100");
+    }
+    tnp_update_ref.repartition(autonomy_percentage);
+
+    result.cells_per_agent = tnp_update_ref.count_agent_cells();
+    result.cells_moved = tnp_update_ref.get_cells_moved();
+}
+
+/*****************************************************************************
+** Implementation [Plumbing]
+*****************************************************************************/
+
+void Planning_action_server::run_request(Request_kind kind, job_type job, boost::function<bool()> preempt_requested,
+                                         Planning_control::progress_callback feedback, Completion *completion){
+
+    Outcome outcome(FAILED);
+    std::string message;
+    Planning_control control;
+    bool started(false);
+    if (!preempt_requested()){
+        // together with the destructor's cancel, so a request is either dropped or cancelled
+        boost::lock_guard<boost::mutex> lock(running_mutex);
+        if (!shutting_down){
+            running_kind = kind;
+            running_control = &control;
+            started = true;
+        }
+    }
+    // actionlib calls preempt() holding its own lock, preempt_requested() takes it too, so it
+    // is asked outside running_mutex, and once more for a preempt that came in between
+    if (started && preempt_requested()) control.request_cancel();
+
+    if (!started){
+        outcome = CANCELLED;
+        message = "Preempted before planning started";
+    } else {
+        control.add_progress_listener(feedback);
+        try {
+            // waits here while a job of the gui or the topics holds the Tnp_update
+            Tnp_update::Planning_job planning_job(tnp_update_ref, control);
+            job(planning_job);
+            outcome = COMPLETED;
+        } catch (const Planning_cancelled &e) {
+            outcome = CANCELLED;
+            message = e.what();
+        } catch (const std::exception &e) {
+            message = e.what();
+        }
+        boost::lock_guard<boost::mutex> lock(running_mutex);
+        running_kind = NONE;
+        running_control = NULL;
+    }
+
+    boost::lock_guard<boost::mutex> lock(completion->completion_mutex);
+    completion->outcome = outcome;
+    completion->message = message;
+    completion->done = true;
+    completion->completion_signal.notify_all();
+}
+
+Planning_action_server::Outcome Planning_action_server::run_on_pool(Request_kind kind, job_type job,
+                                                                    boost::function<bool()> preempt_requested,
+                                                                    Planning_control::progress_callback feedback,
+                                                                    std::string &message){
+    Completion completion;
+    planning_queue.post(boost::bind(&Planning_action_server::run_request, this, kind, job, preempt_requested, feedback,
+                                    &completion));
+
+    boost::unique_lock<boost::mutex> lock(completion.completion_mutex);
+    while (!completion.done){
+        completion.completion_signal.wait(lock);
+    }
+
+    message = completion.message;
+    return completion.outcome;
+}
+
+// called by actionlib on a cancel request and when a newer goal replaces the active one
+void Planning_action_server::preempt(Request_kind kind){
+
+    boost::lock_guard<boost::mutex> lock(running_mutex);
+    if ((running_kind == kind) && running_control) running_control->request_cancel();
+}
+
+} // namespace qtnp
@@ -0,0 +1,102 @@
+/**
+ * @file /src/planning_thread.cpp
+ *
+ * @brief Runs the long planning operations away from the gui thread
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <QMutexLocker>
+#include <boost/bind.hpp>
+
+#include "../include/qtnp/planning_thread.hpp"
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Implementation
+*****************************************************************************/
+
+Planning_thread::Planning_thread(Tnp_update &tnpReference, QObject *parent) :
+    QThread(parent),
+    tnp_update_ref(tnpReference),
+    busy(false)
+{}
+
+Planning_thread::~Planning_thread(){
+    cancel();
+    wait();
+}
+
+bool Planning_thread::submit(const QString &stage_name, boost::function<void()> planning_job){
+
+    QMutexLocker locker(&job_mutex);
+    if (busy) return false;
+
+    busy = true;
+    job_name = stage_name;
+    job = planning_job;
+    job_control.reset(new Planning_control());
+    job_control->add_progress_listener(boost::bind(&Planning_thread::on_progress, this, _1, _2, _3));
+    wait(); // the previous run may still be returning after its finished signal
+    start();
+    return true;
+}
+
+void Planning_thread::cancel(){
+    QMutexLocker locker(&job_mutex);
+    if (job_control) job_control->request_cancel();
+}
+
+bool Planning_thread::is_busy(){
+    QMutexLocker locker(&job_mutex);
+    return busy;
+}
+
+void Planning_thread::run(){
+
+    bool completed(false);
+    QString message;
+    boost::shared_ptr<Planning_control> control;
+    {
+        QMutexLocker locker(&job_mutex);
+        control = job_control;
+    }
+
+    try {
+        // waits here while a job of the action servers or the topics holds the Tnp_update
+        Tnp_update::Planning_job planning_job(tnp_update_ref, *control);
+        job();
+        completed = true;
+    } catch (const Planning_cancelled &e) {
+        message = QString(e.what());
+    } catch (const std::exception &e) {
+        message = QString("Planning failed: ") + e.what();
+    }
+
+    QString finished_name;
+    {
+        QMutexLocker locker(&job_mutex);
+        finished_name = job_name;
+        job.clear();
+        job_control.reset();
+        busy = false;
+    }
+    Q_EMIT planningFinished(finished_name, completed, message);
+}
+
+// called from inside the planning loops of this thread's job (pool threads included). The
+// signal is queued to the gui.
+void Planning_thread::on_progress(const std::string &stage, int done, int total){
+    Q_EMIT progressUpdated(QString(stage.c_str()), done, total);
+}
+
+}  // namespace qtnp
@@ -14,18 +14,18 @@
 
 #include <ros/ros.h>
 #include <ros/network.h>
+#include <algorithm>
+#include <iomanip>
 #include <string>
 #include <std_msgs/String.h>
 #include <sstream>
+#include <unistd.h>
 
 #include "../include/qtnp/qnode.hpp"
 #include "../include/qtnp/rviz_objects.hpp"
 #include "../include/qtnp/tnp_update.hpp"
 
-#include "mavros/mavros.h"
 #include "mavros_msgs/WaypointList.h"
-#include "mavros_msgs/WaypointPush.h"
-#include "mavros_msgs/WaypointClear.h"
 
 
 /*****************************************************************************
@@ -38,12 +38,6 @@ static void wrapper_path_planning_callback(void *pt2Object, const qtnp::InitialC
     // and call the member function
     update->path_planning_callback(msg);
 }
-static void wrapper_polygon_def_callback(void *pt2Object, const qtnp::Placemarks::ConstPtr &msg){
-    //explicitly cast to a pointer to class Tnp_update
-    qtnp::Tnp_update *update = (qtnp::Tnp_update*) pt2Object;
-    // and call the member function
-    update->polygon_def_callback(msg);
-}
 
 /*****************************************************************************
 ** Namespaces
@@ -55,15 +49,31 @@ namespace qtnp {
 QNode::QNode(int argc, char** argv) :
 	init_argc(argc),
     init_argv(argv),
-    tnp_update(rviz_objects)
-	{}
+    tnp_update(rviz_objects),
+    upload_pool(constants::upload_threads),
+    mission_uploader(upload_pool),
+    mission_writer(planning_pool),
+    session_snapshot(planning_pool),
+    session_restored(false),
+    max_missions(0),
+    telemetry_listener(tnp_update),
+    upload_missions(false)
+	{
+    tnp_update.set_thread_pool(&planning_pool);
+    tnp_update.set_session_snapshot(&session_snapshot);
+    // the view scrolls down after every drained batch
+    QObject::connect(&logging_model, SIGNAL(rowsAppended()), this, SIGNAL(loggingUpdated()));
+    }
 
 QNode::~QNode() {
+    logging::set_summary_sink(logging::summary_sink());
+    action_server.reset();
     if(ros::isStarted()) {
       ros::shutdown(); // explicitly needed since we use ros::start();
       ros::waitForShutdown();
     }
 	wait();
+    missions.clear();
 }
 
 bool QNode::init() {
@@ -78,11 +88,19 @@ bool QNode::init() {
     // when a path is requested, for agent i
     path_plan_callback bound_path_planning_callback = boost::bind(&wrapper_path_planning_callback, &tnp_update, _1); //--
     // when a new polygon is defined by a kml file
-    poly_def_callback bound_polygon_def_callback = boost::bind(&wrapper_polygon_def_callback, &tnp_update, _1); //--
+    poly_def_callback bound_polygon_def_callback = boost::bind(&QNode::polygon_def_callback, this, _1); //--
 
     ros::NodeHandle n;
 
     init_publishers(n);
+    init_action_servers(n);
+    init_mission_upload();
+    init_mission_export();
+    init_logging();
+    init_planning(tnp_update);
+    init_missions();
+    init_session_snapshot();
+    init_telemetry();
     // subscribing to the tnp_release_spot, waiting for lon,lat and agent id in order to publish to the guys below
     home_spot_sub = n.subscribe("tnp_release_spot", 1000, bound_path_planning_callback);
     // define_poly. first step of node
@@ -108,11 +126,19 @@ bool QNode::init(const std::string &master_url, const std::string &host_url) {
     // when a path is requested, for agent i
     path_plan_callback bound_path_planning_callback = boost::bind(&wrapper_path_planning_callback, &tnp_update, _1); //--
     // when a new polygon is defined by a kml file
-    poly_def_callback bound_polygon_def_callback = boost::bind(&wrapper_polygon_def_callback, &tnp_update, _1); //--
+    poly_def_callback bound_polygon_def_callback = boost::bind(&QNode::polygon_def_callback, this, _1); //--
 
     ros::NodeHandle n;
 
     init_publishers(n);
+    init_action_servers(n);
+    init_mission_upload();
+    init_mission_export();
+    init_logging();
+    init_planning(tnp_update);
+    init_missions();
+    init_session_snapshot();
+    init_telemetry();
 
     // subscribing to the tnp_release_spot (lon,lat, agent_id) for service calls
     home_spot_sub = n.subscribe("tnp_release_spot", 1000, bound_path_planning_callback);
@@ -150,30 +176,32 @@ void QNode::run() {
         if (rviz_objects.is_planning_ready()){
           triangulation_mesh_pub.publish(rviz_objects.get_triangulation_mesh());
           path_pub.publish(rviz_objects.get_path());
-          std::cout << "Number of waypoints: " << rviz_objects.get_number_of_waypoints() << std::endl;
-          // waypoints_s_client.publish(this->tnp_update.get_waypoint_list());
-//          mavros_msgs::WaypointPush push_srv;
-//          mavros_msgs::WaypointClear clear_wp;
+          QTNP_DEBUG(General, "Number of waypoints: " << rviz_objects.get_number_of_waypoints());
 
-//          for (int i=0; i< tnp_update.get_waypoint_list().waypoints.size(); i++){
-
-//              push_srv.request.waypoints.push_back(tnp_update.get_waypoint_list().waypoints[i]);
-//            waypoints_s_client.call(push_srv);
-//            ros::Duration(0.3).sleep();
-
-//          }
-
-//          std::vector<mavros_msgs::Waypoint> the_list = push_srv.request.waypoints;
-//          for (std::vector<mavros_msgs::Waypoint>::iterator it = the_list.begin();
-//               it != the_list.end(); it++){
-//              std::cout << "lat: " << it->x_lat << "lat: " << it->y_long << std::endl;
-//          }
-//            std::cout << "total:" << the_list.size() << std::endl;
-//          waypoints_s_client.call(push_srv);
+          // each new list is written to disk and goes to its vehicle in one push, in the background
+          std::map<int, mavros_msgs::WaypointList> waypoint_lists = tnp_update.take_updated_waypoint_lists();
+          if (!waypoint_lists.empty()){
+              mission_writer.write_all_async(waypoint_lists);
+              if (upload_missions) mission_uploader.upload_all_async(waypoint_lists);
+          }
 
           // TODO define data file or log
           //dataFile << rviz_objects.get_number_of_waypoints() << " ";
           rviz_objects.set_planning_ready(false);
+
+          size_t bytes;
+          if (tnp_update.memory_usage(bytes)){
+              log_memory_usage("of the gui", rviz_objects.count_cells(), bytes + rviz_objects.memory_bytes());
+          }
+        }
+
+        for (std::map<std::string, boost::shared_ptr<Mission_context> >::iterator it = missions.begin();
+             it != missions.end(); ++it){
+          std::map<int, mavros_msgs::WaypointList> waypoint_lists;
+          if (!it->second->publish(waypoint_lists)) continue;
+          if (upload_missions && !waypoint_lists.empty()) mission_uploader.upload_all_async(waypoint_lists);
+          size_t bytes;
+          if (it->second->memory_usage(bytes)) log_memory_usage(it->first, it->second->cell_count(), bytes);
         }
 
 		ros::spinOnce();
@@ -186,38 +214,28 @@ void QNode::run() {
 
 
 void QNode::log( const LogLevel &level, const std::string &msg) {
-	logging_model.insertRows(logging_model.rowCount(),1);
-	std::stringstream logging_model_msg;
 	switch ( level ) {
-		case(Debug) : {
-				ROS_DEBUG_STREAM(msg);
-				logging_model_msg << "[DEBUG] [" << ros::Time::now() << "]: " << msg;
-				break;
-		}
-		case(Info) : {
-				ROS_INFO_STREAM(msg);
-				logging_model_msg << "[INFO] [" << ros::Time::now() << "]: " << msg;
-				break;
-		}
-		case(Warn) : {
-				ROS_WARN_STREAM(msg);
-				logging_model_msg << "[INFO] [" << ros::Time::now() << "]: " << msg;
-				break;
-		}
-		case(Error) : {
-				ROS_ERROR_STREAM(msg);
-				logging_model_msg << "[ERROR] [" << ros::Time::now() << "]: " << msg;
-				break;
-		}
-		case(Fatal) : {
-				ROS_FATAL_STREAM(msg);
-				logging_model_msg << "[FATAL] [" << ros::Time::now() << "]: " << msg;
-				break;
-		}
+		case(Debug) : ROS_DEBUG_STREAM(msg); break;
+		case(Info) : ROS_INFO_STREAM(msg); break;
+		case(Warn) : ROS_WARN_STREAM(msg); break;
+		case(Error) : ROS_ERROR_STREAM(msg); break;
+		case(Fatal) : ROS_FATAL_STREAM(msg); break;
+	}
+	append_log_row(level, msg);
+}
+
+void QNode::log_summary(logging::Level level, const std::string &msg) {
+	switch ( level ) {
+		case(logging::Debug) : append_log_row(Debug, msg); break;
+		case(logging::Info) : append_log_row(Info, msg); break;
+		case(logging::Warn) : append_log_row(Warn, msg); break;
+		case(logging::Error) : append_log_row(Error, msg); break;
+		default : append_log_row(Fatal, msg); break;
 	}
-	QVariant new_row(QString(logging_model_msg.str().c_str()));
-	logging_model.setData(logging_model.index(logging_model.rowCount()-1),new_row);
-	Q_EMIT loggingUpdated(); // used to readjust the scrollbar
+}
+
+void QNode::append_log_row( const LogLevel &level, const std::string &msg) {
+	logging_model.push(level, msg); // shown with the next drain of the model
 }
 
 void QNode::init_publishers(ros::NodeHandle n){
@@ -235,9 +253,236 @@ void QNode::init_publishers(ros::NodeHandle n){
     center_pub = n.advertise<visualization_msgs::Marker>("center_points", 150);
     // publishing the produced path(s)(?)
     path_pub = n.advertise<nav_msgs::Path>("path_planning", 150);
-    // publishing waypoint lists in mavros nodes
-    // waypoints_pub = n.advertise<mavros_msgs::WaypointList>("mavros/mission/waypoints", 150);
-    waypoints_s_client = n.serviceClient<mavros_msgs::WaypointPush>("/mavros/mission/push");
+}
+
+void QNode::init_mission_upload(){
+
+    // waypoint lists are pushed to <mavros_namespace_prefix><uas id>/mavros/mission/push
+    // (or to ~mavros_namespaces[uas id - 1]) only when ~upload_missions is set
+    ros::NodeHandle private_n("~");
+    private_n.param("upload_missions", upload_missions, false);
+    mission_uploader.configure(private_n);
+    mission_uploader.set_result_callback(boost::bind(&QNode::log_upload_result, this, _1, _2, _3));
+}
+
+void QNode::log_upload_result(int uas_id, bool success, const std::string &msg){
+
+    std::stringstream ss;
+    ss << "Mission upload for UAS " << uas_id << ": " << msg;
+    log(success ? Info : Error, ss.str());
+}
+
+void QNode::init_mission_export(){
+
+    // ~write_missions (default on), ~mission_directory (default $ROS_HOME/qtnp/missions)
+    // and ~mission_formats, any of "wpl", "plan" and "bin" (default wpl)
+    ros::NodeHandle private_n("~");
+    mission_writer.configure(private_n);
+    mission_writer.set_result_callback(boost::bind(&QNode::log_export_result, this, _1, _2, _3));
+}
+
+void QNode::log_export_result(int uas_id, bool success, const std::string &msg){
+
+    std::stringstream ss;
+    ss << "Mission file for UAS " << uas_id << ": " << msg;
+    log(success ? Info : Error, ss.str());
+}
+
+void QNode::init_logging(){
+
+    // ~log_levels/<subsystem>: debug, info, warn, error, fatal or off (default info); debug
+    // statements only exist in builds without NDEBUG
+    ros::NodeHandle private_n("~");
+    logging::configure(private_n);
+    logging::set_summary_sink(boost::bind(&QNode::log_summary, this, _1, _2));
+}
+
+void QNode::init_planning(Tnp_update &update){
+
+    init_mesh_projection(update);
+    init_partition_weight(update);
+    init_path_options(update);
+    init_terrain(update);
+}
+
+void QNode::init_mesh_projection(Tnp_update &update){
+
+    // ~mesh_projection: "normalized" (default) stretches the area onto the rviz range,
+    // "local_enu" makes the mesh units metres, edge criterion included. Used from the next mesh on
+    ros::NodeHandle private_n("~");
+    std::string name;
+    private_n.param<std::string>("mesh_projection", name, "normalized");
+    Geo_transform::Projection projection;
+    if (!Geo_transform::parse_projection(name, projection)){
+        QTNP_WARN(Meshing, "Unknown ~mesh_projection \"" << name << "\", using normalized");
+        projection = Geo_transform::Normalized;
+    }
+    update.set_mesh_projection(projection);
+
+    // ~size_grading: metres the cells grow by per metre away from a "size" placemark
+    double grading;
+    private_n.param("size_grading", grading, constants::size_grading_default);
+    if (grading <= 0){
+        QTNP_WARN(Meshing, "~size_grading must be positive, using " << constants::size_grading_default);
+        grading = constants::size_grading_default;
+    }
+    update.set_size_grading(grading);
+}
+
+void QNode::init_partition_weight(Tnp_update &update){
+
+    // ~partition_weight: "cells" (default), "area" or "flight_time", what the autonomy
+    // percentages are shares of; ~cruise_speed (m/s) and ~waypoint_turn_time (s) for the last
+    ros::NodeHandle private_n("~");
+    std::string name;
+    private_n.param<std::string>("partition_weight", name, "cells");
+    Tnp_update::Partition_weight weight;
+    if (!Tnp_update::parse_partition_weight(name, weight)){
+        QTNP_WARN(Partitioning, "Unknown ~partition_weight \"" << name << "\", using cells");
+        weight = Tnp_update::Cell_count;
+    }
+    update.set_partition_weight(weight);
+
+    double speed(constants::cruise_speed_default), turn_time(constants::waypoint_turn_time_default);
+    private_n.param("cruise_speed", speed, speed);
+    private_n.param("waypoint_turn_time", turn_time, turn_time);
+    if ((speed <= 0) || (turn_time < 0)){
+        QTNP_WARN(Partitioning, "~cruise_speed must be positive and ~waypoint_turn_time not negative, using the defaults");
+        speed = constants::cruise_speed_default;
+        turn_time = constants::waypoint_turn_time_default;
+    }
+    update.set_flight_model(speed, turn_time);
+}
+
+void QNode::init_path_options(Tnp_update &update){
+
+    // ~tour_optimization_budget: seconds of 2-opt/Or-opt per coverage path, 0 for none
+    ros::NodeHandle private_n("~");
+    double budget(constants::tour_budget_default);
+    private_n.param("tour_optimization_budget", budget, budget);
+    update.set_tour_budget(std::max(0.0, budget));
+
+    // ~waypoint_tolerance: metres a straight run of cells may stray from its one leg, 0 keeps
+    // a waypoint per cell, below 0 it follows the cell size
+    double tolerance(constants::waypoint_tolerance_default);
+    private_n.param("waypoint_tolerance", tolerance, tolerance);
+    update.set_waypoint_tolerance(tolerance);
+}
+
+void QNode::init_terrain(Tnp_update &update){
+
+    // ~dem_path: an ESRI GridFloat raster (.flt and .hdr, gdal_translate -of EHdr) the waypoint
+    // altitudes follow, none by default; ~flight_altitude: metres above the ground
+    ros::NodeHandle private_n("~");
+    double altitude(constants::flight_altitude_default);
+    private_n.param("flight_altitude", altitude, altitude);
+    update.set_flight_altitude(altitude);
+
+    std::string path;
+    private_n.param<std::string>("dem_path", path, "");
+    if (path.empty()) return;
+    std::string error;
+    if (update.load_terrain(path, error)){
+        QTNP_INFO(Waypoints, "Terrain from " << path);
+    } else {
+        QTNP_WARN(Waypoints, "No terrain, " << error << "; the waypoints are flown at " << altitude << " m above home");
+    }
+}
+
+void QNode::init_missions(){
+
+    // ~max_missions: missions with an id next to the one of the gui, each a mesh and six
+    // action servers of its own (default 8)
+    ros::NodeHandle private_n("~");
+    private_n.param("max_missions", max_missions, constants::max_missions_default);
+}
+
+void QNode::polygon_def_callback(const Placemarks::ConstPtr &msg){
+
+    if (msg->mission_id.empty()){
+        tnp_update.polygon_def_callback(msg);
+        return;
+    }
+    boost::shared_ptr<Mission_context> mission = find_or_start_mission(msg->mission_id);
+    if (mission) mission->mesh_async(msg->placemarks);
+}
+
+boost::shared_ptr<Mission_context> QNode::find_or_start_mission(const std::string &id){
+
+    std::map<std::string, boost::shared_ptr<Mission_context> >::iterator found = missions.find(id);
+    if (found != missions.end()) return found->second;
+
+    if (!Mission_context::is_valid_id(id)){
+        log(Error, "Mission id \"" + id + "\" is not letters, digits and underscores starting with a letter");
+        return boost::shared_ptr<Mission_context>();
+    }
+    if (missions.size() >= max_missions){
+        std::stringstream ss;
+        ss << "Mission " << id << " not started, there are already " << missions.size() << " (~max_missions)";
+        log(Error, ss.str());
+        return boost::shared_ptr<Mission_context>();
+    }
+
+    boost::shared_ptr<Mission_context> mission(new Mission_context(id, planning_pool));
+    ros::NodeHandle n;
+    ros::NodeHandle private_n("~");
+    init_planning(mission->planning());
+    mission->writer().set_result_callback(boost::bind(&QNode::log_export_result, this, _1, _2, _3));
+    mission->start(n, private_n);
+    missions[id] = mission;
+    log(Info, "Mission " + id + " started, its topics and action servers are under missions/" + id);
+    return mission;
+}
+
+void QNode::log_memory_usage(const std::string &mission, int cells, size_t bytes){
+
+    std::stringstream ss;
+    ss << "Mission " << mission << ": " << cells << " cells, about " << std::fixed << std::setprecision(1)
+       << bytes / (1024.0 * 1024.0) << " MB";
+    log(Info, ss.str());
+}
+
+void QNode::init_session_snapshot(){
+
+    // ~session_snapshot (default on) writes the session after every planning stage to
+    // ~session_snapshot_path (default $ROS_HOME/qtnp/session.snapshot), and restores it on start
+    ros::NodeHandle private_n("~");
+    session_snapshot.configure(private_n);
+    session_snapshot.set_result_callback(boost::bind(&QNode::log_snapshot_result, this, _1, _2));
+
+    if (session_restored || !session_snapshot.is_enabled()) return;
+    session_restored = true;
+    std::string path = session_snapshot.path();
+    if (access(path.c_str(), F_OK) != 0) return;
+    std::string error;
+    if (tnp_update.restore_snapshot(path, error)){
+        log(Info, "Session restored from " + path + ", the missions are not uploaded again");
+    } else {
+        QTNP_WARN(General, "Session not restored: " << error);
+    }
+}
+
+void QNode::log_snapshot_result(bool success, const std::string &msg){
+
+    // every stage writes one, only the failures are news
+    if (!success) log(Error, msg);
+    else QTNP_DEBUG(General, msg);
+}
+
+void QNode::init_telemetry(){
+
+    // ~track_telemetry (default on) subscribes to <mavros namespace>/global_position/global of
+    // UAS 1 to ~telemetry_uas_count, the namespaces as for the mission upload
+    ros::NodeHandle private_n("~");
+    telemetry_listener.start(private_n, boost::bind(&Mission_uploader::mavros_namespace, &mission_uploader, _1));
+}
+
+void QNode::init_action_servers(ros::NodeHandle n){
+
+    // init() runs again on every cdt request from the gui, the servers are only started once
+    if (action_server) return;
+    // tnp_mesh, tnp_edit_hole, tnp_partition, tnp_repartition, tnp_coverage and tnp_go_to_goal
+    action_server.reset(new Planning_action_server(n, tnp_update, rviz_objects, planning_pool));
 }
 
 }  // namespace qtnp
@@ -0,0 +1,260 @@
+/**
+ * @file /src/session_snapshot.cpp
+ *
+ * @brief The planning session in one versioned, checksummed binary file
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <cerrno>
+#include <cstdio>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <boost/bind.hpp>
+
+#include "../include/qtnp/file_utilities.hpp"
+#include "../include/qtnp/session_snapshot.hpp"
+
+/*****************************************************************************
+** Helpers
+*****************************************************************************/
+
+namespace {
+
+const char snapshot_magic[8] = { 'Q', 'T', 'N', 'P', 'S', 'N', 'A', 'P' };
+// raised whenever a section changes its layout; an older file is not read
+const uint32_t snapshot_version(1);
+// reads back as another number on a host of the other byte order
+const uint32_t byte_order_mark(0x01020304);
+
+struct File_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t section_count;
+    uint32_t crc;  // of the header, with this field 0, and the section table
+};
+
+struct Section_entry {
+    uint32_t tag;
+    uint32_t crc;
+    uint64_t offset;
+    uint64_t size;
+};
+
+size_t aligned(size_t offset){
+    return (offset + 7) & ~(size_t) 7;
+}
+
+// the reflected CRC-32 of zlib and PNG, a byte at a time from a table
+struct Crc_table {
+    uint32_t entries[256];
+    Crc_table(){
+        for (uint32_t n=0; n<256; n++){
+            uint32_t c = n;
+            for (int k=0; k<8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[n] = c;
+        }
+    }
+};
+
+uint32_t crc32_update(uint32_t crc, const void *data, size_t size){
+    static const Crc_table table;
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    crc = ~crc;
+    for (size_t i=0; i<size; i++) crc = table.entries[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+}
+
+namespace qtnp {
+
+/*****************************************************************************
+** Implementation
+*****************************************************************************/
+
+uint32_t crc32(const void *data, size_t size){
+    return crc32_update(0, data, size);
+}
+
+std::string Snapshot_file::bytes() const {
+
+    File_header header;
+    std::memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+    header.version = snapshot_version;
+    header.byte_order = byte_order_mark;
+    header.section_count = sections.size();
+    header.crc = 0;
+
+    std::vector<Section_entry> table;
+    size_t offset = aligned(sizeof(File_header) + sections.size() * sizeof(Section_entry));
+    for (std::map<uint32_t, std::string>::const_iterator it = sections.begin(); it != sections.end(); ++it){
+        Section_entry entry;
+        entry.tag = it->first;
+        entry.crc = crc32(it->second.data(), it->second.size());
+        entry.offset = offset;
+        entry.size = it->second.size();
+        table.push_back(entry);
+        offset = aligned(offset + it->second.size());
+    }
+    uint32_t crc = crc32_update(0, &header, sizeof(header));
+    if (!table.empty()) crc = crc32_update(crc, &table[0], table.size() * sizeof(Section_entry));
+    header.crc = crc;
+
+    std::string content(offset, '\0');
+    std::memcpy(&content[0], &header, sizeof(header));
+    if (!table.empty()) std::memcpy(&content[sizeof(header)], &table[0], table.size() * sizeof(Section_entry));
+    int i(0);
+    for (std::map<uint32_t, std::string>::const_iterator it = sections.begin(); it != sections.end(); ++it, ++i){
+        if (!it->second.empty()) std::memcpy(&content[table[i].offset], it->second.data(), it->second.size());
+    }
+    return content;
+}
+
+bool Snapshot_reader::open(const std::string &path, std::string &error){
+
+    close();
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0){
+        error = "cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    struct stat status;
+    if ((fstat(descriptor, &status) != 0) || (status.st_size < (off_t) sizeof(File_header))){
+        error = path + " is too short for a snapshot";
+        ::close(descriptor);
+        return false;
+    }
+    void *mapped = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+    ::close(descriptor);
+    if (mapped == MAP_FAILED){
+        error = "cannot map " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    data = static_cast<const unsigned char *>(mapped);
+    data_size = status.st_size;
+
+    File_header header;
+    std::memcpy(&header, data, sizeof(header));
+    std::ostringstream problem;
+    if (std::memcmp(header.magic, snapshot_magic, sizeof(header.magic)) != 0){
+        problem << path << " is not a qtnp snapshot";
+    } else if (header.byte_order != byte_order_mark){
+        problem << path << " was written on a host of the other byte order";
+    } else if (header.version != snapshot_version){
+        problem << path << " is a version " << header.version << " snapshot, this is version " << snapshot_version;
+    } else if (header.section_count > (data_size - sizeof(header)) / sizeof(Section_entry)){
+        problem << path << " is cut short";
+    }
+    if (!problem.str().empty()){
+        error = problem.str();
+        close();
+        return false;
+    }
+
+    std::vector<Section_entry> table(header.section_count);
+    if (!table.empty()) std::memcpy(&table[0], data + sizeof(header), table.size() * sizeof(Section_entry));
+    uint32_t stored_crc = header.crc;
+    header.crc = 0;
+    uint32_t crc = crc32_update(0, &header, sizeof(header));
+    if (!table.empty()) crc = crc32_update(crc, &table[0], table.size() * sizeof(Section_entry));
+    if (crc != stored_crc){
+        error = path + ": the header checksum doesn't match";
+        close();
+        return false;
+    }
+
+    for (int i=0; i<table.size(); i++){
+        const Section_entry &entry = table[i];
+        if ((entry.offset > data_size) || (entry.size > data_size - entry.offset)){
+            error = path + " is cut short";
+            close();
+            return false;
+        }
+        if (crc32(data + entry.offset, entry.size) != entry.crc){
+            char tag[5] = { 0 };
+            std::memcpy(tag, &entry.tag, 4);
+            error = path + ": the checksum of section " + tag + " doesn't match";
+            close();
+            return false;
+        }
+        sections[entry.tag] = std::make_pair((size_t) entry.offset, (size_t) entry.size);
+    }
+    return true;
+}
+
+void Snapshot_reader::close(){
+
+    if (data) munmap(const_cast<unsigned char *>(data), data_size);
+    data = NULL;
+    data_size = 0;
+    sections.clear();
+}
+
+Snapshot_cursor Snapshot_reader::section(uint32_t tag) const {
+
+    std::map<uint32_t, std::pair<size_t, size_t> >::const_iterator found = sections.find(tag);
+    if (found == sections.end()) return Snapshot_cursor(data, 0);
+    return Snapshot_cursor(data + found->second.first, found->second.second);
+}
+
+Session_snapshot::Session_snapshot(Thread_pool &pool) :
+    queue(pool),
+    enabled(true),
+    snapshot_path(files::ros_home_path("session.snapshot"))
+{}
+
+void Session_snapshot::configure(ros::NodeHandle &private_n){
+
+    bool snapshot;
+    std::string path;
+    private_n.param("session_snapshot", snapshot, true);
+    private_n.param("session_snapshot_path", path, files::ros_home_path("session.snapshot"));
+
+    boost::lock_guard<boost::mutex> lock(settings_mutex);
+    enabled = snapshot;
+    snapshot_path = files::expand_home(path);
+}
+
+bool Session_snapshot::is_enabled(){
+
+    boost::lock_guard<boost::mutex> lock(settings_mutex);
+    return enabled && !snapshot_path.empty();
+}
+
+std::string Session_snapshot::path(){
+
+    boost::lock_guard<boost::mutex> lock(settings_mutex);
+    return snapshot_path;
+}
+
+void Session_snapshot::write_async(boost::shared_ptr<const Snapshot_file> file){
+
+    if (!is_enabled()) return;
+    queue.post(boost::bind(&Session_snapshot::write, this, file, path()));
+}
+
+// runs on a pool thread
+void Session_snapshot::write(boost::shared_ptr<const Snapshot_file> file, std::string target){
+
+    std::string content = file->bytes();
+    std::string error;
+    bool written = files::make_parent_directories(target, error) && files::write_file(target, content, true, error);
+    if (on_result){
+        std::ostringstream message;
+        if (written) message << "Session snapshot written to " << target << " (" << content.size() / 1024 << " kB)";
+        else message << "Session snapshot not written: " << error;
+        on_result(written, message.str());
+    }
+}
+
+} // namespace qtnp
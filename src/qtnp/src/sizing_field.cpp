@@ -0,0 +1,241 @@
+/**
+ * @file /src/sizing_field.cpp
+ *
+ * @brief The cell size wanted at any point of the mesh, graded away from attractors
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "../include/qtnp/sizing_field.hpp"
+
+/*****************************************************************************
+** Helpers
+*****************************************************************************/
+
+namespace {
+
+// buckets along the longer side of the box at most, and the least
+const int max_buckets_per_side(256);
+const int min_buckets_per_side(4);
+
+double segment_distance(double ax, double ay, double bx, double by, double x, double y){
+
+    double dx = bx - ax;
+    double dy = by - ay;
+    double length = dx * dx + dy * dy;
+    double t = (length > 0) ? ((x - ax) * dx + (y - ay) * dy) / length : 0;
+    t = std::max(0.0, std::min(1.0, t));
+    double px = ax + t * dx - x;
+    double py = ay + t * dy - y;
+    return std::sqrt(px * px + py * py);
+}
+
+int clamped(double value, int count){
+    if (!(value > 0)) return 0;
+    return (value >= count) ? count - 1 : (int) value;
+}
+
+}
+
+namespace qtnp {
+
+/*****************************************************************************
+** Implementation
+*****************************************************************************/
+
+Sizing_field::Sizing_field() :
+    attractors(0), grading(1), background(std::numeric_limits<double>::max()),
+    grid_x(0), grid_y(0), bucket_size(1), columns(0), rows(0)
+{}
+
+void Sizing_field::add_point(double x, double y, double size){
+
+    if (!(size > 0)) return;
+    Segment segment = { x, y, x, y, size };
+    segments.push_back(segment);
+    attractors++;
+}
+
+void Sizing_field::add_polyline(const std::vector<double> &x, const std::vector<double> &y, double size){
+
+    int count = std::min(x.size(), y.size());
+    if (!(size > 0) || (count == 0)) return;
+    if (count == 1){
+        add_point(x[0], y[0], size);
+        return;
+    }
+    for (int i=1; i<count; i++){
+        Segment segment = { x[i-1], y[i-1], x[i], y[i], size };
+        segments.push_back(segment);
+    }
+    attractors++;
+}
+
+void Sizing_field::add_polygon(const std::vector<double> &x, const std::vector<double> &y, double size){
+
+    int count = std::min(x.size(), y.size());
+    if (!(size > 0) || (count == 0)) return;
+    if (count < 3){
+        add_polyline(x, y, size);
+        return;
+    }
+    Polygon polygon;
+    polygon.x.assign(x.begin(), x.begin() + count);
+    polygon.y.assign(y.begin(), y.begin() + count);
+    // the kml rings repeat their first point, the others are closed here
+    if ((polygon.x.front() != polygon.x.back()) || (polygon.y.front() != polygon.y.back())){
+        polygon.x.push_back(polygon.x.front());
+        polygon.y.push_back(polygon.y.front());
+    }
+    polygon.size = size;
+    polygon.min_x = *std::min_element(polygon.x.begin(), polygon.x.end());
+    polygon.max_x = *std::max_element(polygon.x.begin(), polygon.x.end());
+    polygon.min_y = *std::min_element(polygon.y.begin(), polygon.y.end());
+    polygon.max_y = *std::max_element(polygon.y.begin(), polygon.y.end());
+
+    // outside it the size grows away from the outline
+    add_polyline(polygon.x, polygon.y, size);
+    polygons.push_back(polygon);
+}
+
+void Sizing_field::build(double new_grading, double new_background, double min_x, double min_y, double max_x, double max_y){
+
+    grading = (new_grading > 0) ? new_grading : 1;
+    background = (new_background > 0) ? new_background : std::numeric_limits<double>::max();
+    segment_first.clear();
+    segment_entries.clear();
+    polygon_first.clear();
+    polygon_entries.clear();
+    columns = rows = 0;
+    if (segments.empty()) return;
+
+    // how far each segment reaches below the background; without a background everywhere
+    bool bounded = (new_background > 0);
+    std::vector<double> reach(segments.size());
+    for (int i=0; i<segments.size(); i++){
+        reach[i] = bounded ? std::max(0.0, (background - segments[i].size) / grading) : 0;
+    }
+
+    grid_x = min_x;
+    grid_y = min_y;
+    double extent = std::max(max_x - min_x, max_y - min_y);
+    if (!(extent > 0)) extent = 1;
+    if (bounded){
+        // about half the typical reach, so a segment sits in a handful of buckets
+        std::vector<double> sorted(reach);
+        std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+        bucket_size = sorted[sorted.size() / 2] / 2;
+        bucket_size = std::max(extent / max_buckets_per_side, std::min(extent / min_buckets_per_side, bucket_size));
+    } else {
+        // every segment counts everywhere, one bucket holds them all
+        bucket_size = extent;
+    }
+    columns = std::max(1, (int) std::ceil((max_x - min_x) / bucket_size));
+    rows = std::max(1, (int) std::ceil((max_y - min_y) / bucket_size));
+    int buckets = columns * rows;
+
+    // two passes, counting and filling, into one array of entries per kind
+    std::vector<int> segment_range(4 * segments.size());
+    segment_first.assign(buckets + 1, 0);
+    for (int i=0; i<segments.size(); i++){
+        const Segment &s = segments[i];
+        double margin = bounded ? reach[i] : extent;
+        int *range = &segment_range[4 * i];
+        range[0] = clamped((std::min(s.ax, s.bx) - margin - grid_x) / bucket_size, columns);
+        range[1] = clamped((std::max(s.ax, s.bx) + margin - grid_x) / bucket_size, columns);
+        range[2] = clamped((std::min(s.ay, s.by) - margin - grid_y) / bucket_size, rows);
+        range[3] = clamped((std::max(s.ay, s.by) + margin - grid_y) / bucket_size, rows);
+        if (bounded && (s.size >= background)) continue;
+        for (int r=range[2]; r<=range[3]; r++){
+            for (int c=range[0]; c<=range[1]; c++) segment_first[r * columns + c + 1]++;
+        }
+    }
+    for (int b=0; b<buckets; b++) segment_first[b + 1] += segment_first[b];
+    segment_entries.resize(segment_first[buckets]);
+    std::vector<int> filled(segment_first.begin(), segment_first.end() - 1);
+    for (int i=0; i<segments.size(); i++){
+        if (bounded && (segments[i].size >= background)) continue;
+        const int *range = &segment_range[4 * i];
+        for (int r=range[2]; r<=range[3]; r++){
+            for (int c=range[0]; c<=range[1]; c++) segment_entries[filled[r * columns + c]++] = i;
+        }
+    }
+
+    // a polygon only in the buckets its box overlaps, outside it its outline segments count
+    polygon_first.assign(buckets + 1, 0);
+    std::vector<int> polygon_range(4 * polygons.size());
+    for (int i=0; i<polygons.size(); i++){
+        const Polygon &p = polygons[i];
+        int *range = &polygon_range[4 * i];
+        range[0] = clamped((p.min_x - grid_x) / bucket_size, columns);
+        range[1] = clamped((p.max_x - grid_x) / bucket_size, columns);
+        range[2] = clamped((p.min_y - grid_y) / bucket_size, rows);
+        range[3] = clamped((p.max_y - grid_y) / bucket_size, rows);
+        for (int r=range[2]; r<=range[3]; r++){
+            for (int c=range[0]; c<=range[1]; c++) polygon_first[r * columns + c + 1]++;
+        }
+    }
+    for (int b=0; b<buckets; b++) polygon_first[b + 1] += polygon_first[b];
+    polygon_entries.resize(polygon_first[buckets]);
+    filled.assign(polygon_first.begin(), polygon_first.end() - 1);
+    for (int i=0; i<polygons.size(); i++){
+        const int *range = &polygon_range[4 * i];
+        for (int r=range[2]; r<=range[3]; r++){
+            for (int c=range[0]; c<=range[1]; c++) polygon_entries[filled[r * columns + c]++] = i;
+        }
+    }
+}
+
+double Sizing_field::smallest_size() const {
+
+    double smallest = background;
+    for (int i=0; i<segments.size(); i++) smallest = std::min(smallest, segments[i].size);
+    return smallest;
+}
+
+int Sizing_field::bucket_of(double x, double y) const {
+
+    return clamped((y - grid_y) / bucket_size, rows) * columns + clamped((x - grid_x) / bucket_size, columns);
+}
+
+// even-odd rule, the ring closed
+bool Sizing_field::is_inside(const Polygon &polygon, double x, double y){
+
+    if ((x < polygon.min_x) || (x > polygon.max_x) || (y < polygon.min_y) || (y > polygon.max_y)) return false;
+    bool inside(false);
+    for (int i=1; i<polygon.x.size(); i++){
+        double ax = polygon.x[i-1], ay = polygon.y[i-1];
+        double bx = polygon.x[i], by = polygon.y[i];
+        if ( ((ay > y) != (by > y)) && (x < ax + (y - ay) * (bx - ax) / (by - ay)) ) inside = !inside;
+    }
+    return inside;
+}
+
+double Sizing_field::size_at(double x, double y) const {
+
+    if (columns == 0) return background;
+    int bucket = bucket_of(x, y);
+
+    double size = background;
+    for (int k=polygon_first[bucket]; k<polygon_first[bucket + 1]; k++){
+        const Polygon &p = polygons[polygon_entries[k]];
+        if ((p.size < size) && is_inside(p, x, y)) size = p.size;
+    }
+    for (int k=segment_first[bucket]; k<segment_first[bucket + 1]; k++){
+        const Segment &s = segments[segment_entries[k]];
+        // no distance can bring a segment below its own size
+        if (s.size >= size) continue;
+        size = std::min(size, s.size + grading * segment_distance(s.ax, s.ay, s.bx, s.by, x, y));
+    }
+    return size;
+}
+
+} // namespace qtnp
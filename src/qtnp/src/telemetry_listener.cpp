@@ -0,0 +1,100 @@
+/**
+ * @file /src/telemetry_listener.cpp
+ *
+ * @brief Position fixes of the vehicles in, coverage progress out
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <boost/bind.hpp>
+
+#include "../include/qtnp/telemetry_listener.hpp"
+#include "../include/qtnp/logging.hpp"
+
+#include "qtnp/CoverageProgress.h"
+
+/*****************************************************************************
+** Namespaces
+*****************************************************************************/
+
+namespace qtnp {
+
+/*****************************************************************************
+** Implementation
+*****************************************************************************/
+
+Telemetry_listener::Telemetry_listener(Tnp_update &tnpReference) :
+    tnp_update_ref(tnpReference), fixes(0), fixes_skipped(0)
+{}
+
+Telemetry_listener::~Telemetry_listener(){
+
+    if (spinner) spinner->stop();
+}
+
+void Telemetry_listener::start(ros::NodeHandle &private_n, namespace_resolver mavros_namespace){
+
+    // the qnode init runs again on every cdt request from the gui
+    if (spinner) return;
+
+    bool track_telemetry(true);
+    int uas_count(1);
+    double progress_rate(1.0);
+    private_n.param("track_telemetry", track_telemetry, track_telemetry);
+    private_n.param("telemetry_uas_count", uas_count, uas_count);
+    private_n.param("coverage_progress_rate", progress_rate, progress_rate);
+    if (!track_telemetry || (uas_count < 1)) return;
+
+    ros::NodeHandle n;
+    n.setCallbackQueue(&telemetry_queue);
+
+    for (int uas_id = 1; uas_id <= uas_count; uas_id++){
+        std::string topic = mavros_namespace(uas_id) + "/global_position/global";
+        // a few fixes of slack only, an old one is worth nothing once a newer one is in
+        fix_subs.push_back(n.subscribe<sensor_msgs::NavSatFix>(topic, 5,
+                           boost::bind(&Telemetry_listener::fix_callback, this, uas_id, _1)));
+    }
+
+    progress_pub = n.advertise<CoverageProgress>("tnp_coverage_progress", 10);
+    if (progress_rate > 0){
+        progress_timer = n.createWallTimer(ros::WallDuration(1.0 / progress_rate),
+                                           &Telemetry_listener::publish_progress, this);
+    }
+
+    spinner.reset(new ros::AsyncSpinner(1, &telemetry_queue));
+    spinner->start();
+    QTNP_INFO(Coverage, "Tracking the telemetry of " << uas_count << " UAS");
+}
+
+// spinner thread
+void Telemetry_listener::fix_callback(int uas_id, const sensor_msgs::NavSatFix::ConstPtr &fix){
+
+    if (fix->status.status < sensor_msgs::NavSatStatus::STATUS_FIX) return;
+
+    if (tnp_update_ref.track_position(uas_id, fix->latitude, fix->longitude) < -1) fixes_skipped++;
+    else fixes++;
+}
+
+// spinner thread
+void Telemetry_listener::publish_progress(const ros::WallTimerEvent &event){
+
+    CoverageProgress progress;
+    std::vector<int> covered, total;
+    if (!tnp_update_ref.coverage_progress(covered, total)) return;
+
+    progress.header.stamp = ros::Time::now();
+    progress.covered_cells.assign(covered.begin(), covered.end());
+    progress.total_cells.assign(total.begin(), total.end());
+    for (int agent=0; agent<total.size(); agent++){
+        progress.percent.push_back(total[agent] > 0 ? 100.0f * covered[agent] / total[agent] : 0.0f);
+    }
+    progress.fixes = fixes.exchange(0);
+    progress.fixes_skipped = fixes_skipped.exchange(0);
+    progress_pub.publish(progress);
+}
+
+} // namespace qtnp
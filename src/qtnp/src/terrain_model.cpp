@@ -0,0 +1,296 @@
+/**
+ * @file /src/terrain_model.cpp
+ *
+ * @brief Ground elevation from a memory mapped raster, sampled in batches
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../include/qtnp/terrain_model.hpp"
+
+/*****************************************************************************
+** Helpers
+*****************************************************************************/
+
+namespace {
+
+// a tile starts every tile_step posts and holds one post more each way
+const int tile_step(256);
+const int tile_posts(tile_step + 1);
+// about 17 MB of tiles
+const int max_tiles(64);
+
+const double not_a_number(std::numeric_limits<double>::quiet_NaN());
+
+std::string lowercase(std::string text){
+    std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+    return text;
+}
+
+// the path without a .hdr or .flt extension
+std::string raster_base(const std::string &path){
+    std::string::size_type dot = path.find_last_of('.');
+    if ((dot == std::string::npos) || (path.find('/', dot) != std::string::npos)) return path;
+    std::string extension = lowercase(path.substr(dot));
+    return ((extension == ".hdr") || (extension == ".flt")) ? path.substr(0, dot) : path;
+}
+
+bool host_is_big_endian(){
+    const uint16_t probe(1);
+    return *reinterpret_cast<const unsigned char *>(&probe) == 0;
+}
+
+}
+
+namespace qtnp {
+
+/*****************************************************************************
+** Implementation
+*****************************************************************************/
+
+Terrain_model::Terrain_model() : data(NULL), data_size(0) {
+    clear();
+}
+
+Terrain_model::~Terrain_model(){
+    unload();
+}
+
+bool Terrain_model::load(const std::string &path, std::string &error){
+
+    unload();
+    boost::lock_guard<boost::mutex> lock(mutex);
+    std::string base = raster_base(path);
+
+    std::ifstream header((base + ".hdr").c_str());
+    if (!header){
+        error = "can't read " + base + ".hdr";
+        return false;
+    }
+    double x_lower(not_a_number), y_lower(not_a_number);
+    bool x_center(false), y_center(false);
+    std::string byte_order("lsbfirst");
+    std::string line;
+    while (std::getline(header, line)){
+        std::istringstream fields(line);
+        std::string key, value;
+        if (!(fields >> key >> value)) continue;
+        key = lowercase(key);
+        if (key == "ncols") columns = std::atoi(value.c_str());
+        else if (key == "nrows") rows = std::atoi(value.c_str());
+        else if (key == "cellsize") cell_size = std::atof(value.c_str());
+        else if (key == "nodata_value") no_data = (float) std::atof(value.c_str());
+        else if (key == "byteorder") byte_order = lowercase(value);
+        else if ((key == "xllcorner") || (key == "xllcenter")){
+            x_lower = std::atof(value.c_str());
+            x_center = (key == "xllcenter");
+        } else if ((key == "yllcorner") || (key == "yllcenter")){
+            y_lower = std::atof(value.c_str());
+            y_center = (key == "yllcenter");
+        }
+    }
+    if ((columns < 2) || (rows < 2) || !(cell_size > 0) || std::isnan(x_lower) || std::isnan(y_lower)){
+        error = base + ".hdr needs ncols and nrows of 2 or more, a cellsize and the lower left corner";
+        clear();
+        return false;
+    }
+    west = x_center ? x_lower - cell_size / 2 : x_lower;
+    north = (y_center ? y_lower - cell_size / 2 : y_lower) + rows * cell_size;
+    swap_bytes = ((byte_order == "msbfirst") != host_is_big_endian());
+    tile_columns = (columns - 2) / tile_step + 1;
+
+    std::string raster = base + ".flt";
+    int descriptor = open(raster.c_str(), O_RDONLY);
+    if (descriptor < 0){
+        error = "can't open " + raster;
+        clear();
+        return false;
+    }
+    struct stat status;
+    size_t needed = (size_t) columns * rows * sizeof(float);
+    if ((fstat(descriptor, &status) != 0) || ((size_t) status.st_size < needed)){
+        error = raster + " is shorter than ncols x nrows floats";
+        close(descriptor);
+        clear();
+        return false;
+    }
+    void *mapped = mmap(NULL, needed, PROT_READ, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+    if (mapped == MAP_FAILED){
+        error = "can't map " + raster + ": " + std::strerror(errno);
+        clear();
+        return false;
+    }
+    // the tiles are copied out row by row, the read ahead of a sequential scan is no use
+    madvise(mapped, needed, MADV_RANDOM);
+    data = static_cast<const unsigned char *>(mapped);
+    data_size = needed;
+    return true;
+}
+
+void Terrain_model::unload(){
+    boost::lock_guard<boost::mutex> lock(mutex);
+    if (data) munmap(const_cast<unsigned char *>(data), data_size);
+    data = NULL;
+    data_size = 0;
+    clear();
+}
+
+bool Terrain_model::is_loaded(){
+    boost::lock_guard<boost::mutex> lock(mutex);
+    return data != NULL;
+}
+
+void Terrain_model::clear(){
+    columns = rows = tile_columns = 0;
+    west = north = cell_size = 0;
+    no_data = -9999;
+    swap_bytes = false;
+    tiles.clear();
+    recently_used.clear();
+}
+
+double Terrain_model::sample(double lat, double lon){
+    double elevation;
+    sample(&lat, &lon, 1, &elevation);
+    return elevation;
+}
+
+// The points are counted into their tiles first, so each tile is looked up once per batch
+// however the points are spread
+void Terrain_model::sample(const double *lat, const double *lon, int count, double *elevation){
+
+    boost::lock_guard<boost::mutex> lock(mutex);
+    for (int i=0; i<count; i++) elevation[i] = not_a_number;
+    if (!data) return;
+
+    // the tile of each point (-1 off the raster) and where in its cell it is
+    std::vector<int> key(count, -1), column(count), row(count);
+    std::vector<double> across(count), down(count);
+    int least_key(std::numeric_limits<int>::max()), most_key(-1);
+    for (int i=0; i<count; i++){
+        double c = (lon[i] - west) / cell_size - 0.5;
+        double r = (north - lat[i]) / cell_size - 0.5;
+        // half a post past the outer ones is still on the raster
+        if (!(c >= -0.5) || !(c <= columns - 0.5) || !(r >= -0.5) || !(r <= rows - 0.5)) continue;
+        c = std::max(0.0, std::min(columns - 1.0, c));
+        r = std::max(0.0, std::min(rows - 1.0, r));
+        column[i] = std::min((int) c, columns - 2);
+        row[i] = std::min((int) r, rows - 2);
+        across[i] = c - column[i];
+        down[i] = r - row[i];
+        key[i] = (row[i] / tile_step) * tile_columns + column[i] / tile_step;
+        least_key = std::min(least_key, key[i]);
+        most_key = std::max(most_key, key[i]);
+    }
+    if (most_key < 0) return;
+
+    std::vector<int> first(most_key - least_key + 2, 0), order(count);
+    for (int i=0; i<count; i++){
+        if (key[i] >= 0) first[key[i] - least_key + 1]++;
+    }
+    for (int k=1; k<first.size(); k++) first[k] += first[k - 1];
+    int placed = first.back();
+    std::vector<int> fill(first.begin(), first.end() - 1);
+    for (int i=0; i<count; i++){
+        if (key[i] >= 0) order[fill[key[i] - least_key]++] = i;
+    }
+
+    const Tile *current(NULL);
+    int current_key(-1);
+    for (int k=0; k<placed; k++){
+        int i = order[k];
+        if (key[i] != current_key){
+            current_key = key[i];
+            current = &tile(current_key);
+        }
+        const float *posts = &current->posts[(row[i] % tile_step) * tile_posts + column[i] % tile_step];
+        double corner[4] = { posts[0], posts[1], posts[tile_posts], posts[tile_posts + 1] };
+        double weight[4] = { (1 - across[i]) * (1 - down[i]), across[i] * (1 - down[i]),
+                             (1 - across[i]) * down[i], across[i] * down[i] };
+        // the no data posts drop out, the others share their weight
+        double sum(0), total(0);
+        for (int j=0; j<4; j++){
+            if (std::isnan(corner[j])) continue;
+            sum += weight[j] * corner[j];
+            total += weight[j];
+        }
+        if (total > 0) elevation[i] = sum / total;
+    }
+}
+
+// the tile from the cache, copied out of the map if it isn't there; it stays valid until the
+// next call
+const Terrain_model::Tile &Terrain_model::tile(int key){
+
+    std::map<int, Tile>::iterator found = tiles.find(key);
+    if (found != tiles.end()){
+        recently_used.splice(recently_used.begin(), recently_used, found->second.used);
+        return found->second;
+    }
+
+    // the posts of the least recently used tile are reused, not given back
+    std::vector<float> posts;
+    if (tiles.size() >= max_tiles){
+        std::map<int, Tile>::iterator oldest = tiles.find(recently_used.back());
+        posts.swap(oldest->second.posts);
+        tiles.erase(oldest);
+        recently_used.pop_back();
+    }
+    Tile &fresh = tiles[key];
+    recently_used.push_front(key);
+    fresh.used = recently_used.begin();
+    fresh.posts.swap(posts);
+    fresh.posts.resize(tile_posts * tile_posts);
+    int first_column = (key % tile_columns) * tile_step;
+    int first_row = (key / tile_columns) * tile_step;
+    int last_column = std::min(first_column + tile_posts, columns);
+    int last_row = std::min(first_row + tile_posts, rows);
+    // past the east and south edges of the raster
+    if ((last_column - first_column < tile_posts) || (last_row - first_row < tile_posts)){
+        std::fill(fresh.posts.begin(), fresh.posts.end(), std::numeric_limits<float>::quiet_NaN());
+    }
+    for (int r = first_row; r < last_row; r++){
+        float *out = &fresh.posts[(r - first_row) * tile_posts];
+        copy_posts(first_column, r, last_column - first_column, out);
+    }
+    return fresh;
+}
+
+// a stretch of one row of the raster, in the host byte order and with NaN for no data
+void Terrain_model::copy_posts(int column, int row, int count, float *out) const {
+
+    const unsigned char *bytes = data + ((size_t) row * columns + column) * sizeof(float);
+    std::memcpy(out, bytes, count * sizeof(float));
+    const float missing = std::numeric_limits<float>::quiet_NaN();
+    for (int i=0; i<count; i++){
+        if (swap_bytes){
+            uint32_t word;
+            std::memcpy(&word, &out[i], sizeof(word));
+            word = __builtin_bswap32(word);
+            std::memcpy(&out[i], &word, sizeof(word));
+        }
+        if ((out[i] == no_data) || !std::isfinite(out[i])) out[i] = missing;
+    }
+}
+
+} // namespace qtnp
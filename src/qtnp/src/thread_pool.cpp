@@ -0,0 +1,199 @@
+/**
+ * @file /src/thread_pool.cpp
+ *
+ * @brief Planning thread pool and serial job queues on top of it
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <algorithm>
+#include <exception>
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "../include/qtnp/logging.hpp"
+#include "../include/qtnp/thread_pool.hpp"
+
+/*****************************************************************************
+** Helpers
+*****************************************************************************/
+
+namespace {
+
+// shared between the caller of run_all and the pool threads helping it
+struct Batch {
+    std::vector<qtnp::Thread_pool::job_type> jobs;
+    size_t next, finished;
+    std::exception_ptr error;
+    boost::mutex batch_mutex;
+    boost::condition_variable batch_done;
+
+    Batch() : next(0), finished(0) {}
+};
+
+void process_batch(boost::shared_ptr<Batch> batch){
+
+    while (true){
+        size_t index;
+        {
+            boost::lock_guard<boost::mutex> lock(batch->batch_mutex);
+            if (batch->next >= batch->jobs.size()) return;
+            index = batch->next++;
+        }
+
+        std::exception_ptr error;
+        try {
+            batch->jobs[index]();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        boost::lock_guard<boost::mutex> lock(batch->batch_mutex);
+        if (error && !batch->error) batch->error = error;
+        if (++batch->finished == batch->jobs.size()) batch->batch_done.notify_all();
+    }
+}
+
+}
+
+namespace qtnp {
+
+/*****************************************************************************
+** Implementation [Thread_pool]
+*****************************************************************************/
+
+Thread_pool::Thread_pool(int threads_requested) :
+    thread_count(threads_requested > 0 ? threads_requested : (int) boost::thread::hardware_concurrency()),
+    stopping(false)
+{
+    if (thread_count < 1) thread_count = 1;
+    for (int i=0; i<thread_count; i++){
+        threads.create_thread(boost::bind(&Thread_pool::worker, this));
+    }
+}
+
+Thread_pool::~Thread_pool(){
+    {
+        boost::lock_guard<boost::mutex> lock(queue_mutex);
+        stopping = true;
+        jobs.clear();
+    }
+    queue_condition.notify_all();
+    threads.join_all();
+}
+
+void Thread_pool::post(const job_type &job){
+    {
+        boost::lock_guard<boost::mutex> lock(queue_mutex);
+        jobs.push_back(job);
+    }
+    queue_condition.notify_one();
+}
+
+void Thread_pool::run_all(const std::vector<job_type> &batch_jobs){
+
+    if (batch_jobs.empty()) return;
+
+    boost::shared_ptr<Batch> batch = boost::make_shared<Batch>();
+    batch->jobs = batch_jobs;
+
+    // helpers that get scheduled after the batch is done simply find nothing left to do
+    int helpers = std::min((int) batch_jobs.size() - 1, thread_count);
+    for (int i=0; i<helpers; i++){
+        post(boost::bind(&process_batch, batch));
+    }
+    process_batch(batch);
+
+    boost::unique_lock<boost::mutex> lock(batch->batch_mutex);
+    while (batch->finished < batch->jobs.size()){
+        batch->batch_done.wait(lock);
+    }
+    if (batch->error) std::rethrow_exception(batch->error);
+}
+
+void Thread_pool::worker(){
+
+    while (true){
+        job_type job;
+        {
+            boost::unique_lock<boost::mutex> lock(queue_mutex);
+            while (!stopping && jobs.empty()){
+                queue_condition.wait(lock);
+            }
+            if (stopping) return;
+            job = jobs.front();
+            jobs.pop_front();
+        }
+
+        try {
+            job();
+        } catch (const std::exception &e) {
+            QTNP_ERROR(General, "Planning pool job failed: " << e.what());
+        } catch (...) {
+            QTNP_ERROR(General, "Planning pool job failed with an unknown exception");
+        }
+    }
+}
+
+/*****************************************************************************
+** Implementation [Serial_queue]
+*****************************************************************************/
+
+void Serial_queue::post(const job_type &job){
+
+    bool start_draining(false);
+    {
+        boost::lock_guard<boost::mutex> lock(queue_mutex);
+        jobs.push_back(job);
+        if (!draining){
+            draining = true;
+            start_draining = true;
+        }
+    }
+    if (start_draining) pool_ref.post(boost::bind(&Serial_queue::drain, this));
+}
+
+int Serial_queue::pending(){
+    boost::lock_guard<boost::mutex> lock(queue_mutex);
+    return jobs.size() + (draining ? 1 : 0);
+}
+
+void Serial_queue::wait_idle(){
+    boost::unique_lock<boost::mutex> lock(queue_mutex);
+    while (draining || !jobs.empty()){
+        idle_condition.wait(lock);
+    }
+}
+
+void Serial_queue::drain(){
+
+    while (true){
+        job_type job;
+        {
+            boost::lock_guard<boost::mutex> lock(queue_mutex);
+            if (jobs.empty()){
+                draining = false;
+                // the waiter may destroy the queue as soon as the lock is released
+                idle_condition.notify_all();
+                return;
+            }
+            job = jobs.front();
+            jobs.pop_front();
+        }
+
+        try {
+            job();
+        } catch (const std::exception &e) {
+            QTNP_ERROR(General, "Serial planning job failed: " << e.what());
+        } catch (...) {
+            QTNP_ERROR(General, "Serial planning job failed with an unknown exception");
+        }
+    }
+}
+
+} // namespace qtnp
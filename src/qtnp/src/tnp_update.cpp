@@ -13,9 +13,27 @@
 *****************************************************************************/
 
 #include <ros/ros.h>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+#include <CGAL/version.h>
 
 #include "../include/qtnp/tnp_update.hpp"
 #include "../include/qtnp/utilities.hpp"
+#include "../include/qtnp/geometry_kernels.hpp"
+#include "../include/qtnp/multilevel_partitioner.hpp"
+#include "../include/qtnp/voronoi_partitioner.hpp"
+#include "../include/qtnp/tour_optimizer.hpp"
+#include "../include/qtnp/session_snapshot.hpp"
+#include "../include/qtnp/logging.hpp"
 
 #include "qtnp/InitialCoordinates.h"
 #include "qtnp/Coordinates.h"
@@ -43,19 +61,6 @@ inline double round( double val )
     return floor(val + 0.5);
 }
 
-// Get current date/time, format is YYYY-MM-DD.HH:mm:ss
-const std::string currentDateTime() {
-    time_t     now = time(0);
-    struct tm  tstruct;
-    char       buf[80];
-    tstruct = *localtime(&now);
-    // Visit http://en.cppreference.com/w/cpp/chrono/c/strftime
-    // for more information about date/time format
-    strftime(buf, sizeof(buf), "%Y-%m-%d.%X", &tstruct);
-
-    return buf;
-}
-
 bool list_contains(int id, std::vector<std::pair<int,int> > list){
 
     std::vector<std::pair<int,int> >::iterator it = std::find_if(list.begin(), list.end(), comp(id));
@@ -78,6 +83,288 @@ std::pair<int,int>& get_agent_pair_by_id(int id, std::vector<std::pair<int,int>
     if (it != map.end()) return *it;
 }
 
+// Lloyd iterations after meshing, the whole area and every remeshed region alike
+const int lloyd_iterations(20); // TODO hardcoded, put in ui
+// smoothing passes after a local mesh change, in place of the global Lloyd iterations
+const int local_smoothing_iterations(5);
+// a Voronoi partition further off its targets than this is balanced along the borders after
+const double voronoi_balance_tolerance(0.03);
+const int voronoi_balance_passes(50);
+// and one the balancing leaves further off than this is partitioned again, multilevel
+const double voronoi_fallback_tolerance(0.05);
+// the waypoint tolerance that follows the cell size, in cell sides. The centroids along a
+// straight run of cells zigzag by a third of the cell height, about 0.3 sides
+const double waypoint_tolerance_sides(0.5);
+
+typedef std::pair<CDT::Vertex_handle, CDT::Vertex_handle> Vertex_pair;
+
+// The constrained edges one outline edge from a to b was split into. The mesher splits at
+// computed midpoints, on the segment only up to rounding, so the pieces are walked from the
+// vertex at a to the vertex at b: every step takes the constrained neighbour nearer b that is
+// closest to the line. Constraints of other polygons never join the chain, whatever line they
+// lie on. False if the chain is broken
+bool outline_edge_pieces(CDT &cdt, const CDT::Point &a, const CDT::Point &b, std::vector<Vertex_pair> &pieces){
+
+    CDT::Locate_type type;
+    int index;
+    CDT::Face_handle face = cdt.locate(a, type, index);
+    if (type != CDT::VERTEX) return false;
+    CDT::Vertex_handle current = face->vertex(index);
+    face = cdt.locate(b, type, index, face);
+    if (type != CDT::VERTEX) return false;
+    CDT::Vertex_handle end = face->vertex(index);
+
+    double sx = b.x() - a.x();
+    double sy = b.y() - a.y();
+    double length2 = sx * sx + sy * sy;
+    std::vector<Vertex_pair> chain;
+    while (current != end){
+        CDT::Vertex_handle next;
+        double closest = std::numeric_limits<double>::max();
+        double remaining = CGAL::squared_distance(current->point(), b);
+        CDT::Edge_circulator edge = cdt.incident_edges(current), done(edge);
+        do {
+            if (cdt.is_infinite(*edge) || !cdt.is_constrained(*edge)) continue;
+            CDT::Vertex_handle other = edge->first->vertex(CDT::cw(edge->second));
+            if (other == current) other = edge->first->vertex(CDT::ccw(edge->second));
+            if (!(CGAL::squared_distance(other->point(), b) < remaining)) continue;
+            double cross = (other->point().x() - a.x()) * sy - (other->point().y() - a.y()) * sx;
+            if (cross * cross < closest){
+                closest = cross * cross;
+                next = other;
+            }
+        } while (++edge != done);
+        // off the line by more than the rounding of a midpoint, the chain ends here
+        if (closest > 1e-18 * length2 * length2) return false;
+        chain.push_back(std::make_pair(current, next));
+        current = next;
+    }
+    pieces.insert(pieces.end(), chain.begin(), chain.end());
+    return true;
+}
+
+// for partitioning the cells of the coverage order by ring
+struct Coverage_depth_at_least
+{
+    Coverage_depth_at_least(const qtnp::Cell_table &table, int depth) : cells(table), _depth(depth) { }
+
+    bool operator () (int id) const
+    {
+        return (cells.face(id)->info().coverage_depth >= _depth);
+    }
+
+    const qtnp::Cell_table &cells;
+    int _depth;
+};
+
+// a border cell of a shrinking agent: (next to an agent short of cells, depth)
+typedef std::pair<std::pair<int,int>, CDT::Face_handle> Release_entry;
+
+// the cells next to agents short of cells first, then the deepest
+bool release_order(const Release_entry &a, const Release_entry &b){
+    return a.first > b.first;
+}
+
+// a border edge of a region, its smaller end first
+typedef std::pair<CDT::Point, CDT::Point> Border_edge;
+
+Border_edge border_edge(const CDT::Point &a, const CDT::Point &b){
+    return (b < a) ? Border_edge(b, a) : Border_edge(a, b);
+}
+
+// the region of one agent, meshed on its own by mesh_region
+struct Region_mesh {
+    double size_bound;
+    std::vector<Border_edge> border;   // the coarse edges around it, holes and other regions included
+    std::vector<CDT::Point> seeds;     // a point in every connected piece of it
+    // what the mesher made of it: the vertices inside, and the points it put on each border
+    // edge, in order from the first end
+    std::vector<CDT::Point> inside;
+    std::map<Border_edge, std::vector<CDT::Point> > splits;
+};
+
+struct Closer_to {
+    Closer_to(const CDT::Point &p) : origin(p) {}
+    bool operator()(const CDT::Point &a, const CDT::Point &b) const {
+        return CGAL::squared_distance(origin, a) < CGAL::squared_distance(origin, b);
+    }
+    CDT::Point origin;
+};
+
+// Every border edge split into pieces no longer than the finest size bound of the regions
+// on either side of it, the same points for both. A coarse region then meshes up to the
+// points a fine neighbour needs and grades away from them, instead of meeting the splits of
+// the fine side only in the merged mesh, with long thin faces in between
+void split_borders(std::vector<Region_mesh> &regions){
+
+    std::map<Border_edge, double> finest;
+    for (int r=0; r<regions.size(); r++){
+        if (!(regions[r].size_bound > 0)) continue;
+        for (int i=0; i<regions[r].border.size(); i++){
+            std::map<Border_edge, double>::iterator found = finest.find(regions[r].border[i]);
+            if (found == finest.end()) finest[regions[r].border[i]] = regions[r].size_bound;
+            else found->second = std::min(found->second, regions[r].size_bound);
+        }
+    }
+
+    std::map<Border_edge, std::vector<Border_edge> > pieces;
+    for (std::map<Border_edge, double>::const_iterator it = finest.begin(); it != finest.end(); ++it){
+        const CDT::Point &a = it->first.first;
+        const CDT::Point &b = it->first.second;
+        int count = (int) std::ceil(std::sqrt(CGAL::squared_distance(a, b)) / it->second);
+        if (count < 2) continue;
+        std::vector<Border_edge> &edge_pieces = pieces[it->first];
+        CDT::Point previous = a;
+        for (int k=1; k<=count; k++){
+            // the last point is the end itself, not a rounded one next to it
+            CDT::Point next = (k < count) ? CDT::Point(a.x() + (b.x() - a.x()) * k / count, a.y() + (b.y() - a.y()) * k / count) : b;
+            edge_pieces.push_back(border_edge(previous, next));
+            previous = next;
+        }
+    }
+
+    for (int r=0; r<regions.size(); r++){
+        std::vector<Border_edge> border;
+        for (int i=0; i<regions[r].border.size(); i++){
+            std::map<Border_edge, std::vector<Border_edge> >::const_iterator found = pieces.find(regions[r].border[i]);
+            if (found == pieces.end()) border.push_back(regions[r].border[i]);
+            else border.insert(border.end(), found->second.begin(), found->second.end());
+        }
+        regions[r].border.swap(border);
+    }
+}
+
+// Runs on a thread of its own: the border as constraints, the pieces of the region as the
+// domain, refined to the size bound, and the sizing field if there is one, and smoothed as
+// the whole area is. Cancelling is checked between the mesher steps; the progress stays with
+// the thread that waits for the regions
+void mesh_region(Region_mesh &region, double angle_bound, const qtnp::Sizing_field *field,
+                 const qtnp::Planning_control &control){
+
+    CDT mesh;
+    std::set<CDT::Point> corners;
+    for (int i=0; i<region.border.size(); i++){
+        CDT::Vertex_handle a = mesh.insert(region.border[i].first);
+        CDT::Vertex_handle b = mesh.insert(region.border[i].second, a->face());
+        mesh.insert_constraint(a, b);
+        corners.insert(region.border[i].first);
+        corners.insert(region.border[i].second);
+    }
+
+    Graded_mesher mesher(mesh, Graded_criteria(angle_bound, region.size_bound, field));
+    mesher.set_seeds(region.seeds.begin(), region.seeds.end(), true);
+    mesher.init();
+    while (!mesher.is_refinement_done()){
+        if (control.is_cancel_requested()) throw qtnp::Planning_cancelled("Remeshing regions");
+        mesher.step_by_step_refine_mesh();
+    }
+    // as for the whole mesh, one iteration per call up to convergence
+    for (int i=0; i<lloyd_iterations; i++){
+        if (control.is_cancel_requested()) throw qtnp::Planning_cancelled("Remeshing regions");
+        if (CGAL::lloyd_optimize_mesh_2(mesh, CGAL::parameters::max_iteration_number = 1) == CGAL::CONVERGENCE_REACHED) break;
+    }
+
+    // the constrained edges are the border, split where the mesher needed it
+    std::map<CDT::Vertex_handle, std::vector<CDT::Vertex_handle> > along;
+    for (CDT::Finite_edges_iterator edge = mesh.finite_edges_begin(); edge != mesh.finite_edges_end(); ++edge){
+        if (!mesh.is_constrained(*edge)) continue;
+        CDT::Vertex_handle a = edge->first->vertex(mesh.cw(edge->second));
+        CDT::Vertex_handle b = edge->first->vertex(mesh.ccw(edge->second));
+        along[a].push_back(b);
+        along[b].push_back(a);
+    }
+    for (CDT::Finite_vertices_iterator vertex = mesh.finite_vertices_begin(); vertex != mesh.finite_vertices_end(); ++vertex){
+        if (along.count(vertex) == 0) region.inside.push_back(vertex->point());
+    }
+
+    // from every corner along each of its border edges to the next corner; the points passed
+    // on the way are the splits of that coarse edge. Each edge is walked from both ends, it is
+    // kept from its first one
+    for (std::map<CDT::Vertex_handle, std::vector<CDT::Vertex_handle> >::iterator it = along.begin(); it != along.end(); ++it){
+        if (corners.count(it->first->point()) == 0) continue;
+        for (int k=0; k<it->second.size(); k++){
+            std::vector<CDT::Point> points;
+            CDT::Vertex_handle previous = it->first, current = it->second[k];
+            bool whole(true);
+            while (corners.count(current->point()) == 0){
+                const std::vector<CDT::Vertex_handle> &ends = along[current];
+                if (ends.size() != 2){
+                    whole = false;
+                    break;
+                }
+                points.push_back(current->point());
+                CDT::Vertex_handle next = (ends[0] == previous) ? ends[1] : ends[0];
+                previous = current;
+                current = next;
+            }
+            if (!whole || points.empty() || !(it->first->point() < current->point())) continue;
+            region.splits[Border_edge(it->first->point(), current->point())] = points;
+        }
+    }
+}
+
+// FaceInfo2 and the domain flag of one face, as the snapshot keeps them
+struct Face_record {
+    int32_t id;
+    int16_t depth, coverage_depth, jumps_agent_id;
+    int8_t agent_id;
+    uint8_t flags;
+};
+enum Face_flags { Face_visited = 1, Face_numbered = 2, Face_path_visited = 4, Face_cover_depth = 8, Face_aux = 16,
+                  Face_occupied = 32, Face_in_domain = 64 };
+
+void put_waypoint_list(qtnp::Snapshot_buffer &buffer, int uas_id, const mavros_msgs::WaypointList &list){
+
+    buffer.put((int32_t) uas_id);
+    buffer.put((uint64_t) list.waypoints.size());
+    for (int i=0; i<list.waypoints.size(); i++){
+        const mavros_msgs::Waypoint &waypoint = list.waypoints[i];
+        buffer.put((uint8_t) waypoint.frame);
+        buffer.put((uint16_t) waypoint.command);
+        buffer.put((uint8_t) waypoint.is_current);
+        buffer.put((uint8_t) waypoint.autocontinue);
+        buffer.put((float) waypoint.param1);
+        buffer.put((float) waypoint.param2);
+        buffer.put((float) waypoint.param3);
+        buffer.put((float) waypoint.param4);
+        buffer.put((double) waypoint.x_lat);
+        buffer.put((double) waypoint.y_long);
+        buffer.put((float) waypoint.z_alt);
+    }
+}
+
+bool get_waypoint_list(qtnp::Snapshot_cursor &cursor, int &uas_id, mavros_msgs::WaypointList &list){
+
+    int32_t id;
+    uint64_t count;
+    if (!cursor.get(id) || !cursor.get(count)) return false;
+    uas_id = id;
+    list.waypoints.clear();
+    for (uint64_t i=0; i<count; i++){
+        uint8_t frame, is_current, autocontinue;
+        uint16_t command;
+        float param1, param2, param3, param4, z_alt;
+        double x_lat, y_long;
+        if (!(cursor.get(frame) && cursor.get(command) && cursor.get(is_current) && cursor.get(autocontinue) &&
+              cursor.get(param1) && cursor.get(param2) && cursor.get(param3) && cursor.get(param4) &&
+              cursor.get(x_lat) && cursor.get(y_long) && cursor.get(z_alt))) return false;
+        mavros_msgs::Waypoint waypoint;
+        waypoint.frame = frame;
+        waypoint.command = command;
+        waypoint.is_current = is_current;
+        waypoint.autocontinue = autocontinue;
+        waypoint.param1 = param1;
+        waypoint.param2 = param2;
+        waypoint.param3 = param3;
+        waypoint.param4 = param4;
+        waypoint.x_lat = x_lat;
+        waypoint.y_long = y_long;
+        waypoint.z_alt = z_alt;
+        list.waypoints.push_back(waypoint);
+    }
+    return true;
+}
+
 namespace qtnp {
 
 /*****************************************************************************
@@ -86,54 +373,13 @@ namespace qtnp {
 
     int Tnp_update::coordinates_to_cdt_cell_id(double lat, double lon){
 
-        std::vector<std::pair<int, geometry_msgs::Point> > id_center_list(this->rviz_objects_ref.get_center_points_with_cell_id());
-
         // TODO: they are upside down. if test file is correct, change lat, lon
-        double cdt_lat = utilities::convert_range(this->area_extremes.min_lat,this->area_extremes.max_lat,
-                                    constants::rviz_range_min,constants::rviz_range_max,lon);//here
-        double cdt_lon = utilities::convert_range(this->area_extremes.min_lon,this->area_extremes.max_lon,
-                                    constants::rviz_range_min,constants::rviz_range_max,lat); // and here
-
-        kernel_Point_2 initial_position(cdt_lat, cdt_lon);
-
-        int result_id(0);
-        int comparison_id(0);
-
-        //FIXME refactor conversion below, its a spaggeti shit
-        for (int j=0; j<id_center_list.size(); j++){
-
-            CGAL::Comparison_result result =
-                    CGAL::compare_distance_to_point(
-                        initial_position,
-                          utilities::ros_to_cgal_point(id_center_list[j].second),
-                            utilities::ros_to_cgal_point(id_center_list[j+1].second));
-
-            if (result == CGAL::SMALLER){
-                if (CGAL::compare_distance_to_point(
-                            initial_position,
-                              utilities::ros_to_cgal_point(id_center_list[j].second),
-                                utilities::ros_to_cgal_point(id_center_list[comparison_id].second)) == CGAL::SMALLER){
-                    comparison_id = j;
-                    result_id = id_center_list[j].first;
-                } else {
-                    comparison_id = comparison_id;
-                    result_id = id_center_list[comparison_id].first;
-                }
-            } else {
-                if (CGAL::compare_distance_to_point(
-                            initial_position,
-                              utilities::ros_to_cgal_point(id_center_list[j].second),
-                                utilities::ros_to_cgal_point(id_center_list[comparison_id].second)) == CGAL::SMALLER){
-                    comparison_id = j;
-                    result_id = id_center_list[j].first;
-                } else {
-                    comparison_id = comparison_id;
-                    result_id = id_center_list[comparison_id].first;
-                }
+        double cdt_lat, cdt_lon;
+        geo.to_mesh(lon, lat, cdt_lat, cdt_lon);
 
-            }
-        }
-        return result_id;
+        // the ids are the indices of the cell table, so the nearest centroid is the cell
+        int result_id = kernels::nearest(cells.xs(), cells.ys(), cells.size(), cdt_lat, cdt_lon);
+        return (result_id < 0) ? 0 : result_id;
     }
 
     std::vector<int> Tnp_update::find_path(int a, int b){
@@ -178,11 +424,7 @@ namespace qtnp {
           faces_iterator != cdt.finite_faces_end(); ++faces_iterator){
             if (faces_iterator->is_in_domain()){
                 int agent = faces_iterator->info().agent_id;
-                if (agent > cells_per_agent.size()) {
-                   for( int i=0; i<= (agent - cells_per_agent.size()); i++){
-                    cells_per_agent.push_back(0);
-                    }
-                }
+                if (agent >= (int) cells_per_agent.size()) cells_per_agent.resize(agent + 1, 0);
                 cells_per_agent[agent] = cells_per_agent[agent] + 1;
             }
         }
@@ -333,28 +575,23 @@ namespace qtnp {
 
     void Tnp_update::moveCOV(int cells, std::vector<int> path){
 
-        std::cout << "the path: [";
-        for (int i=0; i<path.size(); i++){
-            std::cout << path[i] << " ";
-        }
-        std::cout << "]" << std::endl;
+        QTNP_DEBUG(Partitioning, "COV: the path: [" << logging::join(path) << "]");
 
         for (int i=0; i<path.size() -1; i++){
 
             int adjacent_cells = count_adjacent_cells(path[i], path[i+1]);
             if (adjacent_cells >= cells){
                 exchange_agent_on_border_cells(path[i], path[i+1], cells);
-                std::cout << "COV: tried to move " << cells << " cells from agent " << path[i+1] << " to agent " << path[i] << std::endl;
+                QTNP_DEBUG(Partitioning, "COV: tried to move " << cells << " cells from agent " << path[i+1] << " to agent " << path[i]);
             } else {
                 std::vector<int> rest_of_the_path;
                 for (int j = i; j < path.size(); j++) {
                     rest_of_the_path.push_back(path[j]);
                 }
-                std::cout << "]" << std::endl;
                 moveCOV(adjacent_cells, rest_of_the_path);
                 cells = cells - adjacent_cells;
-                std::cout << "COV: tried to move " << adjacent_cells << " ADJACENT CELLS from agent " << path[i+1] << " to agent " << path[i] << std::endl;
-                std::cout << "COV: Those: " << cells << " cells remained " << std::endl;
+                QTNP_DEBUG(Partitioning, "COV: tried to move " << adjacent_cells << " ADJACENT CELLS from agent " << path[i+1]
+                           << " to agent " << path[i] << ", " << cells << " cells remained");
                 i--;
             }
         }
@@ -364,11 +601,7 @@ namespace qtnp {
 
         clear_aux();
         int cells_remaining = cells;
-        std::cout << "the path: [";
-        for (int i=0; i<path.size(); i++){
-            std::cout << path[i] << " ";
-        }
-        std::cout << "]" << std::endl;
+        QTNP_DEBUG(Partitioning, "the path: [" << logging::join(path) << "]");
 
         for (int i=0; i<path.size() -1; i++){
 
@@ -429,8 +662,8 @@ namespace qtnp {
 
             clear_aux();
 
-            std::cout << "tried to move " << cells << " cells from agent " << path[i+1] << " to agent " << path[i] << std::endl;
-            std::cout << cells_remaining << " cells remained somewhere.." << std::endl;
+            QTNP_DEBUG(Partitioning, "tried to move " << cells << " cells from agent " << path[i+1] << " to agent " << path[i]
+                       << ", " << cells_remaining << " cells remained somewhere..");
             if (cells_remaining > 0) {
                 std::vector<int> remaining_vector;
                 remaining_vector.push_back(path[i]);
@@ -439,7 +672,7 @@ namespace qtnp {
                     cells_remaining = move(cells_remaining, remaining_vector);
                 }
                 if (cells_remaining > 0){
-                    std::cout << "these cells remain:" << cells_remaining << std::endl;
+                    QTNP_DEBUG(Partitioning, "these cells remain: " << cells_remaining);
 
                       std::vector<int> new_path = find_path(path[i], path[i+1]);
                       cells_remaining = move(cells_remaining, new_path);
@@ -455,6 +688,12 @@ namespace qtnp {
     void Tnp_update::init(){
 
         cdt.clear();
+        cells.clear();
+        tracker.reset(0);
+        holes.clear();
+        next_hole_id = 0;
+        regions_remeshed = false;
+        sizing_field = Sizing_field();
         cdt_polygon_edges.clear();
         rviz_objects_ref.clear_edges();
         rviz_objects_ref.clear_center_points();
@@ -466,22 +705,75 @@ namespace qtnp {
         area_extremes.min_lon = -constants::min_lon;
     }
 
+    Tnp_update::Planning_job::Planning_job(Tnp_update &update, Planning_control &control) :
+        update_ref(update), control_ref(control), job_lock(update.job_mutex)
+    {
+        boost::lock_guard<boost::mutex> lock(update.job_ptr_mutex);
+        update.job_ptr = this;
+    }
+
+    Tnp_update::Planning_job::~Planning_job(){
+
+        boost::lock_guard<boost::mutex> lock(update_ref.job_ptr_mutex);
+        update_ref.job_ptr = NULL;
+    }
+
+    void Tnp_update::cancel_job(){
+
+        boost::lock_guard<boost::mutex> lock(job_ptr_mutex);
+        Planning_job *job = job_ptr.load();
+        if (job) job->control().request_cancel();
+    }
+
+    Planning_control &Tnp_update::planning_control(){
+
+        Planning_job *job = job_ptr.load();
+        return job ? job->control() : idle_control;
+    }
+
+    void Tnp_update::keep_path_results(){
+
+        Planning_job *job = job_ptr.load();
+        if (!job) return;
+        job->path = rviz_objects_ref.get_path();
+        job->waypoints = get_waypoint_list();
+    }
+
     // custom callback function of the ROS listener for polygpn definition
     void Tnp_update::polygon_def_callback(const Placemarks::ConstPtr &msg){
 
         std::vector<Coordinates> placemarks_array = msg->placemarks;
 
-        // for service calls, performs cdt with default angle, edge constrains
-        perform_polygon_definition(placemarks_array, constants::angle_criterion_default, constants::edge_criterion_default);
+        // for service calls, performs cdt with default angle, edge constrains. A job of its own,
+        // a cancel of the gui or of an action goal doesn't reach it, nor it theirs
+        Planning_control control;
+        try {
+            Planning_job job(*this, control);
+            perform_polygon_definition(placemarks_array, constants::angle_criterion_default, constants::edge_criterion_default);
+        } catch (const Planning_cancelled &e) {
+            QTNP_WARN(Meshing, e.what());
+        }
+    }
+
+    // runs the mesher one inserted point at a time, so a cancel request is seen while refining
+    template <class Mesher_type>
+    void Tnp_update::refine_with_checkpoints(Mesher_type &mesher, const char *stage){
+
+        while (!mesher.is_refinement_done()){
+            mesher.step_by_step_refine_mesh();
+            planning_control().checkpoint(stage, cdt.number_of_vertices(), 0);
+        }
     }
 
     // TODO transform edge size to rviz size
     void Tnp_update::perform_polygon_definition(std::vector<Coordinates> placemarks_array, double angle_cons, double edge_cons){
 
-        ROS_INFO_STREAM("Got a new polygon definition");
+        QTNP_INFO(Meshing, "Got a new polygon definition");
+
+        boost::lock_guard<boost::mutex> lock(planning_mutex);
+        mesh_ready = partition_ready = false;
 
         init();
-        std::cout << std::setprecision(7);
 
         // define minimum and maximum values of the constrained area so to convert lat,lon to visualization ranges
         for (std::vector<Coordinates>::iterator it = placemarks_array.begin(); it<placemarks_array.end(); it++){
@@ -504,34 +796,54 @@ namespace qtnp {
             }
         }
 
+        // scale and offset worked out once, every conversion below uses them
+        geo.set_projection((Geo_transform::Projection) mesh_projection.load());
+        geo.fit(area_extremes.min_lat, area_extremes.max_lat, area_extremes.min_lon, area_extremes.max_lon);
+
         std::list<CDT::Point> list_of_seeds;
+        // the "size" placemarks, and the outlines that ask for a size along them, go into sizing_field
         // convert ranges, draw CDT and visualization objects
         for (std::vector<qtnp::Coordinates>::iterator it = placemarks_array.begin(); it<placemarks_array.end(); it++){
 
-            int size = it->longitude.size();
+            int size = std::min(it->longitude.size(), it->latitude.size());
             std::vector<double> longitude_array(size);
             std::vector<double> latitude_array(size);
             bool is_an_obstacle = (it->placemark_type == "hole") ? true :false;
 
-            if (is_an_obstacle) list_of_seeds.push_back(CDT::Point(
-                        utilities::convert_range(area_extremes.min_lat,area_extremes.max_lat,
-                                    constants::rviz_range_min,constants::rviz_range_max,it->seed_latitude),
-                        utilities::convert_range(area_extremes.min_lon,area_extremes.max_lon,
-                                    constants::rviz_range_min,constants::rviz_range_max,it->seed_longitude)));
+            if (is_an_obstacle){
+                double seed_x, seed_y;
+                geo.to_mesh(it->seed_latitude, it->seed_longitude, seed_x, seed_y);
+                list_of_seeds.push_back(CDT::Point(seed_x, seed_y));
+            }
 
-            longitude_array = it->longitude;
-            latitude_array  = it->latitude;
+            // the whole placemark converted at once
+            if (size > 0) geo.to_mesh(&it->latitude[0], &it->longitude[0], size, &latitude_array[0], &longitude_array[0]);
+
+            // only a sizing attractor, it constrains nothing
+            double target_size = (it->target_size > 0) ? geo.mesh_length(it->target_size) : 0;
+            if (it->placemark_type == "size"){
+                if (target_size <= 0) QTNP_WARN(Meshing, "A size placemark without a target size, ignored");
+                if (it->geometry_type == "LineString") sizing_field.add_polyline(latitude_array, longitude_array, target_size);
+                else sizing_field.add_polygon(latitude_array, longitude_array, target_size);
+                continue;
+            }
+            if (target_size > 0) sizing_field.add_polyline(latitude_array, longitude_array, target_size);
+
+            // kept so that the hole can be removed again later, see remove_hole
+            if (is_an_obstacle && size > 1){
+                Hole hole;
+                hole.id = next_hole_id++;
+                hole.seed = list_of_seeds.back();
+                for (int i=0; i<size; i++) hole.outline.push_back(CDT::Point(latitude_array[i], longitude_array[i]));
+                holes.push_back(hole);
+            }
 
             for (int i=1; i<size; i++){
 
-                double previous_latitude = utilities::convert_range(area_extremes.min_lat,area_extremes.max_lat,
-                                                                    constants::rviz_range_min,constants::rviz_range_max,latitude_array[i-1]);
-                double previous_longitude = utilities::convert_range(area_extremes.min_lon,area_extremes.max_lon,
-                                                                     constants::rviz_range_min,constants::rviz_range_max,longitude_array[i-1]);
-                double current_latitude = utilities::convert_range(area_extremes.min_lat,area_extremes.max_lat,
-                                                                   constants::rviz_range_min,constants::rviz_range_max,latitude_array[i]);
-                double current_longitude = utilities::convert_range(area_extremes.min_lon,area_extremes.max_lon,
-                                                                    constants::rviz_range_min,constants::rviz_range_max,longitude_array[i]);
+                double previous_latitude = latitude_array[i-1];
+                double previous_longitude = longitude_array[i-1];
+                double current_latitude = latitude_array[i];
+                double current_longitude = longitude_array[i];
 
                 // inserting the area definition vertexes by drawing points and connecting them
                 CDT::Vertex_handle va = cdt.insert(CDT::Point(previous_latitude,previous_longitude));
@@ -559,61 +871,104 @@ namespace qtnp {
         }
 
         // TODO: seperate rest of function
-        // FIXME: edge constrain is in cgal points that doesn't correspond to meters.
-        // depending on max values, transform given value
+        // FIXME: with the normalized projection the edge constrain is in cgal points that don't correspond to meters,
+        // with local_enu they are meters.
         double crAngle = angle_cons;// 0.125; -- the default angle criteria
         double crEdge = edge_cons; // 25.0; -- the default edge criteria(50m footprint) (it's the number given/500 (the max rviz range))
-        std::cout << "Number of vertices before meshing and refining: " << cdt.number_of_vertices() << std::endl;
-        std::cout << "Meshing the triangulation with default criteria..." << std::endl;
+        mesh_angle_criterion = crAngle;
+        mesh_edge_criterion = crEdge;
+        QTNP_INFO(Meshing, "Number of vertices before meshing and refining: " << cdt.number_of_vertices());
+        QTNP_DEBUG(Meshing, "Meshing the triangulation with default criteria...");
         Mesher mesher(cdt);
-        mesher.refine_mesh();
-        std::cout << "Number of vertices after meshing: " << cdt.number_of_vertices() << std::endl;
-        std::cout << "Meshing again with new criteria..." << std::endl;
-
-        mesher.set_criteria(Criteria(crAngle, crEdge));
-        mesher.refine_mesh();
-        std::cout << "Number of vertices after meshing and refining with new criteria: "
-                << cdt.number_of_vertices() << std::endl;
+        mesher.init();
+        refine_with_checkpoints(mesher, "Meshing");
+        QTNP_INFO(Meshing, "Number of vertices after meshing: " << cdt.number_of_vertices());
+        QTNP_DEBUG(Meshing, "Meshing again with new criteria...");
+
+        // the edge criterion is the size away from the attractors, the field makes it finer near them
+        double min_x, min_y, max_x, max_y;
+        geo.to_mesh(area_extremes.min_lat, area_extremes.min_lon, min_x, min_y);
+        geo.to_mesh(area_extremes.max_lat, area_extremes.max_lon, max_x, max_y);
+        sizing_field.build(size_grading, crEdge, std::min(min_x, max_x), std::min(min_y, max_y),
+                           std::max(min_x, max_x), std::max(min_y, max_y));
+        Graded_mesher graded_mesher(cdt, Graded_criteria(crAngle, crEdge, sizing_field.empty() ? NULL : &sizing_field));
+        if (sizing_field.empty()){
+            mesher.set_criteria(Criteria(crAngle, crEdge));
+            refine_with_checkpoints(mesher, "Refining mesh");
+        } else {
+            QTNP_INFO(Meshing, "Sizing field of " << sizing_field.attractor_count() << " attractors, down to "
+                      << geo.metres(sizing_field.smallest_size()) << " m, grading " << size_grading.load());
+            graded_mesher.init();
+            refine_with_checkpoints(graded_mesher, "Refining mesh");
+        }
+        QTNP_INFO(Meshing, "Number of vertices after meshing and refining with new criteria: " << cdt.number_of_vertices());
+
+        // one iteration per call, so that a cancel doesn't have to wait for the whole optimization.
+        // Each call starts afresh: the vertices one call for all iterations would freeze (moving
+        // less than freeze_bound) keep being moved, which costs a little more and gives a slightly
+        // different mesh, and convergence is judged on the last iteration alone
+        int lloyd_runs(0);
+        while (lloyd_runs < lloyd_iterations){
+            planning_control().checkpoint("Lloyd optimization", lloyd_runs, lloyd_iterations);
+            lloyd_runs++;
+            if (CGAL::lloyd_optimize_mesh_2(cdt, CGAL::parameters::max_iteration_number = 1) == CGAL::CONVERGENCE_REACHED) break;
+        }
 
-        CGAL::lloyd_optimize_mesh_2(cdt,
-          CGAL::parameters::max_iteration_number = 20); // TODO hardcoded, put in ui
+        // the Lloyd iterations even the cell sizes out, they drift away from the attractors;
+        // refining once more brings the fine cells back where the field wants them
+        if (!sizing_field.empty()){
+            graded_mesher.init();
+            refine_with_checkpoints(graded_mesher, "Refining graded mesh");
+            QTNP_INFO(Meshing, "Number of vertices after refining to the sizing field: " << cdt.number_of_vertices());
+        }
 
         //  Adding the seeds which define the holes.
         if (!list_of_seeds.empty()){
-            std::cout << "Refining and meshing the domain including seeds defining holes" << std::endl;
-            CGAL::refine_Delaunay_mesh_2(cdt, list_of_seeds.begin(), list_of_seeds.end(), Criteria());
-            std::cout << "Number of vertices after meshing CDT refining and seeding holes: " << cdt.number_of_vertices() << std::endl;
+            QTNP_DEBUG(Meshing, "Refining and meshing the domain including seeds defining holes");
+            Mesher seeds_mesher(cdt, Criteria());
+            seeds_mesher.set_seeds(list_of_seeds.begin(), list_of_seeds.end());
+            seeds_mesher.init();
+            refine_with_checkpoints(seeds_mesher, "Meshing holes");
+            QTNP_INFO(Meshing, "Number of vertices after meshing CDT refining and seeding holes: " << cdt.number_of_vertices());
         }
 
-        std::cout << "Number of vertices AFTER LLOYD (20 iterations): " << cdt.number_of_vertices() << std::endl;
+        QTNP_SUMMARY(Meshing, "Mesh done, " << cdt.number_of_vertices() << " vertices after Lloyd optimization ("
+                     << lloyd_runs << " iterations)");
+
+        number_cells();
+        if (!sizing_field.empty()) QTNP_SUMMARY(Meshing, cells.size() << " cells graded by the sizing field");
+
+        mesh_ready = true;
+        rviz_objects_ref.set_polygon_ready(true);
+        save_snapshot("Mesh");
+    }
 
-        // ------------- rviz coloring schema ----------------//
-        // TODO center (waypoints) coloring should go to coloring function.
-        // unfortunately in the same function we also use the center points for further operations before the coloring.
-        // So waypoints (centers) should be distinguished from their coloring cousins.
+    // ------------- rviz coloring schema ----------------//
+    // TODO center (waypoints) coloring should go to coloring function.
+    // unfortunately in the same function we also use the center points for further operations before the coloring.
+    // So waypoints (centers) should be distinguished from their coloring cousins.
+    void Tnp_update::number_cells(){
 
         int initialize_iterator = 0;
+        int total_faces = cdt.number_of_faces();
+        cells.reserve(total_faces);
 
         for(CDT::Finite_faces_iterator faces_iterator = cdt.finite_faces_begin();
             faces_iterator != cdt.finite_faces_end(); ++faces_iterator){
 
+          planning_control().checkpoint("Numbering cells", initialize_iterator, total_faces);
+
           if (faces_iterator->is_in_domain()){
 
             // initialize face, along with it's id. TODO remove it from partition (initialize_mesh function)
+            // the agent a remesh of the regions gave the face stays, a new mesh has none yet
+            int agent = faces_iterator->info().agent_id;
             faces_iterator->info().initialize(initialize_iterator);
+            faces_iterator->info().agent_id = agent;
 
-            // create a point for each of the edges of the face.
-            CDT::Point point1 = cdt.triangle(faces_iterator)[0];
-            CDT::Point point2 = cdt.triangle(faces_iterator)[1];
-            CDT::Point point3 = cdt.triangle(faces_iterator)[2];
-            geometry_msgs::Point center = utilities::face_points_to_center(point1, point2, point3);
-            // adding it's respective lat and lon to its struct
-            // TODO rviz_range_min and max should not be constants e.g. 500x500 because in conversion,
-            // if area is not square like it will create a distortion in visualization. They should be proportional (good luck)
-            faces_iterator->info().center_lat = utilities::convert_range(constants::rviz_range_min,constants::rviz_range_max,
-                                                                         area_extremes.min_lat,area_extremes.max_lat,center.x);
-            faces_iterator->info().center_lon = utilities::convert_range(constants::rviz_range_min,constants::rviz_range_max,
-                                                                         area_extremes.min_lon,area_extremes.max_lon,center.y);
+            // centroid and area computed once here, from one triangle, and kept in the cell table
+            int cell_id = cells.add(faces_iterator, cdt.triangle(faces_iterator));
+            geometry_msgs::Point center = cells.center_point(cell_id);
             // adding the center of every triangle to rviz
             rviz_objects_ref.push_center_point(center);
 
@@ -625,22 +980,340 @@ namespace qtnp {
           }
         }
 
-        rviz_objects_ref.set_polygon_ready(true);
+        // adding the respective lat and lon of every centre, in one batch
+        // TODO with the normalized projection the area is stretched to a square, which distorts
+        // the visualization when the area is not square like; the local_enu projection does not
+        cells.update_coordinates(geo);
+        cells.update_ground(terrain);
+        tracker.reset(cells.size());
+    }
+
+    std::list<CDT::Point> Tnp_update::hole_seeds(){
+
+        std::list<CDT::Point> seeds;
+        for (int i=0; i<holes.size(); i++) seeds.push_back(holes[i].seed);
+        return seeds;
+    }
+
+    // the hole's bounding box with a margin of two edge lengths around it
+    Tnp_update::Mesh_box Tnp_update::hole_neighbourhood(const Hole &hole){
+
+        Mesh_box box;
+        box.min_x = box.max_x = hole.outline[0].x();
+        box.min_y = box.max_y = hole.outline[0].y();
+        for (int i=1; i<hole.outline.size(); i++){
+            box.min_x = std::min(box.min_x, hole.outline[i].x());
+            box.max_x = std::max(box.max_x, hole.outline[i].x());
+            box.min_y = std::min(box.min_y, hole.outline[i].y());
+            box.max_y = std::max(box.max_y, hole.outline[i].y());
+        }
+        double margin = (mesh_edge_criterion > 0) ? 2 * mesh_edge_criterion
+                                                  : 0.25 * std::max(box.max_x - box.min_x, box.max_y - box.min_y);
+        box.min_x -= margin;
+        box.min_y -= margin;
+        box.max_x += margin;
+        box.max_y += margin;
+        return box;
+    }
+
+    int Tnp_update::add_hole(const Coordinates &hole_coordinates){
+
+        boost::lock_guard<boost::mutex> lock(planning_mutex);
+        if (!mesh_ready){
+            QTNP_WARN(Meshing, "Hole insertion requested without a mesh, perform the CDT first");
+            return -1;
+        }
+        int size = std::min(hole_coordinates.latitude.size(), hole_coordinates.longitude.size());
+        if (size < 3){
+            QTNP_WARN(Meshing, "A hole needs at least three points, got " << size);
+            return -1;
+        }
+        ros::WallTime started = ros::WallTime::now();
+
+        std::vector<double> x(size), y(size);
+        geo.to_mesh(&hole_coordinates.latitude[0], &hole_coordinates.longitude[0], size, &x[0], &y[0]);
+
+        Hole hole;
+        hole.id = next_hole_id++;
+        double sum_x(0), sum_y(0);
+        for (int i=0; i<size; i++){
+            hole.outline.push_back(CDT::Point(x[i], y[i]));
+            sum_x += x[i];
+            sum_y += y[i];
+        }
+        if (hole.outline.front() != hole.outline.back()) hole.outline.push_back(hole.outline.front());
+
+        // without a seed the average of the points stands in, fine for convex holes
+        if ( (hole_coordinates.seed_latitude == 0) && (hole_coordinates.seed_longitude == 0) ){
+            hole.seed = CDT::Point(sum_x / size, sum_y / size);
+        } else {
+            double seed_x, seed_y;
+            geo.to_mesh(hole_coordinates.seed_latitude, hole_coordinates.seed_longitude, seed_x, seed_y);
+            hole.seed = CDT::Point(seed_x, seed_y);
+        }
+        holes.push_back(hole);
+
+        CDT::Vertex_handle previous = cdt.insert(hole.outline[0]);
+        for (int i=1; i<hole.outline.size(); i++){
+            CDT::Vertex_handle current = cdt.insert(hole.outline[i], previous->face());
+            cdt.insert_constraint(previous, current);
+            previous = current;
+        }
+
+        update_mesh_locally(hole_neighbourhood(hole), "Inserting hole");
+
+        QTNP_SUMMARY(Meshing, "Hole " << hole.id << " inserted, " << cells_renumbered << " cells renumbered in "
+                     << (ros::WallTime::now() - started).toSec() * 1000.0 << " ms");
+        save_snapshot("Hole insertion");
+        return hole.id;
+    }
+
+    bool Tnp_update::remove_hole(int hole_id){
+
+        boost::lock_guard<boost::mutex> lock(planning_mutex);
+        if (!mesh_ready){
+            QTNP_WARN(Meshing, "Hole removal requested without a mesh, perform the CDT first");
+            return false;
+        }
+        std::vector<Hole>::iterator it = holes.begin();
+        while ( (it != holes.end()) && (it->id != hole_id) ) it++;
+        if (it == holes.end()){
+            QTNP_WARN(Meshing, "There is no hole " << hole_id << " to remove");
+            return false;
+        }
+        ros::WallTime started = ros::WallTime::now();
+
+        Hole hole = *it;
+        holes.erase(it);
+
+        // the hole edges are split into several constrained edges by now, followed from point to point
+        std::vector<Vertex_pair> hole_edges;
+        for (int k=1; k<hole.outline.size(); k++){
+            if (hole.outline[k-1] == hole.outline[k]) continue;
+            if (!outline_edge_pieces(cdt, hole.outline[k-1], hole.outline[k], hole_edges)){
+                QTNP_WARN(Meshing, "Edge " << k << " of hole " << hole_id << " is no longer in the mesh, it stays constrained in part");
+            }
+        }
+        for (int i=0; i<hole_edges.size(); i++){
+            CDT::Face_handle face;
+            int index;
+            if (cdt.is_edge(hole_edges[i].first, hole_edges[i].second, face, index)) cdt.remove_constrained_edge(face, index);
+        }
+
+        update_mesh_locally(hole_neighbourhood(hole), "Removing hole");
+
+        QTNP_SUMMARY(Meshing, "Hole " << hole_id << " removed, " << cells_renumbered << " cells renumbered in "
+                     << (ros::WallTime::now() - started).toSec() * 1000.0 << " ms");
+        save_snapshot("Hole removal");
+        return true;
+    }
+
+    // refine and smooth inside the box only, then renumber what changed. A cancel in between
+    // leaves the cells out of step with the mesh, so the mesh has to be made again
+    void Tnp_update::update_mesh_locally(const Mesh_box &box, const char *stage){
+
+        std::list<CDT::Point> seeds = hole_seeds();
+        Local_criteria criteria(mesh_angle_criterion, mesh_edge_criterion, box.min_x, box.min_y, box.max_x, box.max_y,
+                                sizing_field.empty() ? NULL : &sizing_field);
+
+        try {
+            Local_mesher mesher(cdt, criteria);
+            mesher.set_seeds(seeds.begin(), seeds.end());
+            mesher.init();
+            refine_with_checkpoints(mesher, stage);
+
+            smooth_locally(box, local_smoothing_iterations);
+
+            // smoothing may leave a bad face or two, this pass also marks the domain of the moved faces
+            Local_mesher final_mesher(cdt, criteria);
+            final_mesher.set_seeds(seeds.begin(), seeds.end());
+            final_mesher.init();
+            refine_with_checkpoints(final_mesher, stage);
+        } catch (const Planning_cancelled &e) {
+            mesh_ready = partition_ready = false;
+            rviz_objects_ref.set_polygon_ready(false);
+            throw;
+        }
+
+        std::vector<CDT::Face_handle> changed = renumber_changed_cells();
+        cells_renumbered = changed.size();
+        cells.update_coordinates(geo);
+        cells.update_ground(terrain);
+        // the new cells and the ids left vacant haven't been flown yet
+        std::vector<int> forgotten;
+        for (int i=0; i<changed.size(); i++) forgotten.push_back(changed[i]->info().id);
+        for (int id=0; id<cells.size(); id++){
+            if (cells.is_vacant(id)) forgotten.push_back(id);
+        }
+        tracker.forget_cells(forgotten, cells.size());
+        if (partition_ready){
+            compute_cell_weights(partitioned_weight);
+            assign_changed_cells(changed);
+            coverage_cost_attribution();
+        }
+        rebuild_center_points();
+        rviz_objects_ref.clear_triangulation_mesh();
+        mesh_coloring();
+    }
+
+    // a few Lloyd like passes over the free vertices in the box: each one moves to the area
+    // weighted centroid of its incident faces (moved by removing and inserting it again)
+    void Tnp_update::smooth_locally(const Mesh_box &box, int iterations){
+
+        std::list<CDT::Point> seeds = hole_seeds();
+
+        for (int iteration=0; iteration<iterations; iteration++){
+
+            planning_control().checkpoint("Smoothing", iteration, iterations);
+            std::vector<std::pair<CDT::Vertex_handle, CDT::Point> > moves;
+
+            for (CDT::Finite_vertices_iterator vertex = cdt.finite_vertices_begin(); vertex != cdt.finite_vertices_end(); ++vertex){
+
+                if (!box.contains(vertex->point()) || cdt.are_there_incident_constraints(vertex)) continue;
+
+                double weight(0), sum_x(0), sum_y(0);
+                bool interior(true);
+                CDT::Face_circulator face = cdt.incident_faces(vertex), done(face);
+                do {
+                    if (cdt.is_infinite(face) || !face->is_in_domain()){
+                        interior = false;
+                        break;
+                    }
+                    CDT::Triangle triangle = cdt.triangle(face);
+                    const CDT::Point &a = triangle[0];
+                    const CDT::Point &b = triangle[1];
+                    const CDT::Point &c = triangle[2];
+                    double area = std::fabs((b.x() - a.x()) * (c.y() - a.y()) - (c.x() - a.x()) * (b.y() - a.y())) / 2;
+                    sum_x += area * (a.x() + b.x() + c.x()) / 3;
+                    sum_y += area * (a.y() + b.y() + c.y()) / 3;
+                    weight += area;
+                } while (++face != done);
+
+                if (interior && weight > 0) moves.push_back(std::make_pair(CDT::Vertex_handle(vertex), CDT::Point(sum_x / weight, sum_y / weight)));
+            }
+
+            for (int i=0; i<moves.size(); i++){
+                // the face across from the vertex survives its removal, a good place to start the search
+                CDT::Face_handle incident = moves[i].first->face();
+                CDT::Face_handle hint = incident->neighbor(incident->index(moves[i].first));
+                cdt.remove(moves[i].first);
+                cdt.insert(moves[i].second, hint);
+            }
+
+            // the faces made by the moves are not marked yet
+            Local_mesher marker(cdt);
+            marker.set_seeds(seeds.begin(), seeds.end(), false, true);
+        }
+    }
+
+    // keeps the id of every in-domain face that is still the same triangle, the ids of the others
+    // are freed and given to the new faces. Returns the faces numbered again
+    std::vector<CDT::Face_handle> Tnp_update::renumber_changed_cells(){
+
+        std::vector<bool> held(cells.size(), false);
+        std::vector<CDT::Face_handle> changed;
+
+        for(CDT::Finite_faces_iterator faces_iterator = cdt.finite_faces_begin();
+            faces_iterator != cdt.finite_faces_end(); ++faces_iterator){
+
+            // only a face that just left the domain loses its agent, to what the partition gives
+            // the faces outside; the others outside keep theirs
+            if (!faces_iterator->is_in_domain()){
+                if (faces_iterator->info().id >= 0) faces_iterator->info().agent_id = partition_ready ? -1 : 0;
+                faces_iterator->info().id = -1;
+                continue;
+            }
+            int id = faces_iterator->info().id;
+            if (cells.holds(id, faces_iterator, cdt.triangle(faces_iterator)) && !held[id]){
+                held[id] = true;
+            } else {
+                changed.push_back(faces_iterator);
+            }
+        }
+
+        for (int id=0; id<held.size(); id++){
+            if (!held[id]) cells.vacate(id);
+        }
+        for (int i=0; i<changed.size(); i++){
+            changed[i]->info().initialize(cells.place(changed[i], cdt.triangle(changed[i])));
+        }
+        return changed;
+    }
+
+    // new cells join the agent of a numbered neighbour, growing inwards from the untouched cells
+    void Tnp_update::assign_changed_cells(const std::vector<CDT::Face_handle> &changed){
+
+        std::vector<CDT::Face_handle> pending(changed);
+        bool assigned(true);
+
+        while (!pending.empty() && assigned){
+            assigned = false;
+            std::vector<CDT::Face_handle> still_pending;
+            for (int i=0; i<pending.size(); i++){
+                CDT::Face_handle face = pending[i];
+                int from(-1);
+                for (int j=0; j<3; j++){
+                    CDT::Face_handle neighbor = face->neighbor(j);
+                    if (neighbor->is_in_domain() && neighbor->info().has_number() && (neighbor->info().agent_id > 0) &&
+                        ( (from < 0) || (neighbor->info().depth < face->neighbor(from)->info().depth) )){
+                        from = j;
+                    }
+                }
+                if (from < 0){
+                    still_pending.push_back(face);
+                    continue;
+                }
+                face->info().agent_id = face->neighbor(from)->info().agent_id;
+                face->info().depth = face->neighbor(from)->info().depth + 1;
+                face->info().jumps_agent_id = face->neighbor(from)->info().jumps_agent_id;
+                face->info().numbered = true;
+                assigned = true;
+            }
+            pending.swap(still_pending);
+        }
+
+        // path planning starts from the depth 1 cell of every agent
+        std::vector<bool> has_cells, has_start;
+        for (int id=0; id<cells.size(); id++){
+            if (cells.is_vacant(id)) continue;
+            int agent = cells.face(id)->info().agent_id;
+            if (agent <= 0) continue;
+            if (agent >= has_cells.size()){
+                has_cells.resize(agent + 1, false);
+                has_start.resize(agent + 1, false);
+            }
+            has_cells[agent] = true;
+            if (cells.face(id)->info().depth == 1) has_start[agent] = true;
+        }
+        for (int agent=1; agent<has_cells.size(); agent++){
+            if (has_cells[agent] && !has_start[agent]){
+                QTNP_WARN(Partitioning, "The start cell of agent " << agent << " is gone with the mesh change, partition again");
+            }
+        }
+    }
+
+    void Tnp_update::rebuild_center_points(){
+
+        rviz_objects_ref.clear_center_points();
+        rviz_objects_ref.clear_center_points_with_cell_id();
+        for (int id=0; id<cells.size(); id++){
+            if (cells.is_vacant(id)) continue;
+            rviz_objects_ref.push_center_point(cells.center_point(id));
+            rviz_objects_ref.push_center_point_with_cell_id(id, cells.center_point(id));
+        }
     }
 
     // FIXME: DEPRECATED custom callback function of the ROS listener for path planning
     void Tnp_update::path_planning_callback(const InitialCoordinates::ConstPtr &msg){
 
-        std::cout << std::setprecision(7);
         int uav_id = (int) msg->uav_id;
         double longitude = (double) msg->longitude;
         double latitude = (double) msg->latitude;
         // coverage or target
         // if target, cell of target
 
-        ROS_INFO("I heard UAV id: [%i]", uav_id);
-        ROS_INFO("I heard the longitude: [%3.7f]", longitude);
-        ROS_INFO("I heard the latitude: [%3.7f]", latitude);
+        QTNP_INFO(General, "I heard UAV id: [" << uav_id << "], longitude: [" << std::fixed << std::setprecision(7)
+                  << longitude << "], latitude: [" << latitude << "]");
 
         // TODO: in that way you make use of the referenced visualization objects in main ROS node
         // rviz_objects_ref.set_polygon_ready(false);
@@ -668,13 +1341,69 @@ namespace qtnp {
         }
     }
 
-    void Tnp_update::partition(std::vector<std::pair< std::pair<double,double> , int > >  uas_coords_with_percentage){
+    bool Tnp_update::parse_partitioner(const std::string &name, Partitioner &partitioner){
+
+        if (name == "hop_growth") partitioner = Hop_growth;
+        else if (name == "multilevel") partitioner = Multilevel;
+        else if (name == "voronoi") partitioner = Geodesic_voronoi;
+        else return false;
+        return true;
+    }
+
+    bool Tnp_update::parse_partition_weight(const std::string &name, Partition_weight &weight){
+
+        if (name == "cells") weight = Cell_count;
+        else if (name == "area") weight = Cell_area;
+        else if (name == "flight_time") weight = Flight_time;
+        else return false;
+        return true;
+    }
+
+    // Cell_area in square metres. Flight_time in seconds: the coverage path goes from cell centre
+    // to cell centre, 0.877 sqrt(area) apart on equilateral triangles, and turns at every waypoint
+    void Tnp_update::compute_cell_weights(Partition_weight weight){
+
+        double speed = cruise_speed.load();
+        double turn_time = waypoint_turn_time.load();
+        if (speed <= 0) speed = constants::cruise_speed_default;
+
+        cell_weights.assign(cells.size(), 0.0);
+        for (int id=0; id<cells.size(); id++){
+            if (cells.is_vacant(id)) continue;
+            double side = geo.metres(std::sqrt(cells.area(id)));
+            switch (weight){
+              case Cell_area:   cell_weights[id] = side * side; break;
+              case Flight_time: cell_weights[id] = 0.877 * side / speed + turn_time; break;
+              default:          cell_weights[id] = 1.0;
+            }
+        }
+    }
+
+    void Tnp_update::partition(std::vector<std::pair< std::pair<double,double> , int > >  uas_coords_with_percentage,
+                               Partitioner partitioner, Partition_weight weight, const std::vector<double> &cell_sizes){
+
+        boost::lock_guard<boost::mutex> lock(planning_mutex);
+        if (!mesh_ready){
+            QTNP_WARN(Partitioning, "Partitioning requested without a mesh, perform the CDT first");
+            return;
+        }
+        partition_ready = false;
 
         rviz_objects_ref.clear_triangulation_mesh();
         int uas_count = uas_coords_with_percentage.size();
         int total_cdt_cells = rviz_objects_ref.count_cells();
 
+        if (regions_remeshed && (weight == Cell_count)){
+            QTNP_WARN(Partitioning, "The mesh was remeshed at the cell sizes of the agents, balancing by cell area instead of cell count");
+            weight = Cell_area;
+        }
+        compute_cell_weights(weight);
+        partitioned_weight = weight;
+        double total_weight(0);
+        for (int id=0; id<cell_weights.size(); id++) total_weight += cell_weights[id];
+
         std::vector< std::pair<int,int> > id_cell_count_vector;
+        std::vector<double> weight_budget;
         std::vector<int> initial_positions_cell_ids;
 
         int jumps_ad = 1;
@@ -689,6 +1418,9 @@ namespace qtnp {
              // +1 for the agent id, -1 for calculating the initial cell
             id_cell_count_vector.push_back(std::pair<int,int>(i+1,cells_for_agent-1));
 
+            double start_weight = ((result_id >= 0) && (result_id < cell_weights.size())) ? cell_weights[result_id] : 0.0;
+            if (weight == Cell_count) weight_budget.push_back(cells_for_agent - 1);
+            else weight_budget.push_back(uas_coords_with_percentage[i].second * total_weight / 100.0 - start_weight);
         }
 
         for(CDT::Finite_faces_iterator faces_iterator = cdt.finite_faces_begin();
@@ -712,43 +1444,604 @@ namespace qtnp {
           }
         }
 
-        // hop cost/partitioning, passing autonomy percentage table
-        hop_cost_attribution(id_cell_count_vector);
+        if (partitioner != Hop_growth){
+            std::vector<int> autonomy_percentage;
+            for (int i=0; i<uas_count; i++) autonomy_percentage.push_back(uas_coords_with_percentage[i].second);
+            graph_partition(initial_positions_cell_ids, autonomy_percentage, partitioner);
+        } else {
+            // hop cost/partitioning, passing autonomy percentage table
+            hop_cost_attribution(id_cell_count_vector, weight_budget);
+        }
+
+        // the percentages are shares of the mesh as it is, then every region gets its cell size
+        bool remesh(false);
+        for (int i=0; i<cell_sizes.size(); i++) remesh = remesh || (cell_sizes[i] > 0);
+        if (remesh){
+            std::vector<std::pair<double, double> > uas_coords;
+            for (int i=0; i<uas_count; i++) uas_coords.push_back(uas_coords_with_percentage[i].first);
+            remesh_regions(uas_coords, cell_sizes);
+            // the shares were counted on the even coarse cells; repartitions and partitions
+            // from here on have regions of different cell sizes to balance
+            if (weight == Cell_count){
+                QTNP_WARN(Partitioning, "Regions remeshed, from now on the partition is balanced by cell area instead of cell count");
+                weight = Cell_area;
+                partitioned_weight = weight;
+            }
+            compute_cell_weights(weight);
+        }
         coverage_cost_attribution();
 
-        std::vector<int> cells_per_agent = count_agent_cells();
-        for (int i=0; i<cells_per_agent.size(); i++){
-            std::cout << "agent " << i << " has " << cells_per_agent[i] << " cells." << std::endl;
+        QTNP_SUMMARY(Partitioning, "Cells per agent (0: unassigned): " << logging::join(count_agent_cells()));
+        if (weight != Cell_count){
+            std::vector<int> agent_weight(uas_count + 1, 0);
+            std::vector<double> sums(uas_count + 1, 0.0);
+            for (int id=0; id<cells.size(); id++){
+                if (cells.is_vacant(id)) continue;
+                int agent = cells.face(id)->info().agent_id;
+                if ((agent >= 0) && (agent <= uas_count)) sums[agent] += cell_weights[id];
+            }
+            for (int agent=0; agent<=uas_count; agent++) agent_weight[agent] = (int) (sums[agent] + 0.5);
+            QTNP_SUMMARY(Partitioning, (weight == Cell_area ? "Square metres" : "Flight seconds")
+                         << " per agent (0: unassigned): " << logging::join(agent_weight));
         }
         mesh_coloring();
+        partition_ready = true;
+        save_snapshot("Partitioning");
     }
 
-    void Tnp_update::hop_cost_attribution(std::vector< std::pair<int,int> > id_cell_count){
-
-        // TODO: seperate hop cost from agent attribution. agent attribution is valid
-        // for all tasks and its operations don't have to be repeated or missing..
-        std::cout << "-----Beginning jump cost------" << std::endl;
+    // The regions of the partition become the outlines of meshes of their own, one per agent,
+    // refined in parallel at the cell size of the agent (the edge criterion of the mesh without
+    // one). A shared border is split beforehand at the finer of the two sizes, both meshers
+    // keep those points and the coarse side grades away from them. Their vertices then go into
+    // one triangulation with the region borders as constraints; where the meshers of two
+    // neighbours split a shared border further, and differently, it gets the points of both,
+    // so the faces on either side still meet edge to edge. Every new
+    // face takes the agent, and the domain flag, of the coarse face its centroid lies in
+    void Tnp_update::remesh_regions(const std::vector<std::pair<double, double> > &uas_coords,
+                                    const std::vector<double> &cell_sizes){
+
+        ros::WallTime started = ros::WallTime::now();
+        int agent_count = uas_coords.size();
+        int coarse_cells = cells.count();
+
+        // the border edges and a seed per connected piece of every region; agent 0 keeps what
+        // the partition left unassigned, at the edge criterion
+        std::vector<Region_mesh> regions(agent_count + 1);
+        std::vector<double> region_area(agent_count + 1, 0);
+        std::vector<bool> reached(cells.size(), false);
+        for (int id=0; id<cells.size(); id++){
+            if (cells.is_vacant(id)) continue;
+            CDT::Face_handle face = cells.face(id);
+            int agent = face->info().agent_id;
+            if ((agent < 0) || (agent > agent_count)) continue;
+            region_area[agent] += cells.area(id);
+            for (int j=0; j<3; j++){
+                CDT::Face_handle neighbor = face->neighbor(j);
+                if (neighbor->is_in_domain() && (neighbor->info().agent_id == agent)) continue;
+                regions[agent].border.push_back(border_edge(face->vertex(cdt.cw(j))->point(), face->vertex(cdt.ccw(j))->point()));
+            }
+            if (reached[id]) continue;
+            regions[agent].seeds.push_back(CDT::Point(cells.x(id), cells.y(id)));
+            std::deque<int> piece(1, id);
+            reached[id] = true;
+            while (!piece.empty()){
+                CDT::Face_handle current = cells.face(piece.front());
+                piece.pop_front();
+                for (int j=0; j<3; j++){
+                    CDT::Face_handle neighbor = current->neighbor(j);
+                    int neighbor_id = neighbor->info().id;
+                    if (!neighbor->is_in_domain() || (neighbor->info().agent_id != agent) || (neighbor_id < 0) ||
+                        (neighbor_id >= cells.size()) || reached[neighbor_id]) continue;
+                    reached[neighbor_id] = true;
+                    piece.push_back(neighbor_id);
+                }
+            }
+        }
 
-        bool neverInside = false;
-        int jumpsIterator = 1;
+        for (int agent=0; agent<=agent_count; agent++){
+            Region_mesh &region = regions[agent];
+            if (region.border.empty()) continue;
+            double metres = ((agent > 0) && (agent <= cell_sizes.size())) ? cell_sizes[agent - 1] : 0;
+            region.size_bound = (metres > 0) ? geo.mesh_length(metres) : mesh_edge_criterion;
+            // about 0.43 size^2 per triangle at the bound, the mesher makes them smaller still
+            if ((region.size_bound > 0) && (region_area[agent] / (0.43 * region.size_bound * region.size_bound) > constants::region_cells_max)){
+                region.size_bound = std::sqrt(region_area[agent] / (0.43 * constants::region_cells_max));
+                QTNP_WARN(Meshing, "Agent " << agent << ": the cell size is raised to " << geo.metres(region.size_bound)
+                          << " m, a finer one would make more than " << constants::region_cells_max << " cells");
+            }
+        }
+        split_borders(regions);
 
-        // TODO: refactor: hop cost in seprate function, referencing id_cell_count vector. replenishing algo should work only
-        // with one list, with positive and negative values not with two lists including agent_id = 0s.
-        do {
-          jumpsIterator++; // including non domain triangles
+        std::vector<Thread_pool::job_type> jobs;
+        for (int agent=0; agent<=agent_count; agent++){
+            if (regions[agent].border.empty()) continue;
+            jobs.push_back(boost::bind(&mesh_region, boost::ref(regions[agent]), mesh_angle_criterion,
+                                       sizing_field.empty() ? NULL : &sizing_field, boost::cref(planning_control())));
+        }
+        planning_control().checkpoint("Remeshing regions", 0, jobs.size());
+        if (pool_ptr) pool_ptr->run_all(jobs);
+        else for (int i=0; i<jobs.size(); i++) jobs[i]();
+        planning_control().checkpoint("Remeshing regions", jobs.size(), jobs.size());
+
+        // every border edge once, with the splits of both its sides in order along it
+        std::vector<CDT::Point> points;
+        std::map<Border_edge, std::vector<CDT::Point> > splits;
+        for (int agent=0; agent<=agent_count; agent++){
+            Region_mesh &region = regions[agent];
+            points.insert(points.end(), region.inside.begin(), region.inside.end());
+            for (int i=0; i<region.border.size(); i++){
+                std::vector<CDT::Point> &on_edge = splits[region.border[i]];
+                std::map<Border_edge, std::vector<CDT::Point> >::const_iterator found = region.splits.find(region.border[i]);
+                if (found != region.splits.end()) on_edge.insert(on_edge.end(), found->second.begin(), found->second.end());
+            }
+        }
+        for (std::map<Border_edge, std::vector<CDT::Point> >::iterator it = splits.begin(); it != splits.end(); ++it){
+            std::vector<CDT::Point> &on_edge = it->second;
+            std::sort(on_edge.begin(), on_edge.end(), Closer_to(it->first.first));
+            on_edge.erase(std::unique(on_edge.begin(), on_edge.end()), on_edge.end());
+            points.push_back(it->first.first);
+            points.push_back(it->first.second);
+            points.insert(points.end(), on_edge.begin(), on_edge.end());
+        }
 
-          neverInside = true;
+        planning_control().checkpoint("Merging regions", 0, 0);
+        CDT fine;
+        fine.insert(points.begin(), points.end());
+        for (std::map<Border_edge, std::vector<CDT::Point> >::iterator it = splits.begin(); it != splits.end(); ++it){
+            CDT::Vertex_handle previous = fine.insert(it->first.first);
+            for (int k=0; k<=it->second.size(); k++){
+                const CDT::Point &point = (k < it->second.size()) ? it->second[k] : it->first.second;
+                CDT::Vertex_handle next = fine.insert(point, previous->face());
+                fine.insert_constraint(previous, next);
+                previous = next;
+            }
+        }
 
-          for(CDT::Finite_faces_iterator faces_iterator = cdt.finite_faces_begin();
-              faces_iterator != cdt.finite_faces_end(); ++faces_iterator){
+        // the coarse mesh stays for the lookups below, the fine one takes its place
+        CDT coarse;
+        coarse.swap(cdt);
+        cdt.swap(fine);
+        CDT::Face_handle hint;
+        for (CDT::Finite_faces_iterator face = cdt.finite_faces_begin(); face != cdt.finite_faces_end(); ++face){
+            const CDT::Point &a = face->vertex(0)->point();
+            const CDT::Point &b = face->vertex(1)->point();
+            const CDT::Point &c = face->vertex(2)->point();
+            CDT::Face_handle located = coarse.locate(CDT::Point((a.x() + b.x() + c.x()) / 3, (a.y() + b.y() + c.y()) / 3), hint);
+            bool inside = !coarse.is_infinite(located) && located->is_in_domain();
+            face->set_in_domain(inside);
+            face->info().agent_id = inside ? (int) located->info().agent_id : -1;
+            if (!coarse.is_infinite(located)) hint = located;
+        }
 
-            // too many comparisons. we need to refactor the algorithm
-            if ((faces_iterator->is_in_domain()) && (faces_iterator->info().has_number())
-                && !(faces_iterator->info().is_visited()) && !(faces_iterator->info().depth == jumpsIterator)) {
+        cells.clear();
+        rviz_objects_ref.clear_center_points();
+        rviz_objects_ref.clear_center_points_with_cell_id();
+        number_cells();
+        regions_remeshed = true;
 
-              int that_agent = faces_iterator->info().agent_id;
-              // check if that agent has fulfilled his need for cells according to its autonomy percentage
-              std::vector<std::pair <int,int> >::iterator it =
+        // every agent starts from its cell nearest to the uas, as on the coarse mesh
+        int jumps_ad = 1;
+        for (int agent=1; agent<=agent_count; agent++){
+            int start = coordinates_to_cdt_cell_id(uas_coords[agent - 1].first, uas_coords[agent - 1].second);
+            if ((start >= 0) && (start < cells.size()) && (cells.face(start)->info().agent_id != agent)){
+                double x = cells.x(start), y = cells.y(start), best = std::numeric_limits<double>::infinity();
+                std::vector<CDT::Face_handle> faces = agent_cells(agent);
+                start = -1;
+                for (int i=0; i<faces.size(); i++){
+                    int id = faces[i]->info().id;
+                    double d = (cells.x(id) - x) * (cells.x(id) - x) + (cells.y(id) - y) * (cells.y(id) - y);
+                    if (d < best){
+                        best = d;
+                        start = id;
+                    }
+                }
+            }
+            if ((start < 0) || (start >= cells.size())) continue;
+            CDT::Face_handle face = cells.face(start);
+            face->info().depth = 1;
+            face->info().numbered = true;
+            for (int j=0; j<3; j++){
+                face->neighbor(j)->info().jumps_agent_id = jumps_ad;
+                jumps_ad++;
+            }
+        }
+        for (int agent=1; agent<=agent_count; agent++){
+            planning_control().checkpoint("Hop cost", agent, agent_count);
+            hop_cost_for_agent(agent);
+        }
+
+        rviz_objects_ref.set_polygon_ready(true);
+        QTNP_SUMMARY(Meshing, "Regions remeshed from " << coarse_cells << " to " << cells.count() << " cells ("
+                     << jobs.size() << " meshers) in " << (ros::WallTime::now() - started).toSec() * 1000.0 << " ms");
+    }
+
+    // the regions come from the cell graph (a vertex per cell, an edge per shared triangle edge),
+    // the start cells pinned to their agents; then the hop depths as the growth would give them.
+    // The Voronoi edges are the centroid distances, 1000 for the mean one
+    void Tnp_update::graph_partition(const std::vector<int> &start_ids, const std::vector<int> &autonomy_percentage,
+                                     Partitioner partitioner){
+
+        ros::WallTime started = ros::WallTime::now();
+
+        std::vector<int> vertex_of(cells.size(), -1);
+        std::vector<int> cell_of;
+        for (int id=0; id<cells.size(); id++){
+            if (cells.is_vacant(id)) continue;
+            vertex_of[id] = cell_of.size();
+            cell_of.push_back(id);
+        }
+
+        double mean_weight(0);
+        for (int i=0; i<cell_of.size(); i++) mean_weight += cell_weights[cell_of[i]];
+        mean_weight = (mean_weight > 0) ? mean_weight / cell_of.size() : 1.0;
+
+        Partition_graph graph;
+        std::vector<double> lengths;
+        double mean_length(0);
+        graph.xadj.push_back(0);
+        for (int i=0; i<cell_of.size(); i++){
+            CDT::Face_handle face = cells.face(cell_of[i]);
+            for (int j=0; j<3; j++){
+                CDT::Face_handle neighbor = face->neighbor(j);
+                if (!neighbor->is_in_domain() || (neighbor->info().id < 0)) continue;
+                int neighbor_id = neighbor->info().id;
+                graph.adjncy.push_back(vertex_of[neighbor_id]);
+                if (partitioner == Geodesic_voronoi){
+                    double dx = cells.x(neighbor_id) - cells.x(cell_of[i]);
+                    double dy = cells.y(neighbor_id) - cells.y(cell_of[i]);
+                    lengths.push_back(std::sqrt(dx * dx + dy * dy));
+                    mean_length += lengths.back();
+                }
+            }
+            graph.xadj.push_back(graph.adjncy.size());
+            // integer vertex weights, 100 for a cell of the mean weight
+            graph.vwgt.push_back(std::max(1, (int) (100.0 * cell_weights[cell_of[i]] / mean_weight + 0.5)));
+        }
+        if (partitioner == Geodesic_voronoi){
+            mean_length = (mean_length > 0) ? mean_length / lengths.size() : 1.0;
+            for (int e=0; e<lengths.size(); e++){
+                graph.adjwgt.push_back(std::max(1, (int) (1000.0 * lengths[e] / mean_length + 0.5)));
+            }
+        } else {
+            graph.adjwgt.assign(graph.adjncy.size(), 1);
+        }
+
+        std::vector<double> targets(autonomy_percentage.begin(), autonomy_percentage.end());
+        std::vector<int> pinned;
+        for (int i=0; i<start_ids.size(); i++){
+            pinned.push_back(((start_ids[i] >= 0) && (start_ids[i] < cells.size())) ? vertex_of[start_ids[i]] : -1);
+        }
+        // agents starting in one cell: the later ones start from the nearest cell nobody has
+        std::vector<bool> taken(cell_of.size(), false);
+        for (int i=0; i<pinned.size(); i++){
+            if (pinned[i] < 0) continue;
+            if (taken[pinned[i]]){
+                std::vector<bool> reached(cell_of.size(), false);
+                std::deque<int> queue(1, pinned[i]);
+                reached[pinned[i]] = true;
+                int free(-1);
+                while (!queue.empty() && (free < 0)){
+                    int v = queue.front();
+                    queue.pop_front();
+                    for (int e = graph.xadj[v]; (e < graph.xadj[v + 1]) && (free < 0); e++){
+                        int u = graph.adjncy[e];
+                        if (reached[u]) continue;
+                        reached[u] = true;
+                        if (!taken[u]) free = u;
+                        queue.push_back(u);
+                    }
+                }
+                QTNP_INFO(Partitioning, "Agent " << i + 1 << " starts in the cell of another agent, "
+                          << (free < 0 ? "there is no free cell near it" : "it starts from the nearest free one"));
+                pinned[i] = free;
+            }
+            if (pinned[i] >= 0) taken[pinned[i]] = true;
+        }
+
+        std::vector<int> part;
+        Multilevel_partitioner multilevel(planning_control());
+        if (partitioner == Geodesic_voronoi){
+            Voronoi_partitioner voronoi(planning_control(), pool_ptr);
+            part = voronoi.partition(graph, targets, pinned);
+            QTNP_INFO(Partitioning, "Voronoi weights tuned in " << voronoi.rounds() << " rounds, "
+                      << voronoi.imbalance() * 100.0 << "% off the targets at most");
+            // a cluster of start cells leaves the weights little to tune, what is still off is
+            // evened out along the borders
+            if (voronoi.imbalance() > voronoi_balance_tolerance){
+                planning_control().checkpoint("Balancing", 0, 0);
+                multilevel.balance(graph, targets, pinned, part, voronoi_balance_passes);
+                QTNP_INFO(Partitioning, "Balanced along the borders, " << multilevel.imbalance() * 100.0 << "% off the targets at most");
+            }
+            // a part wrapped around a boxed in one can't give it cells without splitting, the
+            // multilevel parts start over from the start cells instead
+            if ((voronoi.imbalance() > voronoi_balance_tolerance) && (multilevel.imbalance() > voronoi_fallback_tolerance)){
+                planning_control().checkpoint("Partitioning", 0, 0);
+                double balanced = multilevel.imbalance();
+                std::vector<int> fresh = multilevel.partition(graph, targets, pinned);
+                QTNP_INFO(Partitioning, "Multilevel parts " << multilevel.imbalance() * 100.0 << "% off the targets at most"
+                          << (multilevel.imbalance() < balanced ? ", taken" : ", the balanced Voronoi parts kept"));
+                if (multilevel.imbalance() < balanced) part.swap(fresh);
+            }
+        } else {
+            part = multilevel.partition(graph, targets, pinned);
+            QTNP_INFO(Partitioning, "Multilevel parts " << multilevel.imbalance() * 100.0 << "% off the targets at most");
+        }
+
+        for (int i=0; i<cell_of.size(); i++){
+            FaceInfo2 &info = cells.face(cell_of[i])->info();
+            info.agent_id = part[i] + 1;
+            info.visited = false;
+            info.depth = 0;
+            info.numbered = false;
+        }
+        for (int i=0; i<pinned.size(); i++){
+            if (pinned[i] < 0) continue;
+            FaceInfo2 &info = cells.face(cell_of[pinned[i]])->info();
+            if (info.agent_id != i + 1) continue;
+            info.depth = 1;
+            info.numbered = true;
+        }
+        for (int agent=1; agent<=start_ids.size(); agent++){
+            planning_control().checkpoint("Hop cost", agent, start_ids.size());
+            hop_cost_for_agent(agent);
+        }
+
+        QTNP_SUMMARY(Partitioning, (partitioner == Geodesic_voronoi ? "Voronoi" : "Multilevel") << " partitioning of "
+                     << cell_of.size() << " cells in " << (ros::WallTime::now() - started).toSec() * 1000.0 << " ms");
+    }
+
+    void Tnp_update::repartition(std::vector<int> autonomy_percentage){
+
+        boost::lock_guard<boost::mutex> lock(planning_mutex);
+        if (!partition_ready){
+            QTNP_WARN(Partitioning, "Repartition requested without a partition, perform the partitioning first");
+            return;
+        }
+        ros::WallTime started = ros::WallTime::now();
+
+        // the percentages are shares of what the partition balanced, the cell count, area or
+        // flight time; after a hole change the weights follow the new cells
+        if (cell_weights.size() != cells.size()) compute_cell_weights(partitioned_weight);
+
+        // current weight per agent; agents past the given percentages keep what they have
+        std::vector<double> owned(autonomy_percentage.size() + 1, 0.0);
+        std::vector<int> before(cells.size(), -1);
+        double total_weight(0);
+        for (int id=0; id<cells.size(); id++){
+            if (cells.is_vacant(id)) continue;
+            int agent = cells.face(id)->info().agent_id;
+            before[id] = agent;
+            total_weight += cell_weights[id];
+            if (agent < 0) continue;
+            if (agent >= owned.size()) owned.resize(agent + 1, 0.0);
+            owned[agent] += cell_weights[id];
+        }
+
+        int agents = owned.size() - 1;
+        std::vector<double> deficit(agents + 1, 0.0);
+        for (int agent=1; agent<=agents; agent++){
+            double target = (agent <= autonomy_percentage.size()) ? autonomy_percentage[agent-1] * total_weight / 100.0 : owned[agent];
+            deficit[agent] = target - owned[agent];
+        }
+
+        // agents over their share give up cells from their borders, a dropped agent all of them.
+        // The others grow into the freed cells from their borders, whatever is left over goes
+        // to any neighbour so that no cell stays without an agent
+        std::vector<bool> affected(agents + 1, false);
+        try {
+            for (int agent=1; agent<=agents; agent++){
+                if (deficit[agent] >= 0) continue;
+                planning_control().checkpoint("Releasing cells", agent, agents);
+                release_cells(agent, -deficit[agent], deficit);
+                deficit[agent] = 0;
+            }
+            grow_into_free_cells(deficit, true, affected);
+            grow_into_free_cells(deficit, false, affected);
+        } catch (const Planning_cancelled &e) {
+            // some cells may be without an agent by now
+            partition_ready = false;
+            throw;
+        }
+
+        cells_moved = 0;
+        int unassigned(0);
+        for (int id=0; id<cells.size(); id++){
+            if (cells.is_vacant(id)) continue;
+            int agent = cells.face(id)->info().agent_id;
+            if (agent == 0) unassigned++;
+            if (agent == before[id]) continue;
+            cells_moved++;
+            if ((before[id] > 0) && (before[id] <= agents)) affected[before[id]] = true;
+            if ((agent > 0) && (agent <= agents)) affected[agent] = true;
+        }
+
+        try {
+            for (int agent=1; agent<=agents; agent++){
+                if (affected[agent]) hop_cost_for_agent(agent);
+            }
+            coverage_cost_attribution(affected);
+        } catch (const Planning_cancelled &e) {
+            partition_ready = false;
+            throw;
+        }
+
+        std::vector<int> touched;
+        for (int agent=1; agent<=agents; agent++){
+            if (affected[agent]) touched.push_back(agent);
+        }
+        if (unassigned > 0) QTNP_WARN(Partitioning, unassigned << " cells could not be reached by any agent");
+        QTNP_SUMMARY(Partitioning, "Repartition moved " << cells_moved << " cells between agents [" << logging::join(touched)
+                     << "] in " << (ros::WallTime::now() - started).toSec() * 1000.0 << " ms");
+
+        rviz_objects_ref.clear_triangulation_mesh();
+        mesh_coloring();
+        save_snapshot("Repartition");
+    }
+
+    std::vector<CDT::Face_handle> Tnp_update::agent_cells(int agent){
+
+        std::vector<CDT::Face_handle> faces;
+        for (int id=0; id<cells.size(); id++){
+            if (!cells.is_vacant(id) && (cells.face(id)->info().agent_id == agent)) faces.push_back(cells.face(id));
+        }
+        return faces;
+    }
+
+    // peels the agent's region layer by layer from its borders, the cells next to agents that
+    // need cells and far from the start cell first, until amount of cell weight is given up. With
+    // amount covering all its weight the start cell goes as well
+    void Tnp_update::release_cells(int agent, double amount, const std::vector<double> &deficit){
+
+        std::vector<CDT::Face_handle> faces = agent_cells(agent);
+        double owned(0);
+        for (int i=0; i<faces.size(); i++) owned += cell_weights[faces[i]->info().id];
+        bool release_all = (amount >= owned);
+
+        while (amount > 0){
+
+            std::vector<Release_entry> border;
+            std::vector<CDT::Face_handle> fallback;
+            for (int i=0; i<faces.size(); i++){
+                CDT::Face_handle face = faces[i];
+                if (face->info().agent_id != agent) continue;
+                if ((face->info().depth == 1) && !release_all) continue;
+                fallback.push_back(face);
+                int needy(0);
+                bool on_border(false);
+                for (int j=0; j<3; j++){
+                    CDT::Face_handle neighbor = face->neighbor(j);
+                    if (!neighbor->is_in_domain() || (neighbor->info().agent_id == agent)) continue;
+                    on_border = true;
+                    int other = neighbor->info().agent_id;
+                    if ((other > 0) && (other < deficit.size()) && (deficit[other] > 0)) needy = 1;
+                }
+                if (on_border) border.push_back(std::make_pair(std::make_pair(needy, (int) face->info().depth), face));
+            }
+
+            // an agent alone in its part of the domain has no border, its farthest cells go
+            if (border.empty()){
+                for (int i=0; i<fallback.size(); i++){
+                    border.push_back(std::make_pair(std::make_pair(0, (int) fallback[i]->info().depth), fallback[i]));
+                }
+            }
+            if (border.empty()) break;
+
+            std::stable_sort(border.begin(), border.end(), release_order);
+            for (int i=0; (i<border.size()) && (amount > 0); i++){
+                border[i].second->info().agent_id = 0;
+                border[i].second->info().depth = 0;
+                border[i].second->info().numbered = false;
+                amount -= cell_weights[border[i].second->info().id];
+            }
+        }
+    }
+
+    // one ring per round for every agent in turn, so neighbours share a freed region evenly.
+    // limited: an agent stops at its deficit, in cell weight. Returns the cells taken
+    int Tnp_update::grow_into_free_cells(std::vector<double> &deficit, bool limited, std::vector<bool> &affected){
+
+        int agents = deficit.size() - 1;
+        std::vector<std::vector<CDT::Face_handle> > frontier(agents + 1);
+        for (int id=0; id<cells.size(); id++){
+            if (cells.is_vacant(id)) continue;
+            int agent = cells.face(id)->info().agent_id;
+            if ((agent > 0) && (agent <= agents)) frontier[agent].push_back(cells.face(id));
+        }
+
+        int taken(0);
+        bool grown(true);
+        while (grown){
+            grown = false;
+            for (int agent=1; agent<=agents; agent++){
+                if (limited && (deficit[agent] <= 0)) continue;
+                std::vector<CDT::Face_handle> next;
+                for (int i=0; i<frontier[agent].size(); i++){
+                    CDT::Face_handle face = frontier[agent][i];
+                    for (int j=0; j<3; j++){
+                        if (limited && (deficit[agent] <= 0)) break;
+                        CDT::Face_handle neighbor = face->neighbor(j);
+                        if (!neighbor->is_in_domain() || (neighbor->info().agent_id != 0)) continue;
+                        neighbor->info().agent_id = agent;
+                        deficit[agent] -= cell_weights[neighbor->info().id];
+                        affected[agent] = true;
+                        next.push_back(neighbor);
+                        taken++;
+                        grown = true;
+                    }
+                }
+                frontier[agent].swap(next);
+            }
+        }
+        return taken;
+    }
+
+    // hop depth inside the agent's own cells, from its start cell
+    void Tnp_update::hop_cost_for_agent(int agent){
+
+        std::vector<CDT::Face_handle> faces = agent_cells(agent);
+        if (faces.empty()) return;
+
+        CDT::Face_handle start;
+        for (int i=0; i<faces.size(); i++){
+            if (faces[i]->info().depth == 1){
+                start = faces[i];
+            } else {
+                faces[i]->info().depth = 0;
+                faces[i]->info().numbered = false;
+            }
+        }
+        if (start == CDT::Face_handle()){
+            QTNP_WARN(Partitioning, "Agent " << agent << " has no start cell, partition again");
+            return;
+        }
+
+        std::deque<CDT::Face_handle> queue;
+        start->info().numbered = true;
+        queue.push_back(start);
+        while (!queue.empty()){
+            CDT::Face_handle face = queue.front();
+            queue.pop_front();
+            for (int j=0; j<3; j++){
+                CDT::Face_handle neighbor = face->neighbor(j);
+                if (!neighbor->is_in_domain() || (neighbor->info().agent_id != agent) || neighbor->info().has_number()) continue;
+                // the neighbours of the start cell keep the jumps id the partition gave them
+                if (face->info().depth != 1) neighbor->info().jumps_agent_id = face->info().jumps_agent_id;
+                neighbor->info().depth = face->info().depth + 1;
+                neighbor->info().numbered = true;
+                queue.push_back(neighbor);
+            }
+        }
+    }
+
+    void Tnp_update::hop_cost_attribution(std::vector< std::pair<int,int> > id_cell_count, std::vector<double> weight_budget){
+
+        // TODO: seperate hop cost from agent attribution. agent attribution is valid
+        // for all tasks and its operations don't have to be repeated or missing..
+        QTNP_DEBUG(Partitioning, "-----Beginning jump cost------");
+
+        bool neverInside = false;
+        int jumpsIterator = 1;
+        int assigned_cells = id_cell_count.size();
+        int total_domain_cells = rviz_objects_ref.count_cells();
+
+        // TODO: refactor: hop cost in seprate function, referencing id_cell_count vector. replenishing algo should work only
+        // with one list, with positive and negative values not with two lists including agent_id = 0s.
+        do {
+          planning_control().checkpoint("Partitioning", assigned_cells, total_domain_cells);
+          jumpsIterator++; // including non domain triangles
+
+          neverInside = true;
+
+          for(CDT::Finite_faces_iterator faces_iterator = cdt.finite_faces_begin();
+              faces_iterator != cdt.finite_faces_end(); ++faces_iterator){
+
+            // too many comparisons. we need to refactor the algorithm
+            if ((faces_iterator->is_in_domain()) && (faces_iterator->info().has_number())
+                && !(faces_iterator->info().is_visited()) && !(faces_iterator->info().depth == jumpsIterator)) {
+
+              int that_agent = faces_iterator->info().agent_id;
+              // check if that agent has fulfilled his need for cells according to its autonomy percentage
+              std::vector<std::pair <int,int> >::iterator it =
                       std::find_if(id_cell_count.begin(), id_cell_count.end(), comp(that_agent));
 
               neverInside = false;
@@ -758,7 +2051,8 @@ namespace qtnp {
 
                 if ((faces_iterator->neighbor(i)->is_in_domain()) && !(faces_iterator->neighbor(i)->info().has_number())) {
 
-                  if (it->second != 0){
+                  // running weight sum: the budget of the agent goes down by the weight of every cell it takes
+                  if (weight_budget[that_agent - 1] > 0){
 
                       // assign jumpers id in order to see which growing function has managed
                       // to reach the end or target.
@@ -771,6 +2065,10 @@ namespace qtnp {
                       faces_iterator->neighbor(i)->info().agent_id = faces_iterator->info().agent_id;
                       // reducing the cells appointed
                       it->second = it->second -1;
+                      int neighbor_id = faces_iterator->neighbor(i)->info().id;
+                      weight_budget[that_agent - 1] -= ((neighbor_id >= 0) && (neighbor_id < cell_weights.size()))
+                                                       ? cell_weights[neighbor_id] : 1.0;
+                      assigned_cells++;
                   }
                 }
               }
@@ -778,6 +2076,19 @@ namespace qtnp {
           }
          } while (neverInside == false);
 
+        // the replenishing below works in cells: what is left of a budget, in cells of the mean weight
+        double mean_weight(0);
+        int weighted_cells(0);
+        for (int id=0; id<cell_weights.size(); id++){
+            if (cells.is_vacant(id)) continue;
+            mean_weight += cell_weights[id];
+            weighted_cells++;
+        }
+        mean_weight = (weighted_cells > 0) && (mean_weight > 0) ? mean_weight / weighted_cells : 1.0;
+        for (int i=0; i<id_cell_count.size(); i++){
+            id_cell_count[i].second = (int) std::floor(weight_budget[i] / mean_weight + 0.5);
+        }
+
 
         // count cells and agent assigned cells
         std::vector<std::pair<int,int> > number_of_assigned_cells(id_cell_count.size() + 1);
@@ -791,14 +2102,12 @@ namespace qtnp {
           }
         }
 
-        std::cout << "Total cells: " << total_cells << std::endl;
-        std::cout << "Assigned cells: " << std::endl;
+        QTNP_DEBUG(Partitioning, "Total cells: " << total_cells);
         for (int i=0; i< id_cell_count.size() + 1; i++){
-        std::cout << "agent " << i << ": " << number_of_assigned_cells[i].second << std::endl;
+            QTNP_DEBUG(Partitioning, "Assigned cells, agent " << i << ": " << number_of_assigned_cells[i].second);
         }
-        std::cout << "Remaining cells: " << std::endl;
         for (int i=0; i< id_cell_count.size(); i++){
-        std::cout << "agent " << id_cell_count[i].first << ": " << id_cell_count[i].second << std::endl;
+            QTNP_DEBUG(Partitioning, "Remaining cells, agent " << id_cell_count[i].first << ": " << id_cell_count[i].second);
         }
 
         coverage_cost_attribution();
@@ -812,7 +2121,7 @@ namespace qtnp {
         for (int i=0; i< id_cell_count.size() + 1; i++){
           if (id_cell_count[i].second > 0) map_agent_missing_cells.push_back(std::pair<int,int>(id_cell_count[i].first, id_cell_count[i].second-1));
           cell_map.push_back(std::pair<int,int>(id_cell_count[i].first, - id_cell_count[i].second));
-            std::cout << "agent " << cell_map[i].first << " has: " << cell_map[i].second << " cells" << std::endl;
+            QTNP_DEBUG(Partitioning, "agent " << cell_map[i].first << " has: " << cell_map[i].second << " cells");
         }
 
         if (number_of_assigned_cells[0].second > 0) map_agent_surplus_cells.push_back(std::pair<int,int>(0,number_of_assigned_cells[0].second));
@@ -822,7 +2131,9 @@ namespace qtnp {
 
         if (number_of_assigned_cells[0].second > 0){
 
+            int balancing_steps(0);
             do {
+                planning_control().checkpoint("Balancing partitions", balancing_steps++, 0);
                 // REFACTORING
               // take agent which misses. is agent where cell_map.second is below zero
               int agent_missing = map_agent_missing_cells[0].first;
@@ -868,6 +2179,7 @@ namespace qtnp {
         int hopIterator = 1;
 
         do {
+            planning_control().checkpoint("Hop cost", hopIterator, 0);
             hopIterator++; // including non domain triangles
 
             finished = true;
@@ -901,6 +2213,39 @@ namespace qtnp {
     }
 
     // TODO: color depending on UI decision: hop depth, coverage depth etc
+    int Tnp_update::track_position(int uas, double lat, double lon){
+
+        // fixes come in at the telemetry rate, they don't queue up behind a planning request
+        boost::unique_lock<boost::mutex> lock(planning_mutex, boost::try_to_lock);
+        if (!lock.owns_lock() || !mesh_ready) return -2;
+
+        // a fix is a real latitude and longitude, the mesh takes them the other way round
+        // (see coordinates_to_cdt_cell_id)
+        double x, y;
+        geo.to_mesh(lon, lat, x, y);
+        return tracker.move(cdt, uas, CDT::Point(x, y));
+    }
+
+    bool Tnp_update::coverage_progress(std::vector<int> &covered, std::vector<int> &total){
+
+        boost::unique_lock<boost::mutex> lock(planning_mutex, boost::try_to_lock);
+        if (!lock.owns_lock() || !mesh_ready) return false;
+
+        covered.assign(1, 0);
+        total.assign(1, 0);
+        for (int id=0; id<cells.size(); id++){
+            if (cells.is_vacant(id)) continue;
+            int agent = std::max(0, (int) cells.face(id)->info().agent_id);
+            if (agent >= total.size()){
+                covered.resize(agent + 1, 0);
+                total.resize(agent + 1, 0);
+            }
+            total[agent]++;
+            if (tracker.is_covered(id)) covered[agent]++;
+        }
+        return true;
+    }
+
     void Tnp_update::mesh_coloring(){
 
         int color_iterator = 0;
@@ -916,9 +2261,10 @@ namespace qtnp {
           if (face->is_in_domain()){
 
             // create a point for each of the edges of the face.
-            CDT::Point point1 = cdt.triangle(face)[0];
-            CDT::Point point2 = cdt.triangle(face)[1];
-            CDT::Point point3 = cdt.triangle(face)[2];
+            CDT::Triangle triangle = cdt.triangle(face);
+            CDT::Point point1 = triangle[0];
+            CDT::Point point2 = triangle[1];
+            CDT::Point point3 = triangle[2];
 
             double face_depth = rviz_objects_ref.get_settings().task_cost ? face->info().depth : face->info().coverage_depth;
             float z = -face_depth;
@@ -985,100 +2331,240 @@ namespace qtnp {
     // put pair<int, <pair<double, double> > for uas number and lat,lon
     void Tnp_update::path_planning_coverage(std::pair<int, std::pair<double,double> > uas){
 
+        boost::lock_guard<boost::mutex> lock(planning_mutex);
+        if (!partition_ready){
+            QTNP_WARN(Coverage, "Coverage requested without a partition, perform the partitioning first");
+            return;
+        }
+
         coverage_cost_attribution();
         complete_path_coverage(uas);
         mesh_coloring();
         rviz_objects_ref.set_planning_ready(true) ;
+        keep_path_results();
+        save_snapshot("Coverage");
+    }
+
+    void Tnp_update::path_planning_resume(std::pair<int, std::pair<double,double> > uas, const std::vector<int> &covered_cells,
+                                          bool tracked_cells){
+
+        boost::lock_guard<boost::mutex> lock(planning_mutex);
+        if (!partition_ready){
+            QTNP_WARN(Coverage, "Coverage requested without a partition, perform the partitioning first");
+            return;
+        }
+        ros::WallTime started = ros::WallTime::now();
+        int uas_id = uas.first;
+
+        // the coverage depths are kept up to date by the partitioning and the hole changes
+        std::vector<bool> done(cells.size(), false);
+        for (int i=0; i<covered_cells.size(); i++){
+            if ((covered_cells[i] >= 0) && (covered_cells[i] < cells.size())) done[covered_cells[i]] = true;
+        }
+
+        std::vector<int> remaining;
+        int region_size(0);
+        for (int id=0; id<cells.size(); id++){
+            if (cells.is_vacant(id) || (cells.face(id)->info().agent_id != uas_id)) continue;
+            region_size++;
+            if (!done[id] && !(tracked_cells && tracker.is_covered(id))) remaining.push_back(id);
+        }
+
+        rviz_objects_ref.clear_path();
+        if (remaining.empty()){
+            QTNP_SUMMARY(Coverage, "Nothing left to cover for agent " << uas_id << " (" << region_size << " cells)");
+            return;
+        }
+
+        // from where the vehicle is now, it is the first waypoint as well; the position is
+        // (lat, lon), swapped for the mesh as coordinates_to_cdt_cell_id does
+        double x, y;
+        geo.to_mesh(uas.second.second, uas.second.first, x, y);
+        std::vector<std::vector<int> > paths(1, plan_coverage(remaining, -1, x, y));
+        optimize_coverage_paths(std::vector<int>(1, uas_id), paths);
+        const std::vector<int> &path = paths[0];
+
+        QTNP_SUMMARY(Coverage, "Resumed coverage path for agent " << uas_id << ": " << path.size() << " of " << region_size
+                     << " cells in " << (ros::WallTime::now() - started).toSec() * 1000.0 << " ms");
+        publish_coverage_path(uas, path);
+        mesh_coloring();
+        rviz_objects_ref.set_planning_ready(true) ;
+        keep_path_results();
+        save_snapshot("Coverage resume");
     }
 
     void Tnp_update::path_planning_to_goal(int uas, double lat, double lon){
 
+        boost::lock_guard<boost::mutex> lock(planning_mutex);
+        if (!partition_ready){
+            QTNP_WARN(Path_to_goal, "Path to goal requested without a partition, perform the partitioning first");
+            return;
+        }
+
         rviz_objects_ref.clear_path();
         path_to_goal(uas, coordinates_to_cdt_cell_id(lat,lon) );
         mesh_coloring();
         rviz_objects_ref.set_planning_ready(true) ;
+        keep_path_results();
+        save_snapshot("Path to goal");
 
     }
 
-    // TODO: make it go backwards
+    // The cells from the start cell of the uas to the goal (the channel), then the shortest
+    // line through them: only its corners, mesh vertices, become waypoints
     void Tnp_update::path_to_goal(int uas, int goal_cell_id){
 
-        CDT::Face_handle current_face;
-
-        for(CDT::Finite_faces_iterator faces_iterator = cdt.finite_faces_begin();
-            faces_iterator != cdt.finite_faces_end(); ++faces_iterator){
-            // TODO make uas_model class. make current_cell_id member var inside and take it in situations like this
-            if( (faces_iterator->info().agent_id == uas) && (faces_iterator->info().depth == 1) ){
-                current_face = faces_iterator;
-                rviz_objects_ref.push_path_point(utilities::build_pose_stamped(utilities::face_to_center(cdt, current_face)));
+        int start_id(-1);
+        for (int id = 0; id < cells.size(); id++){
+            if (cells.is_vacant(id)) continue;
+            const FaceInfo2 &info = cells.face(id)->info();
+            if ((info.agent_id == uas) && (info.depth == 1)){
+                start_id = id;
                 break;
             }
         }
+        if (start_id < 0){
+            QTNP_WARN(Path_to_goal, "Agent " << uas << " has no start cell in the partition");
+            return;
+        }
+        if ((goal_cell_id < 0) || (goal_cell_id >= cells.size()) || cells.is_vacant(goal_cell_id)){
+            QTNP_WARN(Path_to_goal, "Goal cell " << goal_cell_id << " is not in the mesh");
+            return;
+        }
 
+        std::vector<int> channel = cell_channel(start_id, goal_cell_id);
+        if (channel.empty()){
+            QTNP_WARN(Path_to_goal, "The goal cell " << goal_cell_id << " can't be reached from the start cell " << start_id);
+            return;
+        }
+        std::vector<CDT::Point> corners = string_pull(channel, CDT::Point(cells.x(start_id), cells.y(start_id)),
+                                                      CDT::Point(cells.x(goal_cell_id), cells.y(goal_cell_id)));
 
-      // TODO: missing initialization function
-      CDT::Face_handle target_face;
-      // TODO: missing initialization function
-      geometry_msgs::Point target_face_center;
-      int target_face_depth = 0;
-
-      // put it in the path
-      rviz_objects_ref.push_path_point(utilities::build_pose_stamped(utilities::face_to_center(cdt, current_face)));
-
-      Distance_Vector distance_vector;
+        // lat, lon of the corners, same as coverage so that the waypoint list can be built from them
+        std::vector< std::pair<double, double> > coord_path;
+        std::vector<double> lats(corners.size()), lons(corners.size());
+        double length(0);
+        for (int i=0; i<corners.size(); i++){
+            geometry_msgs::Point point;
+            point.x = corners[i].x();
+            point.y = corners[i].y();
+            point.z = 0;
+            rviz_objects_ref.push_path_point(utilities::build_pose_stamped(point));
+            geo.to_geo(point.x, point.y, lats[i], lons[i]);
+            coord_path.push_back(std::make_pair(lats[i], lons[i]));
+            if (i > 0) length += std::sqrt(CGAL::squared_distance(corners[i - 1], corners[i]));
+        }
+        std::vector<double> ground(corners.size());
+        // lats holds the real longitude, the raster wants (lat, lon)
+        terrain.sample(&lons[0], &lats[0], corners.size(), &ground[0]);
+        QTNP_SUMMARY(Path_to_goal, "Path to goal for agent " << uas << ": " << corners.size() << " waypoints through "
+                     << channel.size() << " cells, " << (int) (geo.metres(length) + 0.5) << " m");
+
+        // the initial cell stands in for the uas position (take off and landing)
+        make_mavros_waypoint_list(uas, std::pair<double, double>(cells.lon(start_id), cells.lat(start_id)), coord_path, ground);
+    }
 
-      // get target face
-      for(CDT::Finite_faces_iterator faces_iterator = cdt.finite_faces_begin();
-          faces_iterator != cdt.finite_faces_end(); ++faces_iterator){
-        if (faces_iterator->info().id == goal_cell_id){
-          target_face = faces_iterator;
-          target_face_center = utilities::face_to_center(cdt, target_face);
-          target_face_depth = target_face->info().depth;
-          // if it happens our target to be at the borders, we temporaly change its depth
-          if (target_face_depth == constants::coverage_depth_max){
-            int previous = 0;
-              for (int i=0; i<3; i++){
-                if (target_face->neighbor(i)->is_in_domain()){
-                    target_face_depth = (target_face->neighbor(i)->info().depth > previous) ?
-                                target_face->neighbor(i)->info().depth : previous;
-                    previous = target_face->neighbor(i)->info().depth;
-                }
+    // A* over the domain cells, between centroids, the straight distance to the goal as the
+    // estimate. The channel runs start to goal, each cell next to the one before; empty if the
+    // goal can't be reached
+    std::vector<int> Tnp_update::cell_channel(int start_id, int goal_id){
+
+        typedef std::pair<double, int> Open_entry;
+        std::vector<double> cost(cells.size(), -1);
+        std::vector<int> parent(cells.size(), -1);
+        std::vector<bool> closed(cells.size(), false);
+        std::priority_queue<Open_entry, std::vector<Open_entry>, std::greater<Open_entry> > open;
+
+        double goal_x = cells.x(goal_id), goal_y = cells.y(goal_id);
+        cost[start_id] = 0;
+        double sx = cells.x(start_id) - goal_x, sy = cells.y(start_id) - goal_y;
+        open.push(Open_entry(std::sqrt(sx * sx + sy * sy), start_id));
+        int expanded(0);
+        while (!open.empty()){
+            int id = open.top().second;
+            open.pop();
+            if (closed[id]) continue;
+            closed[id] = true;
+            if (id == goal_id) break;
+            if (++expanded % 4096 == 0) planning_control().checkpoint("Path to goal", expanded, cells.count());
+
+            CDT::Face_handle face = cells.face(id);
+            for (int j=0; j<3; j++){
+                CDT::Face_handle neighbor = face->neighbor(j);
+                if (!neighbor->is_in_domain()) continue;
+                int next = neighbor->info().id;
+                if ((next < 0) || (next >= cells.size()) || closed[next]) continue;
+                double dx = cells.x(next) - cells.x(id), dy = cells.y(next) - cells.y(id);
+                double next_cost = cost[id] + std::sqrt(dx * dx + dy * dy);
+                if ((cost[next] >= 0) && (cost[next] <= next_cost)) continue;
+                cost[next] = next_cost;
+                parent[next] = id;
+                double hx = cells.x(next) - goal_x, hy = cells.y(next) - goal_y;
+                open.push(Open_entry(next_cost + std::sqrt(hx * hx + hy * hy), next));
             }
-          }
-          break;
         }
-      }
-
-      float previous_distance = utilities::calculate_distance(
-                  (utilities::face_to_center(cdt, current_face)) , target_face_center);
-      std::cout << "Initial distance from start: " << previous_distance << std::endl;
-      int depth_runs = 1;
-      int branch_id = target_face->info().jumps_agent_id;
-
-      do {
-
-        depth_runs+=4;
 
-        for(CDT::Finite_faces_iterator faces_iterator = cdt.finite_faces_begin(); faces_iterator != cdt.finite_faces_end(); ++faces_iterator){
-          if ( (faces_iterator->info().agent_id == uas) &&
-               (faces_iterator->info().depth < depth_runs) &&
-               (faces_iterator->info().jumps_agent_id == branch_id) ){
+        std::vector<int> channel;
+        if (!closed[goal_id]) return channel;
+        for (int id = goal_id; id >= 0; id = parent[id]) channel.push_back(id);
+        std::reverse(channel.begin(), channel.end());
+        return channel;
+    }
 
-            float distance = utilities::calculate_distance(utilities::face_to_center(cdt, faces_iterator), target_face_center);
-            Distance_Entry this_entry = std::make_pair(faces_iterator, distance);
-            distance_vector.push_back(this_entry);
-          }
+    // The simple stupid funnel algorithm (Mononen) over the edges shared by the cells of the
+    // channel: the funnel from the apex narrows portal by portal, and where one side crosses
+    // over the other, that corner is a waypoint and the new apex. Linear in the channel length
+    std::vector<CDT::Point> Tnp_update::string_pull(const std::vector<int> &channel, const CDT::Point &start,
+                                                    const CDT::Point &goal){
+
+        // the portals as seen going through the channel; the start and the goal close them
+        std::vector<CDT::Point> lefts(1, start), rights(1, start);
+        for (int i=0; i+1<channel.size(); i++){
+            CDT::Face_handle face = cells.face(channel[i]);
+            int j = face->index(cells.face(channel[i + 1]));
+            // the vertices are counterclockwise: across the edge facing vertex j, its ccw
+            // neighbour is on the right
+            rights.push_back(face->vertex(CDT::ccw(j))->point());
+            lefts.push_back(face->vertex(CDT::cw(j))->point());
+        }
+        lefts.push_back(goal);
+        rights.push_back(goal);
+
+        std::vector<CDT::Point> corners(1, start);
+        CDT::Point apex = start, left = start, right = start;
+        int apex_index(0), left_index(0), right_index(0);
+
+        for (int i=1; i<lefts.size(); i++){
+            // the right side moves in, unless it crosses the left one
+            if (CGAL::orientation(apex, right, rights[i]) != CGAL::RIGHT_TURN){
+                if ((apex == right) || (CGAL::orientation(apex, left, rights[i]) == CGAL::RIGHT_TURN)){
+                    right = rights[i];
+                    right_index = i;
+                } else {
+                    corners.push_back(left);
+                    apex = right = left;
+                    apex_index = right_index = left_index;
+                    i = apex_index;
+                    continue;
+                }
+            }
+            // and the left side the same way
+            if (CGAL::orientation(apex, left, lefts[i]) != CGAL::LEFT_TURN){
+                if ((apex == left) || (CGAL::orientation(apex, right, lefts[i]) == CGAL::LEFT_TURN)){
+                    left = lefts[i];
+                    left_index = i;
+                } else {
+                    corners.push_back(right);
+                    apex = left = right;
+                    apex_index = left_index = right_index;
+                    i = apex_index;
+                    continue;
+                }
+            }
         }
 
-        std::sort(distance_vector.begin(), distance_vector.end(), utilities::distance_comparison);
-        // put the nearer to path
-        rviz_objects_ref.push_path_point(utilities::build_pose_stamped
-                                         (utilities::face_to_center(cdt, distance_vector.front().first)));
-        distance_vector.clear();
-
-
-      }while (depth_runs < target_face_depth);
-
+        if (corners.back() != goal) corners.push_back(goal);
+        return corners;
     }
 
     void Tnp_update::coverage_cost_attribution(){
@@ -1086,8 +2572,9 @@ namespace qtnp {
         for(CDT::Finite_faces_iterator faces_iterator = cdt.finite_faces_begin();
         faces_iterator != cdt.finite_faces_end(); ++faces_iterator){
             faces_iterator->info().coverage_depth = 0;
+            faces_iterator->info().cover_depth = false;
         }
-      std::cout << "----Beginning complete coverage cost attribution----" << std::endl;
+      QTNP_DEBUG(Coverage, "----Beginning complete coverage cost attribution----");
 
       // go through all triangles to give border depth to the borders between agents
       for(CDT::Finite_faces_iterator faces_iterator = cdt.finite_faces_begin();
@@ -1102,9 +2589,11 @@ namespace qtnp {
       }
 
       int so_many = 0;
+      int total_domain_cells = rviz_objects_ref.count_cells();
       int da_coverage_depth = constants::coverage_depth_max;
       bool never_ever_again = true;
       do {
+          planning_control().checkpoint("Coverage cost", so_many, total_domain_cells);
           da_coverage_depth = da_coverage_depth - 10;
           never_ever_again = true;
           for(CDT::Finite_faces_iterator faces_iterator = cdt.finite_faces_begin();
@@ -1125,122 +2614,731 @@ namespace qtnp {
       } while (!never_ever_again);
     }
 
+    // the same, for the cells of the given agents only; the borders of the others don't change
+    // as long as their own cells stay theirs
+    void Tnp_update::coverage_cost_attribution(const std::vector<bool> &agents){
+
+        std::vector<CDT::Face_handle> faces;
+        for (int id=0; id<cells.size(); id++){
+            if (cells.is_vacant(id)) continue;
+            int agent = cells.face(id)->info().agent_id;
+            if ((agent >= 0) && (agent < agents.size()) && agents[agent]) faces.push_back(cells.face(id));
+        }
+
+        for (int i=0; i<faces.size(); i++){
+            faces[i]->info().coverage_depth = 0;
+            faces[i]->info().cover_depth = false;
+            for (int j=0; j<3; j++){
+                if (faces[i]->neighbor(j)->info().agent_id != faces[i]->info().agent_id){
+                    faces[i]->info().coverage_depth = constants::coverage_depth_max;
+                    faces[i]->info().cover_depth = true;
+                }
+            }
+        }
+
+        int da_coverage_depth = constants::coverage_depth_max;
+        bool never_ever_again = true;
+        do {
+            planning_control().checkpoint("Coverage cost", constants::coverage_depth_max - da_coverage_depth, 0);
+            da_coverage_depth = da_coverage_depth - 10;
+            never_ever_again = true;
+            for (int i=0; i<faces.size(); i++){
+                if (faces[i]->info().has_coverage_depth() && (faces[i]->info().coverage_depth > da_coverage_depth)){
+                    for (int j=0; j<3; j++){
+                        CDT::Face_handle neighbor = faces[i]->neighbor(j);
+                        if ((neighbor->info().agent_id == faces[i]->info().agent_id) && !neighbor->info().has_coverage_depth()){
+                            neighbor->info().coverage_depth = da_coverage_depth;
+                            neighbor->info().cover_depth = true;
+                            never_ever_again = false;
+                        }
+                    }
+                }
+            }
+        } while (!never_ever_again);
+    }
+
     // TODO: make starter face a static and remove double reference in body
     void Tnp_update::complete_path_coverage(std::pair<int, std::pair<double, double> > uas){
         int uas_id = uas.first;
 
-        std::cout << "----Beginning complete coverage for agent : " << uas_id << "----" << std::endl;
+        QTNP_DEBUG(Coverage, "----Beginning complete coverage for agent : " << uas_id << "----");
 
         // clearing the path object in case it had a previous path
         rviz_objects_ref.clear_path();
-        std::vector< std::pair<double, double> > coord_path;
 
-        for(CDT::Finite_faces_iterator faces_iterator = cdt.finite_faces_begin();
-            faces_iterator != cdt.finite_faces_end(); ++faces_iterator){
-            faces_iterator->info().reset_path_visited();
-        };
+        std::vector<int> region_cells;
+        int initial_id(-1);
+        for (int id=0; id<cells.size(); id++){
+            if (cells.is_vacant(id) || (cells.face(id)->info().agent_id != uas_id)) continue;
+            region_cells.push_back(id);
+            if (cells.face(id)->info().depth == 1) initial_id = id;
+        }
+        if (initial_id < 0){
+            QTNP_WARN(Coverage, "Agent " << uas_id << " has no start cell in the partition");
+            return;
+        }
 
-        CDT::Face_handle initial_cell;
-        for(CDT::Finite_faces_iterator faces_iterator = cdt.finite_faces_begin();
-            faces_iterator != cdt.finite_faces_end(); ++faces_iterator){
-            if ( (faces_iterator->info().agent_id == uas_id) && (faces_iterator->info().depth == 1) ) {
-                initial_cell = faces_iterator;
-                break;
+        std::vector<std::vector<int> > paths(1, plan_coverage(region_cells, initial_id, cells.x(initial_id), cells.y(initial_id)));
+        optimize_coverage_paths(std::vector<int>(1, uas_id), paths);
+
+        QTNP_SUMMARY(Coverage, "Coverage path for agent " << uas_id << ": " << paths[0].size() << " cells");
+        publish_coverage_path(uas, paths[0]);
+    }
+
+    void Tnp_update::path_planning_coverage_all(){
+
+        boost::lock_guard<boost::mutex> lock(planning_mutex);
+        if (!partition_ready){
+            QTNP_WARN(Coverage, "Coverage requested without a partition, perform the partitioning first");
+            return;
+        }
+        coverage_cost_attribution();
+
+        std::vector<std::vector<int> > region_cells;
+        std::vector<int> start_ids;
+        for (int id=0; id<cells.size(); id++){
+            if (cells.is_vacant(id)) continue;
+            int agent = cells.face(id)->info().agent_id;
+            if (agent < 1) continue;
+            if (agent > region_cells.size()){
+                region_cells.resize(agent);
+                start_ids.resize(agent, -1);
             }
-        };
+            region_cells[agent - 1].push_back(id);
+            if (cells.face(id)->info().depth == 1) start_ids[agent - 1] = id;
+        }
 
-        CDT::Face_handle &starter_cell = initial_cell;
-        Face_Handle_Vector borders_vector;
-        Distance_Vector borders_distance_vector;
-        int current_depth = constants::coverage_depth_max;
+        std::vector<int> agents;
+        std::vector<std::vector<int> > paths;
+        for (int agent=1; agent<=region_cells.size(); agent++){
+            int start_id = start_ids[agent - 1];
+            if (start_id < 0){
+                QTNP_WARN(Coverage, "Agent " << agent << " has no start cell in the partition");
+                continue;
+            }
+            agents.push_back(agent);
+            paths.push_back(plan_coverage(region_cells[agent - 1], start_id, cells.x(start_id), cells.y(start_id)));
+        }
+        optimize_coverage_paths(agents, paths);
+
+        // every mission goes out; the last path stays on rviz
+        for (int i=0; i<agents.size(); i++){
+            rviz_objects_ref.clear_path();
+            // the home waypoint goes out (lon, lat), as in path_to_goal
+            int start_id = paths[i][0];
+            publish_coverage_path(std::make_pair(agents[i], std::make_pair(cells.lon(start_id), cells.lat(start_id))), paths[i]);
+        }
+        QTNP_SUMMARY(Coverage, "Coverage paths for " << agents.size() << " agents");
+        mesh_coloring();
+        rviz_objects_ref.set_planning_ready(true) ;
+        keep_path_results();
+        save_snapshot("Coverage");
+    }
+
+    // one Tour_optimizer per path, all at once on the pool, each within the tour budget
+    void Tnp_update::optimize_coverage_paths(const std::vector<int> &agents, std::vector<std::vector<int> > &paths){
+
+        double budget = tour_budget.load();
+        if ((budget <= 0) || paths.empty()) return;
+        planning_control().checkpoint("Optimizing coverage paths", 0, paths.size());
+
+        std::vector<Tour_optimizer> optimizers(paths.size());
+        std::vector<Thread_pool::job_type> jobs;
+        for (int i=0; i<paths.size(); i++){
+            jobs.push_back(boost::bind(&Tour_optimizer::optimize, &optimizers[i], cells.xs(), cells.ys(),
+                                       boost::ref(paths[i]), budget));
+        }
+        if (pool_ptr) pool_ptr->run_all(jobs);
+        else for (int i=0; i<jobs.size(); i++) jobs[i]();
+
+        for (int i=0; i<paths.size(); i++){
+            const Tour_optimizer &optimizer = optimizers[i];
+            double before = geo.metres(optimizer.length_before());
+            double after = geo.metres(optimizer.length_after());
+            QTNP_SUMMARY(Coverage, "Coverage path of agent " << agents[i] << ": " << (int) (before + 0.5) << " m before, "
+                         << (int) (after + 0.5) << " m after 2-opt/Or-opt ("
+                         << (before > 0 ? 100.0 * (before - after) / before : 0.0) << "% shorter, "
+                         << optimizer.moves() << " moves in " << optimizer.seconds() * 1000.0 << " ms"
+                         << (optimizer.converged() ? ")" : ", budget spent)"));
+        }
+    }
+
+    // The coverage order over the given cells: the outer ring of the region (coverage depth
+    // 999) first, then inwards ten at a time, always to the nearest cell not on the path yet.
+    // start_id (-1: none) goes first, otherwise the nearest one to (x, y)
+    std::vector<int> Tnp_update::plan_coverage(const std::vector<int> &cell_ids, int start_id, double x, double y){
+
+        std::vector<int> path;
+        std::vector<int> pending, candidates, merged;
+        std::vector<float> distances;
         int smallest_depth = constants::coverage_depth_max - 1;
-        bool not_finished = true;
-        bool initial = true;
 
-        starter_cell->info().path_visited = true;
-        rviz_objects_ref.push_path_point(utilities::build_pose_stamped
-                                         (utilities::face_to_center(cdt, starter_cell)));
-        // lat, lon
-        coord_path.push_back(std::pair<double, double>(starter_cell->info().center_lat, starter_cell->info().center_lon));
+        for (int i=0; i<cell_ids.size(); i++){
+            CDT::Face_handle face = cells.face(cell_ids[i]);
+            face->info().reset_path_visited();
+            smallest_depth = std::min(smallest_depth, (int) face->info().coverage_depth);
+            if (cell_ids[i] != start_id) pending.push_back(cell_ids[i]);
+        }
+        // candidates stay in id order, the ties go to the lowest id as in the face sweeps
+        std::sort(pending.begin(), pending.end());
+
+        if (start_id >= 0){
+            cells.face(start_id)->info().path_visited = true;
+            path.push_back(start_id);
+            x = cells.x(start_id);
+            y = cells.y(start_id);
+        }
 
-        do {
+        int current_depth = constants::coverage_depth_max;
+        while ((current_depth >= smallest_depth) && !(pending.empty() && candidates.empty())){
+
+            planning_control().checkpoint("Coverage path", path.size(), cell_ids.size());
+
+            // the cells of the ring reached now join the candidates
+            std::vector<int>::iterator ring = std::stable_partition(pending.begin(), pending.end(),
+                                                                    Coverage_depth_at_least(cells, current_depth));
+            if (ring != pending.begin()){
+                merged.clear();
+                std::merge(candidates.begin(), candidates.end(), pending.begin(), ring, std::back_inserter(merged));
+                candidates.swap(merged);
+                pending.erase(pending.begin(), ring);
+            }
 
-            not_finished = false;
+            if (candidates.empty()){
+                current_depth = current_depth - 10;
+                continue;
+            }
 
-            // go through all triangles, get the starter cell and the borders vector
-            for(CDT::Finite_faces_iterator faces_iterator = cdt.finite_faces_begin();
-                faces_iterator != cdt.finite_faces_end(); ++faces_iterator){
+            distances.resize(candidates.size());
+            kernels::distances_gather(cells.xs(), cells.ys(), &candidates[0], (int) candidates.size(), x, y, &distances[0]);
+            int closest = std::min_element(distances.begin(), distances.end()) - distances.begin();
+            int next_id = candidates[closest];
+            candidates.erase(candidates.begin() + closest);
 
-                if ( (faces_iterator->info().coverage_depth >= current_depth)
-                     && (faces_iterator->info().agent_id == uas_id)
-                     && (!faces_iterator->info().is_path_visited())) {
+            cells.face(next_id)->info().path_visited = true;
+            path.push_back(next_id);
+            x = cells.x(next_id);
+            y = cells.y(next_id);
+        }
+        return path;
+    }
 
-                    borders_vector.push_back(faces_iterator);
-                    not_finished = true;
-                }
+    void Tnp_update::publish_coverage_path(std::pair<int, std::pair<double, double> > uas, const std::vector<int> &cell_path){
 
-                if (initial){
-                    if (faces_iterator->info().coverage_depth < smallest_depth){
-                        smallest_depth = faces_iterator->info().coverage_depth;
-                    }
-                }
+        // the cells stay covered, the waypoints in between a straight run go
+        std::vector<int> path = compress_path(cell_path);
+        std::vector<int> waypoint_of;
+        std::vector<CDT::Point> points = validate_path(path, waypoint_of);
+        std::vector< std::pair<double, double> > coord_path;
+        std::vector<double> lats(points.size()), lons(points.size());
+        for (int i=0; i<points.size(); i++){
+            geometry_msgs::Point point;
+            point.x = points[i].x();
+            point.y = points[i].y();
+            point.z = 0;
+            rviz_objects_ref.push_path_point(utilities::build_pose_stamped(point));
+            // lats holds the real longitude (see Geo_transform)
+            geo.to_geo(point.x, point.y, lats[i], lons[i]);
+            coord_path.push_back(std::make_pair(lats[i], lons[i]));
+        }
+
+        // the ground under every waypoint; one at a cell is put as high as the highest cell of
+        // the run into it, so that the leg clears them all (fmax passes over the NaN)
+        std::vector<double> ground(points.size());
+        if (!points.empty()) terrain.sample(&lons[0], &lats[0], points.size(), &ground[0]);
+        std::vector<double> run_ground(path.size(), std::numeric_limits<double>::quiet_NaN());
+        for (int i=0, k=0; (i < cell_path.size()) && (k < path.size()); i++){
+            run_ground[k] = std::fmax(run_ground[k], cells.ground(cell_path[i]));
+            if (cell_path[i] == path[k]) k++;
+        }
+        for (int i=0; i<points.size(); i++){
+            if (waypoint_of[i] >= 0) ground[i] = std::fmax(ground[i], run_ground[waypoint_of[i]]);
+        }
+        make_mavros_waypoint_list(uas.first, uas.second, coord_path, ground);
+    }
+
+    // Every leg between consecutive waypoints is walked through the mesh; one that leaves the
+    // domain (cuts across a hole or the outer boundary) is replaced by the shortest line through
+    // the cells between its ends, as for the path to goal. Legs between neighbouring cells take a
+    // face or two of walking, so the whole path costs about its length
+    std::vector<CDT::Point> Tnp_update::validate_path(const std::vector<int> &path, std::vector<int> &waypoint_of){
+
+        ros::WallTime started = ros::WallTime::now();
+        std::vector<CDT::Point> points;
+        waypoint_of.clear();
+        if (path.empty()) return points;
+        points.push_back(CDT::Point(cells.x(path[0]), cells.y(path[0])));
+        waypoint_of.push_back(0);
+
+        int rerouted(0), unroutable(0);
+        for (int i=1; i<path.size(); i++){
+            CDT::Point from(cells.x(path[i - 1]), cells.y(path[i - 1]));
+            CDT::Point to(cells.x(path[i]), cells.y(path[i]));
+            if (segment_in_domain(cells.face(path[i - 1]), from, to)){
+                points.push_back(to);
+                waypoint_of.push_back(i);
+                continue;
             }
+            std::vector<int> channel = cell_channel(path[i - 1], path[i]);
+            if (channel.empty()){
+                // nothing connects the two, the leg stays as it was
+                unroutable++;
+                points.push_back(to);
+                waypoint_of.push_back(i);
+                continue;
+            }
+            std::vector<CDT::Point> corners = string_pull(channel, from, to);
+            points.insert(points.end(), corners.begin() + 1, corners.end());
+            waypoint_of.insert(waypoint_of.end(), corners.size() - 2, -1);
+            waypoint_of.push_back(i);
+            rerouted++;
+        }
 
-            initial = false;
+        QTNP_INFO(Waypoints, "Validated " << path.size() - 1 << " legs against the holes in "
+                  << (ros::WallTime::now() - started).toSec() * 1000.0 << " ms: " << rerouted << " re-routed, "
+                  << points.size() << " waypoints");
+        if (unroutable > 0){
+            QTNP_WARN(Waypoints, unroutable << " legs leave the domain and no cells connect their ends");
+        }
+        return points;
+    }
 
-            if (!not_finished){
-                current_depth = current_depth - 10;
-            } else {
+    // Douglas-Peucker over the centroids: a run of cells becomes one leg where none of them is
+    // further than the tolerance from it, and the leg stays inside the domain (clear of the holes)
+    std::vector<int> Tnp_update::compress_path(const std::vector<int> &path){
+
+        double tolerance_metres = waypoint_tolerance.load();
+        if ((tolerance_metres == 0) || (path.size() < 3)) return path;
+        double tolerance;
+        if (tolerance_metres > 0){
+            tolerance = geo.mesh_length(tolerance_metres);
+        } else {
+            // the side of an equilateral cell of the mean area along the path
+            double area(0);
+            for (int i=0; i<path.size(); i++) area += cells.area(path[i]);
+            area /= path.size();
+            tolerance = waypoint_tolerance_sides * std::sqrt(4 * area / std::sqrt(3.0));
+            tolerance_metres = geo.metres(tolerance);
+        }
 
-                // calculate the distance from all borders to the starter cell in order to choose the first border cell to visit
-                for (std::vector<CDT::Face_handle>::iterator it = borders_vector.begin(); it != borders_vector.end(); it++){
-                    float this_distance = utilities::calculate_distance(utilities::face_to_center(cdt, *it),
-                                                             utilities::face_to_center(cdt, starter_cell));
-                    Distance_Entry this_entry = std::make_pair(*it, this_distance);
-                    borders_distance_vector.push_back(this_entry);
+        std::vector<bool> keep(path.size(), false);
+        keep.front() = true;
+        keep.back() = true;
+        std::vector<std::pair<int, int> > stack(1, std::make_pair(0, (int) path.size() - 1));
+        while (!stack.empty()){
+            int first = stack.back().first;
+            int last = stack.back().second;
+            stack.pop_back();
+            if (last - first < 2) continue;
+
+            double ax = cells.x(path[first]), ay = cells.y(path[first]);
+            double bx = cells.x(path[last]), by = cells.y(path[last]);
+            double dx = bx - ax, dy = by - ay;
+            double length2 = dx * dx + dy * dy;
+            int farthest(first + 1);
+            double farthest_distance(-1);
+            for (int k = first + 1; k < last; k++){
+                double px = cells.x(path[k]) - ax, py = cells.y(path[k]) - ay;
+                double t = (length2 > 0) ? std::max(0.0, std::min(1.0, (px * dx + py * dy) / length2)) : 0.0;
+                double ex = px - t * dx, ey = py - t * dy;
+                double distance = std::sqrt(ex * ex + ey * ey);
+                if (distance > farthest_distance){
+                    farthest = k;
+                    farthest_distance = distance;
                 }
+            }
+
+            if ((farthest_distance <= tolerance) &&
+                segment_in_domain(cells.face(path[first]), CDT::Point(ax, ay), CDT::Point(bx, by))) continue;
+            keep[farthest] = true;
+            stack.push_back(std::make_pair(first, farthest));
+            stack.push_back(std::make_pair(farthest, last));
+        }
+
+        std::vector<int> compressed;
+        for (int i=0; i<path.size(); i++){
+            if (keep[i]) compressed.push_back(path[i]);
+        }
+        QTNP_INFO(Waypoints, "Path of " << path.size() << " cells compressed to " << compressed.size()
+                  << " waypoints, " << (double) path.size() / compressed.size() << " to 1 ("
+                  << tolerance_metres << " m tolerance)");
+        return compressed;
+    }
 
-                std::sort(borders_distance_vector.begin(), borders_distance_vector.end(), utilities::distance_comparison);
-                // and this is the closest
-                CDT::Face_handle &first_of_the_border = borders_distance_vector.front().first;
+    // A straight walk from the face holding p to the one holding q: through the edge pq crosses,
+    // q on its far side; false as soon as it leaves the domain. As in Coverage_tracker::walk
+    bool Tnp_update::segment_in_domain(CDT::Face_handle from, const CDT::Point &p, const CDT::Point &q){
 
-                // an o geitonas tou starter_cell, diladi toy proigoymenoy vimatos, pou einai pio konta
-                // ston first of the border, den exei ton firstOfTHeBor ws geitona,
-                // tote vale ayton ton geitona sto path, kanton visited an den einai,
-                // valton ws starter cell kai epanelave
+        CDT::Face_handle face = from;
+        int limit = cdt.number_of_faces();
 
-                rviz_objects_ref.push_path_point(utilities::build_pose_stamped
-                                                 (utilities::face_to_center(cdt, first_of_the_border)));
-                first_of_the_border->info().path_visited = true;
-                coord_path.push_back(std::pair<double, double>(first_of_the_border->info().center_lat,
-                                                               first_of_the_border->info().center_lon));
+        for (int step = 0; step < limit; step++){
+            if (!face->is_in_domain()) return false;
 
-                starter_cell = first_of_the_border;
+            int exit(-1);
+            for (int i=0; i<3; i++){
+                const CDT::Point &a = face->vertex(CDT::ccw(i))->point();
+                const CDT::Point &b = face->vertex(CDT::cw(i))->point();
+                if (CGAL::orientation(a, b, q) != CGAL::RIGHT_TURN) continue;
+                if (exit < 0) exit = i;
+                CGAL::Orientation side_a = CGAL::orientation(p, q, a);
+                CGAL::Orientation side_b = CGAL::orientation(p, q, b);
+                if ((side_a != side_b) || (side_a == CGAL::COLLINEAR)){
+                    exit = i;
+                    break;
+                }
             }
-            borders_vector.clear();
-            borders_distance_vector.clear();
-        } while (current_depth >= smallest_depth);
 
+            if (exit < 0) return true;
+            CDT::Face_handle next = face->neighbor(exit);
+            if (cdt.is_infinite(next)) return false;
+            face = next;
+        }
+        return false;
+    }
 
-        // TODO: prepei na to kanoyme na min pidaei...
-        std::cout << "----Finished complete coverage ----" << std::endl;
-        make_mavros_waypoint_list(uas.second, coord_path);
+    // Called at the end of every stage under the planning mutex, so the state is whole: the
+    // sections are put together here, the file is laid out, checksummed and written on the
+    // pool, after the mutex is let go
+    void Tnp_update::save_snapshot(const char *stage){
+
+        if (!snapshot_ptr || !snapshot_ptr->is_enabled() || !mesh_ready) return;
+        ros::WallTime started = ros::WallTime::now();
+        boost::shared_ptr<Snapshot_file> file(new Snapshot_file);
+
+        Snapshot_buffer area;
+        area.put((int32_t) geo.projection());
+        area.put(area_extremes.min_lat);
+        area.put(area_extremes.max_lat);
+        area.put(area_extremes.min_lon);
+        area.put(area_extremes.max_lon);
+        area.put(mesh_angle_criterion);
+        area.put(mesh_edge_criterion);
+        area.put((int32_t) next_hole_id);
+        area.put((uint8_t) partition_ready);
+        area.put((int32_t) partitioned_weight);
+        area.put((uint8_t) regions_remeshed);
+        file->add(snapshot_tag("AREA"), area);
+
+        std::vector<double> edges;
+        for (int i=0; i<cdt_polygon_edges.size(); i++){
+            edges.push_back(cdt_polygon_edges[i].x());
+            edges.push_back(cdt_polygon_edges[i].y());
+        }
+        Snapshot_buffer edge_section;
+        edge_section.put_array(edges);
+        file->add(snapshot_tag("EDGE"), edge_section);
+
+        Snapshot_buffer hole_section;
+        hole_section.put((uint64_t) holes.size());
+        for (int i=0; i<holes.size(); i++){
+            std::vector<double> outline;
+            for (int k=0; k<holes[i].outline.size(); k++){
+                outline.push_back(holes[i].outline[k].x());
+                outline.push_back(holes[i].outline[k].y());
+            }
+            hole_section.put((int32_t) holes[i].id);
+            hole_section.put(holes[i].seed.x());
+            hole_section.put(holes[i].seed.y());
+            hole_section.put_array(outline);
+        }
+        file->add(snapshot_tag("HOLE"), hole_section);
+
+        // the triangulation in the binary format of CGAL, read back by the same CGAL version only
+        std::ostringstream triangulation;
+        CGAL::set_binary_mode(triangulation);
+        triangulation << cdt;
+        Snapshot_buffer mesh;
+        mesh.put((int64_t) CGAL_VERSION_NR);
+        mesh.put((uint64_t) cdt.number_of_vertices());
+        mesh.put_bytes(triangulation.str());
+        file->add(snapshot_tag("MESH"), mesh);
+
+        // per face in the order CGAL writes and reads them, and the face of every cell
+        std::vector<Face_record> faces;
+        std::vector<int32_t> cell_faces(cells.size(), -1);
+        for (CDT::All_faces_iterator face = cdt.all_faces_begin(); face != cdt.all_faces_end(); ++face){
+            const FaceInfo2 &info = face->info();
+            Face_record record;
+            record.id = info.id;
+            record.depth = info.depth;
+            record.coverage_depth = info.coverage_depth;
+            record.jumps_agent_id = info.jumps_agent_id;
+            record.agent_id = info.agent_id;
+            record.flags = (info.visited ? Face_visited : 0) | (info.numbered ? Face_numbered : 0) |
+                           (info.path_visited ? Face_path_visited : 0) | (info.cover_depth ? Face_cover_depth : 0) |
+                           (info.aux ? Face_aux : 0) | (info.occupied ? Face_occupied : 0) |
+                           (face->is_in_domain() ? Face_in_domain : 0);
+            if ((info.id >= 0) && (info.id < cells.size()) && (cells.face(info.id) == face)) cell_faces[info.id] = faces.size();
+            faces.push_back(record);
+        }
+        Snapshot_buffer face_section, cell_section;
+        face_section.put_array(faces);
+        cell_section.put_array(cell_faces);
+        file->add(snapshot_tag("FACE"), face_section);
+        file->add(snapshot_tag("CELL"), cell_section);
+
+        Snapshot_buffer weight_section, tracker_section;
+        weight_section.put_array(cell_weights);
+        tracker_section.put_array(tracker.covered_bits());
+        file->add(snapshot_tag("WGHT"), weight_section);
+        file->add(snapshot_tag("TRCK"), tracker_section);
+
+        // the last list of every uas, then the very last one under -1
+        Snapshot_buffer waypoint_section;
+        {
+            boost::lock_guard<boost::mutex> lock(waypoint_mutex);
+            waypoint_section.put((uint64_t) waypoint_lists.size() + 1);
+            for (std::map<int, mavros_msgs::WaypointList>::const_iterator it = waypoint_lists.begin(); it != waypoint_lists.end(); ++it){
+                put_waypoint_list(waypoint_section, it->first, it->second);
+            }
+            put_waypoint_list(waypoint_section, -1, m_waypoint_list);
+        }
+        file->add(snapshot_tag("WPTS"), waypoint_section);
+
+        // the path on rviz
+        std::vector<double> path_points;
+        nav_msgs::Path path = rviz_objects_ref.get_path();
+        for (int i=0; i<path.poses.size(); i++){
+            path_points.push_back(path.poses[i].pose.position.x);
+            path_points.push_back(path.poses[i].pose.position.y);
+        }
+        Snapshot_buffer path_section;
+        path_section.put_array(path_points);
+        file->add(snapshot_tag("PATH"), path_section);
+
+        snapshot_ptr->write_async(file);
+        QTNP_DEBUG(General, "Session snapshot after " << stage << " put together in "
+                   << (ros::WallTime::now() - started).toSec() * 1000.0 << " ms");
     }
 
+    // Every section is read and checked before the session is touched; the triangulation is
+    // read into a triangulation of its own and swapped in, the faces keep their handles
+    bool Tnp_update::restore_snapshot(const std::string &path, std::string &error){
+
+        boost::lock_guard<boost::mutex> lock(planning_mutex);
+        ros::WallTime started = ros::WallTime::now();
+        Snapshot_reader reader;
+        if (!reader.open(path, error)) return false;
+
+        Snapshot_cursor area = reader.section(snapshot_tag("AREA"));
+        int32_t projection, hole_id_next;
+        Area_extremes extremes;
+        double angle_criterion, edge_criterion;
+        uint8_t partitioned;
+        if (!(area.get(projection) && area.get(extremes.min_lat) && area.get(extremes.max_lat) &&
+              area.get(extremes.min_lon) && area.get(extremes.max_lon) && area.get(angle_criterion) &&
+              area.get(edge_criterion) && area.get(hole_id_next) && area.get(partitioned))){
+            error = path + ": the area section is short";
+            return false;
+        }
+        // snapshots from before the weights were kept balanced by the cell count
+        int32_t balanced_by;
+        if (!area.get(balanced_by) || (balanced_by < Cell_count) || (balanced_by > Flight_time)) balanced_by = Cell_count;
+        uint8_t remeshed;
+        if (!area.get(remeshed)) remeshed = 0;
+
+        Snapshot_cursor mesh = reader.section(snapshot_tag("MESH"));
+        int64_t cgal_version;
+        uint64_t vertex_count;
+        std::string triangulation;
+        if (!(mesh.get(cgal_version) && mesh.get(vertex_count) && mesh.get_bytes(triangulation))){
+            error = path + ": the mesh section is short";
+            return false;
+        }
+        if (cgal_version != CGAL_VERSION_NR){
+            error = path + " was written with another version of CGAL";
+            return false;
+        }
+        CDT restored;
+        std::istringstream in(triangulation);
+        CGAL::set_binary_mode(in);
+        in >> restored;
+        if (!in || (restored.number_of_vertices() != vertex_count)){
+            error = path + ": the triangulation can't be read";
+            return false;
+        }
 
-    void Tnp_update::make_mavros_waypoint_list(std::pair<double, double> uas_coords,
-                                               std::vector<std::pair<double, double> > path){ // also put uas_id
+        std::vector<Face_record> faces;
+        std::vector<int32_t> cell_faces;
+        std::vector<double> edges, weights, path_points;
+        std::vector<uint64_t> covered_bits;
+        Snapshot_cursor face_section = reader.section(snapshot_tag("FACE"));
+        Snapshot_cursor cell_section = reader.section(snapshot_tag("CELL"));
+        Snapshot_cursor edge_section = reader.section(snapshot_tag("EDGE"));
+        Snapshot_cursor weight_section = reader.section(snapshot_tag("WGHT"));
+        Snapshot_cursor tracker_section = reader.section(snapshot_tag("TRCK"));
+        Snapshot_cursor path_section = reader.section(snapshot_tag("PATH"));
+        if (!(face_section.get_array(faces) && cell_section.get_array(cell_faces) && edge_section.get_array(edges) &&
+              weight_section.get_array(weights) && tracker_section.get_array(covered_bits) &&
+              path_section.get_array(path_points))){
+            error = path + ": a cell or path section is short";
+            return false;
+        }
+        int face_count(0);
+        for (CDT::All_faces_iterator face = restored.all_faces_begin(); face != restored.all_faces_end(); ++face) face_count++;
+        bool cells_fit = (face_count == faces.size());
+        for (int id=0; cells_fit && (id < cell_faces.size()); id++) cells_fit = (cell_faces[id] < face_count);
+        if (!cells_fit){
+            error = path + ": the cells don't match the triangulation";
+            return false;
+        }
 
-        mavros_msgs::Waypoint initialWaypoint;
-        mavros_msgs::WaypointList &waypoint_list = m_waypoint_list;
+        std::vector<Hole> restored_holes;
+        Snapshot_cursor hole_section = reader.section(snapshot_tag("HOLE"));
+        uint64_t hole_count(0);
+        bool holes_read = hole_section.get(hole_count);
+        for (uint64_t i=0; holes_read && (i < hole_count); i++){
+            Hole hole;
+            int32_t id;
+            double seed_x, seed_y;
+            std::vector<double> outline;
+            holes_read = hole_section.get(id) && hole_section.get(seed_x) && hole_section.get(seed_y) &&
+                         hole_section.get_array(outline);
+            hole.id = id;
+            hole.seed = CDT::Point(seed_x, seed_y);
+            for (int k=0; k+1<outline.size(); k+=2) hole.outline.push_back(CDT::Point(outline[k], outline[k + 1]));
+            restored_holes.push_back(hole);
+        }
+
+        std::map<int, mavros_msgs::WaypointList> restored_lists;
+        mavros_msgs::WaypointList last_list;
+        Snapshot_cursor waypoint_section = reader.section(snapshot_tag("WPTS"));
+        uint64_t list_count(0);
+        bool lists_read = waypoint_section.get(list_count);
+        for (uint64_t i=0; lists_read && (i < list_count); i++){
+            int uas_id;
+            mavros_msgs::WaypointList list;
+            lists_read = get_waypoint_list(waypoint_section, uas_id, list);
+            if (uas_id < 0) last_list = list;
+            else restored_lists[uas_id] = list;
+        }
+        if (!holes_read || !lists_read){
+            error = path + ": the hole or waypoint section is short";
+            return false;
+        }
+
+        // all of it read, the session is replaced
+        init();
+        cdt.swap(restored);
+        std::vector<CDT::Face_handle> face_handles;
+        face_handles.reserve(face_count);
+        int k(0);
+        for (CDT::All_faces_iterator face = cdt.all_faces_begin(); face != cdt.all_faces_end(); ++face, ++k){
+            const Face_record &record = faces[k];
+            FaceInfo2 &info = face->info();
+            info.id = record.id;
+            info.depth = record.depth;
+            info.coverage_depth = record.coverage_depth;
+            info.jumps_agent_id = record.jumps_agent_id;
+            info.agent_id = record.agent_id;
+            info.visited = (record.flags & Face_visited) != 0;
+            info.numbered = (record.flags & Face_numbered) != 0;
+            info.path_visited = (record.flags & Face_path_visited) != 0;
+            info.cover_depth = (record.flags & Face_cover_depth) != 0;
+            info.aux = (record.flags & Face_aux) != 0;
+            info.occupied = (record.flags & Face_occupied) != 0;
+            face->set_in_domain((record.flags & Face_in_domain) != 0);
+            face_handles.push_back(face);
+        }
+
+        cells.reserve(cell_faces.size());
+        for (int id=0; id<cell_faces.size(); id++){
+            if (cell_faces[id] < 0) cells.add_vacant();
+            else cells.add(face_handles[cell_faces[id]], cdt.triangle(face_handles[cell_faces[id]]));
+        }
+        area_extremes = extremes;
+        mesh_angle_criterion = angle_criterion;
+        mesh_edge_criterion = edge_criterion;
+        // the attractors are not kept in the snapshot, local refinement goes by the edge criterion
+        sizing_field = Sizing_field();
+        next_hole_id = hole_id_next;
+        holes.swap(restored_holes);
+        geo.set_projection((Geo_transform::Projection) projection);
+        geo.fit(area_extremes.min_lat, area_extremes.max_lat, area_extremes.min_lon, area_extremes.max_lon);
+        cells.update_coordinates(geo);
+        cells.update_ground(terrain);
+        tracker.restore(covered_bits, cells.size());
+        cell_weights.swap(weights);
+        partitioned_weight = (Partition_weight) balanced_by;
+        regions_remeshed = (remeshed != 0);
+        {
+            boost::lock_guard<boost::mutex> lock(waypoint_mutex);
+            waypoint_lists.swap(restored_lists);
+            m_waypoint_list = last_list;
+        }
+
+        // rviz as the stages left it
+        for (int i=0; i+3<edges.size(); i+=4){
+            kernel_Point_2 previous(edges[i], edges[i + 1]), current(edges[i + 2], edges[i + 3]);
+            cdt_polygon_edges.push_back(previous);
+            cdt_polygon_edges.push_back(current);
+            rviz_objects_ref.push_edge_point(utilities::cgal_point_to_ros_geometry_point(previous));
+            rviz_objects_ref.push_polygon_point(utilities::point_to_point_32(utilities::cgal_point_to_ros_geometry_point(current)));
+        }
+        rebuild_center_points();
+        rviz_objects_ref.clear_triangulation_mesh();
+        mesh_coloring();
+        rviz_objects_ref.clear_path();
+        for (int i=0; i+1<path_points.size(); i+=2){
+            geometry_msgs::Point point;
+            point.x = path_points[i];
+            point.y = path_points[i + 1];
+            point.z = 0;
+            rviz_objects_ref.push_path_point(utilities::build_pose_stamped(point));
+        }
+
+        mesh_ready = true;
+        partition_ready = (partitioned != 0);
+        rviz_objects_ref.set_polygon_ready(true);
+        rviz_objects_ref.set_planning_ready(true);
+        QTNP_SUMMARY(General, "Session restored from " << path << ": " << cells.count() << " cells, "
+                     << (partition_ready ? "partitioned" : "not partitioned") << ", " << waypoint_lists.size()
+                     << " waypoint lists, in " << (ros::WallTime::now() - started).toSec() * 1000.0 << " ms");
+        return true;
+    }
+
+    // The triangulation is counted at the size of its vertices and faces, what CGAL allocates
+    // them in blocks around that is left out
+    bool Tnp_update::memory_usage(size_t &bytes){
 
-        waypoint_list.waypoints.clear();
+        boost::unique_lock<boost::mutex> lock(planning_mutex, boost::try_to_lock);
+        if (!lock.owns_lock()) return false;
+
+        bytes = (cdt.number_of_vertices() + 1) * sizeof(CDT::Vertex) + cdt.tds().number_of_faces() * sizeof(CDT::Face);
+        bytes += cells.memory_bytes() + tracker.covered_bits().capacity() * sizeof(uint64_t);
+        bytes += cell_weights.capacity() * sizeof(double) + cdt_polygon_edges.capacity() * sizeof(kernel_Point_2);
+        for (int i=0; i<holes.size(); i++) bytes += holes[i].outline.capacity() * sizeof(CDT::Point);
+
+        boost::lock_guard<boost::mutex> waypoint_lock(waypoint_mutex);
+        size_t waypoints = m_waypoint_list.waypoints.size();
+        for (std::map<int, mavros_msgs::WaypointList>::const_iterator it = waypoint_lists.begin(); it != waypoint_lists.end(); ++it){
+            waypoints += it->second.waypoints.size();
+        }
+        bytes += waypoints * sizeof(mavros_msgs::Waypoint);
+        return true;
+    }
+
+    std::map<int, mavros_msgs::WaypointList> Tnp_update::take_updated_waypoint_lists(){
+
+        boost::lock_guard<boost::mutex> lock(waypoint_mutex);
+        std::map<int, mavros_msgs::WaypointList> lists;
+        lists.swap(updated_waypoint_lists);
+        return lists;
+    }
+
+    void Tnp_update::make_mavros_waypoint_list(int uas_id, std::pair<double, double> uas_coords,
+                                               std::vector<std::pair<double, double> > path,
+                                               const std::vector<double> &ground){
+
+        mavros_msgs::Waypoint initialWaypoint;
+        mavros_msgs::WaypointList waypoint_list;
 
         double initialLatitude = uas_coords.first;// path.poses[0].position.y;
         double initialLongitude = uas_coords.second; // of the uas agent according to initial position by ui (or later, current)
 
-        std::cout << "Center list: " << std::endl;
-        std::cout << std::fixed << std::setprecision(8) << "lat: " << initialLatitude << " lon: " << initialLongitude << std::endl;
+        QTNP_DEBUG(Waypoints, "Center list, home: lat: " << std::fixed << std::setprecision(8) << initialLatitude
+                   << " lon: " << initialLongitude);
         // this is for first initial position // maybe need to change frame, put it global (0)
         initialWaypoint.frame = 3;
         initialWaypoint.command = 16;
@@ -1252,25 +3350,22 @@ namespace qtnp {
         initialWaypoint.param4 = 0;
         initialWaypoint.x_lat = round(initialLatitude*100000000.0)/100000000.0;
         initialWaypoint.y_long = round(initialLongitude*100000000.0)/100000000.0;
-        initialWaypoint.z_alt = 285; // 0? for initial relevant altitude
+        initialWaypoint.z_alt = constants::home_waypoint_altitude;
         waypoint_list.waypoints.push_back(initialWaypoint);
 
-        // -------------------------------------------------//
-        // file generation
-        int sequence = 1;
-
-        std::stringstream mavlink_filename;
-        std::string data_path = "/home/fotis/Dev/Data/Missions/";
-        mavlink_filename << data_path << "mavlink_plan_" << currentDateTime() << ".txt";
-        const std::string& tmp = mavlink_filename.str();
-        const char* cstr = tmp.c_str();
-        std::ofstream mavlink_fWPPlan(cstr);
-        mavlink_fWPPlan << "QGC WPL 110" << std::endl;
-
-        mavlink_fWPPlan << "0\t1\t0\t16\t0\t0\t0\t0\t" << std::fixed << std::setprecision(7) << initialWaypoint.x_lat << "\t"
-                    << std::fixed <<  std::setprecision(7) << initialWaypoint.y_long << "\t585\t1" << std::endl;
-        // -------------------------------------------------//
-
+        // the altitudes are above home, the ground under the first point stands in for the
+        // ground there (the start cell, next to the home position)
+        double above_ground = flight_altitude.load();
+        std::vector<double> altitude(path.size(), above_ground);
+        bool follows_terrain = !ground.empty() && std::isfinite(ground[0]);
+        for (int i=0; follows_terrain && (i < path.size()) && (i < ground.size()); i++){
+            if (std::isfinite(ground[i])) altitude[i] = above_ground + ground[i] - ground[0];
+        }
+        if (follows_terrain){
+            QTNP_INFO(Waypoints, "Waypoint altitudes of UAS " << uas_id << " follow the terrain, "
+                      << *std::min_element(altitude.begin(), altitude.end()) << " to "
+                      << *std::max_element(altitude.begin(), altitude.end()) << " m above home");
+        }
 
         bool initial = true;
 
@@ -1292,16 +3387,10 @@ namespace qtnp {
                 waypoint.param4 = 0;
                 waypoint.x_lat = round( (it->second) *100000000.0)/100000000.0;
                 waypoint.y_long = round( (it->first)*100000000.0)/100000000.0;
-                waypoint.z_alt = 100; // 100? for takeoff
+                waypoint.z_alt = altitude[it - path.begin()];
                 waypoint_list.waypoints.push_back(waypoint);
                 initial = false;
-                std::cout << std::fixed << std::setprecision(8) << " lat: " << it->second << " lon: " << it->first << std::endl;
-
-                //--------------------------------//
-                // file generation //
-                mavlink_fWPPlan << "1\t0\t3\t22\t15\t0\t0\t0\t" << std::fixed << std::setprecision(7) << waypoint.x_lat << "\t"
-                        << std::fixed << std::setprecision(7) << waypoint.y_long << "\t100\t1" << std::endl;
-                //--------------------------------//
+                QTNP_DEBUG(Waypoints, " lat: " << std::fixed << std::setprecision(8) << it->second << " lon: " << it->first);
 
             } else {
 
@@ -1316,17 +3405,9 @@ namespace qtnp {
                 waypoint.param4 = 0;
                 waypoint.x_lat = round( (it->second) *100000000.0)/100000000.0;
                 waypoint.y_long = round( (it->first)*100000000.0)/100000000.0;
-                waypoint.z_alt = 100; // 100? for takeoff
+                waypoint.z_alt = altitude[it - path.begin()];
                 waypoint_list.waypoints.push_back(waypoint);
-                std::cout << std::fixed << std::setprecision(8) << " lat: " << it->second << " lon: " << it->first << std::endl;
-
-                //-----------------------------------//
-                // file generation //
-                mavlink_fWPPlan << sequence << "\t0\t3\t16\t0\t0\t0\t0\t" << std::fixed << std::setprecision(7) << waypoint.x_lat << "\t"
-                        << std::fixed << std::setprecision(7) << waypoint.y_long << "\t100\t1" << std::endl;
-                sequence++;
-                //-----------------------------------//
-
+                QTNP_DEBUG(Waypoints, " lat: " << std::fixed << std::setprecision(8) << it->second << " lon: " << it->first);
             }
         }
 
@@ -1342,17 +3423,16 @@ namespace qtnp {
         waypoint.param4 = 25;
         waypoint.x_lat = round(initialLatitude*100000000.0)/100000000.0;
         waypoint.y_long = round(initialLongitude*100000000.0)/100000000.0;
-        waypoint.z_alt = 580; // 100? for takeoff
+        waypoint.z_alt = constants::landing_waypoint_altitude;
         waypoint_list.waypoints.push_back(waypoint);
-        std::cout << std::fixed << std::setprecision(8) << initialLatitude << " " << initialLongitude << std::endl;
-
-
-        //--------------------------------//
-        // file generation //
-        mavlink_fWPPlan << sequence << "\t0\t3\t21\t480\t0\t0\t25\t" << std::fixed << std::setprecision(7) << waypoint.x_lat << "\t"
-                << std::fixed << std::setprecision(7) << waypoint.y_long << "\t580\t1"; // << std::endl;
-        mavlink_fWPPlan.close();
-        //--------------------------------//
+        QTNP_DEBUG(Waypoints, "landing: " << std::fixed << std::setprecision(8) << initialLatitude << " " << initialLongitude);
+        QTNP_SUMMARY(Waypoints, "Waypoint list for UAS " << uas_id << ": " << waypoint_list.waypoints.size() << " waypoints");
+
+        // the list is written to disk (Mission_writer) and uploaded (Mission_uploader) by the qnode
+        boost::lock_guard<boost::mutex> lock(waypoint_mutex);
+        m_waypoint_list = waypoint_list;
+        updated_waypoint_lists[uas_id] = waypoint_list;
+        waypoint_lists[uas_id] = waypoint_list;
 
     }
 
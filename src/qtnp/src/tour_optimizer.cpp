@@ -0,0 +1,289 @@
+/**
+ * @file /src/tour_optimizer.cpp
+ *
+ * @brief 2-opt and Or-opt improvement of a visiting order, under a time budget
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "../include/qtnp/tour_optimizer.hpp"
+
+/*****************************************************************************
+** Helpers
+*****************************************************************************/
+
+namespace {
+
+const int neighbour_count(8);
+// Or-opt moves stretches of one to this many points
+const int longest_segment(3);
+// the clock is read once per this many points looked at
+const int clock_interval(64);
+// about this many points per bucket of the grid
+const double points_per_bucket(2.0);
+// a move has to gain more than this, relative to the mean edge, against rounding loops
+const double least_gain(1e-9);
+
+typedef std::pair<double, int> Candidate;
+
+}
+
+namespace qtnp {
+
+/*****************************************************************************
+** Implementation
+*****************************************************************************/
+
+void Tour_optimizer::optimize(const double *xs, const double *ys, std::vector<int> &order, double budget){
+
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+    int n = order.size();
+    x.resize(n);
+    y.resize(n);
+    tour.resize(n);
+    position.resize(n);
+    for (int i=0; i<n; i++){
+        x[i] = xs[order[i]];
+        y[i] = ys[order[i]];
+        tour[i] = i;
+        position[i] = i;
+    }
+    before = after = path_length();
+    moves_made = 0;
+    finished = true;
+    elapsed = 0;
+    if (n < 4) return;
+
+    std::chrono::steady_clock::time_point deadline = started +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(budget));
+    find_neighbours();
+
+    queue.clear();
+    queued.assign(n, true);
+    for (int i=0; i<n; i++) queue.push_back(tour[i]);
+
+    int looked(0);
+    while (!queue.empty()){
+        if ((budget > 0) && (++looked % clock_interval == 0) && (std::chrono::steady_clock::now() > deadline)){
+            finished = false;
+            break;
+        }
+        int a = queue.front();
+        queue.pop_front();
+        queued[a] = false;
+        if (two_opt(a) || or_opt(a)){
+            moves_made++;
+            touch(position[a]);
+        }
+    }
+
+    after = path_length();
+    std::vector<int> optimized(n);
+    for (int i=0; i<n; i++) optimized[i] = order[tour[i]];
+    order.swap(optimized);
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+}
+
+double Tour_optimizer::distance(int a, int b) const {
+    double dx = x[a] - x[b];
+    double dy = y[a] - y[b];
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+// the edge from a position to the next one, 0 past the end of the path
+double Tour_optimizer::edge(int from_position) const {
+    if ((from_position < 0) || (from_position + 1 >= tour.size())) return 0;
+    return distance(tour[from_position], tour[from_position + 1]);
+}
+
+double Tour_optimizer::path_length() const {
+    double length(0);
+    for (int i=0; i+1<tour.size(); i++) length += edge(i);
+    return length;
+}
+
+// The points are counted into a grid of buckets, then the rings of buckets around each point
+// are searched outwards until the nearest found are nearer than anything a further ring holds
+void Tour_optimizer::find_neighbours(){
+
+    int n = x.size();
+    double min_x = *std::min_element(x.begin(), x.end());
+    double max_x = *std::max_element(x.begin(), x.end());
+    double min_y = *std::min_element(y.begin(), y.end());
+    double max_y = *std::max_element(y.begin(), y.end());
+    double area = std::max((max_x - min_x) * (max_y - min_y), 1e-12);
+    double size = std::sqrt(area * points_per_bucket / n);
+    if (size <= 0) size = 1;
+    int columns = std::max(1, (int) ((max_x - min_x) / size) + 1);
+    int rows = std::max(1, (int) ((max_y - min_y) / size) + 1);
+
+    std::vector<int> bucket_of(n), first(columns * rows + 1, 0), members(n);
+    for (int p=0; p<n; p++){
+        int column = std::min(columns - 1, (int) ((x[p] - min_x) / size));
+        int row = std::min(rows - 1, (int) ((y[p] - min_y) / size));
+        bucket_of[p] = row * columns + column;
+        first[bucket_of[p] + 1]++;
+    }
+    for (int b=0; b<columns * rows; b++) first[b + 1] += first[b];
+    std::vector<int> fill(first.begin(), first.end() - 1);
+    for (int p=0; p<n; p++) members[fill[bucket_of[p]]++] = p;
+
+    int wanted = std::min(neighbour_count, n - 1);
+    neighbours.assign(n * neighbour_count, -1);
+    std::vector<Candidate> nearest;
+    for (int p=0; p<n; p++){
+        int column = bucket_of[p] % columns;
+        int row = bucket_of[p] / columns;
+        nearest.clear();
+        for (int ring = 0; ring <= std::max(columns, rows); ring++){
+            for (int r = row - ring; r <= row + ring; r++){
+                if ((r < 0) || (r >= rows)) continue;
+                // the whole row on the top and bottom of the ring, its two ends otherwise
+                int step = ((r == row - ring) || (r == row + ring)) ? 1 : std::max(1, 2 * ring);
+                for (int c = column - ring; c <= column + ring; c += step){
+                    if ((c < 0) || (c >= columns)) continue;
+                    int b = r * columns + c;
+                    for (int m = first[b]; m < first[b + 1]; m++){
+                        int q = members[m];
+                        if (q != p) nearest.push_back(Candidate(distance(p, q), q));
+                    }
+                }
+            }
+            if (nearest.size() >= wanted){
+                std::nth_element(nearest.begin(), nearest.begin() + (wanted - 1), nearest.end());
+                if (nearest[wanted - 1].first <= ring * size) break;
+            }
+        }
+        std::sort(nearest.begin(), nearest.end());
+        for (int k=0; (k < wanted) && (k < nearest.size()); k++) neighbours[p * neighbour_count + k] = nearest[k].second;
+    }
+}
+
+// Replaces the edges after positions lo and hi by lo-hi and lo+1-hi+1, reversing the stretch
+// in between. With the new edge a-c: lo, hi are the positions of a and c (a and its successor
+// leave each other), or the ones before them (a and its predecessor)
+bool Tour_optimizer::two_opt(int a){
+
+    int n = tour.size();
+    int i = position[a];
+    for (int side = 0; side < 2; side++){
+        // side 0: the edge after a, side 1: the edge before it
+        if ((side == 0) && (i + 1 >= n)) continue;
+        if ((side == 1) && (i < 1)) continue;
+        double removed = (side == 0) ? edge(i) : edge(i - 1);
+        for (int k=0; k<neighbour_count; k++){
+            int c = neighbours[a * neighbour_count + k];
+            if (c < 0) break;
+            double added = distance(a, c);
+            if (added >= removed) break;
+            int j = position[c];
+            int lo = std::min(i, j) - side;
+            int hi = std::max(i, j) - side;
+            if ((lo < 0) || (hi < lo + 2)) continue;
+            double gain = edge(lo) + edge(hi) - distance(tour[lo], tour[hi]);
+            if (hi + 1 < n) gain -= distance(tour[lo + 1], tour[hi + 1]);
+            if (gain <= least_gain * (removed + added)) continue;
+            reverse(lo + 1, hi);
+            touch(lo);
+            touch(hi);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Takes out the stretch from a on, one to three points long, and puts it in next to one of the
+// nearest neighbours of its ends, either way round
+bool Tour_optimizer::or_opt(int a){
+
+    int n = tour.size();
+    int i = position[a];
+    if (i < 1) return false;
+
+    for (int length = 1; length <= longest_segment; length++){
+        int last = i + length - 1;
+        if (last >= n) break;
+        int s = tour[i];
+        int e = tour[last];
+        int prev = tour[i - 1];
+        double taken_out = distance(prev, s) + edge(last);
+        if (last + 1 < n) taken_out -= distance(prev, tour[last + 1]);
+        if (taken_out <= 0) continue;
+
+        for (int end = 0; end < 2; end++){
+            int from = (end == 0) ? s : e;
+            for (int k=0; k<neighbour_count; k++){
+                int c = neighbours[from * neighbour_count + k];
+                if (c < 0) break;
+                if (distance(from, c) >= taken_out) break;
+                int j = position[c];
+                if ((j >= i) && (j <= last)) continue;
+
+                // from s: c s..e next or prev e..s c; from e: prev s..e c or c e..s next
+                for (int after = 0; after < 2; after++){
+                    // the stretch goes between positions u and u + 1
+                    int u = ((end == 0) == (after == 0)) ? j : j - 1;
+                    if ((u < 0) || ((u >= i - 1) && (u <= last))) continue;
+                    bool reversed = (after == 1);
+                    int head = reversed ? e : s;
+                    int tail = reversed ? s : e;
+                    double put_in = distance(tour[u], head);
+                    if (u + 1 < n) put_in += distance(tail, tour[u + 1]) - edge(u);
+                    if (taken_out - put_in <= least_gain * taken_out) continue;
+                    move_segment(i, length, u, reversed);
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+void Tour_optimizer::reverse(int from, int to){
+    std::reverse(tour.begin() + from, tour.begin() + to + 1);
+    for (int p = from; p <= to; p++) position[tour[p]] = p;
+}
+
+// moves the stretch first .. first + length - 1 to just after the position after_position
+void Tour_optimizer::move_segment(int first, int length, int after_position, bool reversed){
+
+    int start, stop;
+    if (after_position > first){
+        std::rotate(tour.begin() + first, tour.begin() + first + length, tour.begin() + after_position + 1);
+        start = first;
+        stop = after_position;
+        if (reversed) std::reverse(tour.begin() + after_position - length + 1, tour.begin() + after_position + 1);
+    } else {
+        std::rotate(tour.begin() + after_position + 1, tour.begin() + first, tour.begin() + first + length);
+        start = after_position + 1;
+        stop = first + length - 1;
+        if (reversed) std::reverse(tour.begin() + after_position + 1, tour.begin() + after_position + 1 + length);
+    }
+    for (int p = start; p <= stop; p++) position[tour[p]] = p;
+
+    // the two that closed the gap, and the stretch with the two around it
+    touch((after_position > first) ? first - 1 : first + length - 1);
+    int placed = (after_position > first) ? after_position - length + 1 : after_position + 1;
+    touch(placed - 1);
+    touch(placed + length - 1);
+}
+
+// the points at and after a position get looked at again
+void Tour_optimizer::touch(int at){
+    for (int p = at; p <= at + 1; p++){
+        if ((p < 0) || (p >= tour.size()) || queued[tour[p]]) continue;
+        queued[tour[p]] = true;
+        queue.push_back(tour[p]);
+    }
+}
+
+} // namespace qtnp
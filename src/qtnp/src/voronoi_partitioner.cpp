@@ -0,0 +1,269 @@
+/**
+ * @file /src/voronoi_partitioner.cpp
+ *
+ * @brief Additively weighted geodesic Voronoi partitioning of the cell graph
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <boost/bind.hpp>
+
+#include "../include/qtnp/voronoi_partitioner.hpp"
+
+/*****************************************************************************
+** Helpers
+*****************************************************************************/
+
+namespace {
+
+const int max_rounds(60);
+// done when every part is within this much of its target weight
+const double balance_tolerance(0.01);
+// the step sizes tried in parallel each round, times the step of every part
+const double step_scales[] = { 0.5, 1.0, 1.5, 2.0 };
+const int candidate_count(sizeof(step_scales) / sizeof(step_scales[0]));
+// the step of a part grows while its weight stays on the same side of the target and halves
+// when it crosses over; the tuning stops when the steps of the parts still off are all below
+// the least step, in mean edge lengths, or the best labeling has not improved for a while
+const double step_growth(1.2);
+const double least_step(1.0 / 64);
+const int patience(12);
+
+const uint64_t unreached(std::numeric_limits<uint64_t>::max());
+
+// A monotone priority queue: keys never go below the last one popped, which Dijkstra with
+// non negative lengths guarantees. Bucket i holds the keys that first differ from the last
+// popped one in bit i - 1; an entry moves down a bucket at a time, at most 64 moves in all.
+class Radix_heap {
+  public:
+    typedef std::pair<uint64_t, int> entry_type;
+
+    Radix_heap() : last(0), count(0), buckets(65) {}
+
+    bool empty() const { return count == 0; }
+
+    void push(uint64_t key, int value){
+        buckets[bucket(key)].push_back(entry_type(key, value));
+        count++;
+    }
+
+    entry_type pop(){
+        if (buckets[0].empty()){
+            int i = 1;
+            while (buckets[i].empty()) i++;
+            uint64_t least = buckets[i][0].first;
+            for (int j=1; j<buckets[i].size(); j++) least = std::min(least, buckets[i][j].first);
+            last = least;
+            for (int j=0; j<buckets[i].size(); j++) buckets[bucket(buckets[i][j].first)].push_back(buckets[i][j]);
+            buckets[i].clear();
+        }
+        entry_type top = buckets[0].back();
+        buckets[0].pop_back();
+        count--;
+        return top;
+    }
+
+  private:
+    int bucket(uint64_t key) const {
+        return (key == last) ? 0 : 64 - __builtin_clzll(key ^ last);
+    }
+
+    uint64_t last;
+    int count;
+    std::vector<std::vector<entry_type> > buckets;
+};
+
+}
+
+namespace qtnp {
+
+/*****************************************************************************
+** Implementation
+*****************************************************************************/
+
+std::vector<int> Voronoi_partitioner::partition(const Partition_graph &graph, const std::vector<double> &targets,
+                                                const std::vector<int> &pinned){
+
+    int parts = targets.size();
+    int n = graph.size();
+    rounds_run = 0;
+    imbalance_reached = 0;
+    if ((parts == 0) || (n == 0)) return std::vector<int>(n, -1);
+
+    double total(0), shares(0);
+    for (int v=0; v<n; v++) total += graph.vwgt[v];
+    for (int p=0; p<parts; p++) shares += std::max(0.0, targets[p]);
+    target_weight.resize(parts);
+    sources.assign(parts, -1);
+    source_vertex.assign(n, false);
+    for (int p=0; p<parts; p++){
+        target_weight[p] = (shares > 0) ? total * std::max(0.0, targets[p]) / shares : total / parts;
+        if ((p >= pinned.size()) || (pinned[p] < 0) || (pinned[p] >= n) || source_vertex[pinned[p]]) continue;
+        if (target_weight[p] <= 0) continue;
+        sources[p] = pinned[p];
+        source_vertex[pinned[p]] = true;
+    }
+
+    double mean_length(1);
+    if (!graph.adjwgt.empty()){
+        mean_length = 0;
+        for (int e=0; e<graph.adjwgt.size(); e++) mean_length += graph.adjwgt[e];
+        mean_length /= graph.adjwgt.size();
+    }
+
+    // round 0 is the plain geodesic Voronoi partition
+    std::vector<uint64_t> offset(parts, 0);
+    Labeling current;
+    label(graph, offset, current);
+
+    std::vector<Labeling> candidates(candidate_count);
+    std::vector<std::vector<uint64_t> > candidate_offsets(candidate_count, offset);
+    Labeling best_labeling(current);
+    int since_best(0);
+    // the step size of every part and the side of its target it was on, 0 before the first
+    std::vector<double> step_size(parts, 0.0);
+    std::vector<int> side(parts, 0);
+
+    for (int round = 1; round <= max_rounds; round++){
+        if ((best_labeling.imbalance <= balance_tolerance) || (since_best >= patience)) break;
+
+        // moving the border of a part by one edge length trades about its border weight; both
+        // sides of a border move, so half of it each. A step of the offset difference to the
+        // nearest source puts the border past it, the first step stays well below that
+        std::vector<double> step(parts, 0.0);
+        bool moving(false);
+        for (int p=0; p<parts; p++){
+            if ((sources[p] < 0) || within(current, p)) continue;
+            double excess = current.weight[p] - target_weight[p];
+            int now = (excess > 0) ? 1 : -1;
+            if (side[p] == 0){
+                double cap = (current.gap[p] < unreached) ? current.gap[p] / 4.0 : mean_length * std::sqrt((double) n);
+                step_size[p] = std::min(cap, std::fabs(excess) * mean_length / std::max(current.border[p], 1.0) / 2);
+            } else {
+                step_size[p] *= (now == side[p]) ? step_growth : 0.5;
+            }
+            side[p] = now;
+            step[p] = now * step_size[p];
+            if (step_size[p] >= least_step * mean_length) moving = true;
+        }
+        if (!moving) break;
+        planning_control.checkpoint("Voronoi partitioning", round, max_rounds);
+
+        std::vector<Thread_pool::job_type> jobs;
+        for (int c=0; c<candidate_count; c++){
+            std::vector<double> moved(parts);
+            double least(0);
+            for (int p=0; p<parts; p++){
+                moved[p] = offset[p] + step_scales[c] * step[p];
+                least = (p == 0) ? moved[p] : std::min(least, moved[p]);
+            }
+            // the radix heap wants the keys from 0 up
+            for (int p=0; p<parts; p++) candidate_offsets[c][p] = (uint64_t) (moved[p] - least + 0.5);
+            jobs.push_back(boost::bind(&Voronoi_partitioner::label, this, boost::cref(graph),
+                                       boost::cref(candidate_offsets[c]), boost::ref(candidates[c])));
+        }
+        if (pool_ptr) pool_ptr->run_all(jobs);
+        else for (int c=0; c<jobs.size(); c++) jobs[c]();
+        rounds_run = round;
+
+        // judged by the weight out of place in all; the largest deviation alone stays put while
+        // a swallowed part comes back
+        int best(0);
+        for (int c=1; c<candidate_count; c++){
+            if (candidates[c].misplaced < candidates[best].misplaced) best = c;
+        }
+        // the best of them goes on even when worse than the round before, the steps that
+        // overshot shrink on the next round
+        std::swap(current, candidates[best]);
+        offset = candidate_offsets[best];
+        if (current.misplaced < best_labeling.misplaced){
+            best_labeling = current;
+            since_best = 0;
+        } else {
+            since_best++;
+        }
+    }
+
+    imbalance_reached = best_labeling.imbalance;
+    return best_labeling.part;
+}
+
+bool Voronoi_partitioner::within(const Labeling &labeling, int p) const {
+
+    return std::fabs(labeling.weight[p] - target_weight[p]) <= balance_tolerance * target_weight[p];
+}
+
+// one multi-source Dijkstra; safe to run on several threads at once, it only reads the members
+void Voronoi_partitioner::label(const Partition_graph &graph, const std::vector<uint64_t> &offset,
+                                Labeling &labeling) const {
+
+    int n = graph.size();
+    int parts = sources.size();
+    labeling.part.assign(n, -1);
+    labeling.dist.assign(n, unreached);
+    labeling.weight.assign(parts, 0.0);
+    labeling.reach.assign(parts, 0);
+    labeling.border.assign(parts, 0.0);
+    labeling.gap.assign(parts, unreached);
+
+    Radix_heap heap;
+    for (int p=0; p<parts; p++){
+        int s = sources[p];
+        if (s < 0) continue;
+        labeling.dist[s] = offset[p];
+        labeling.part[s] = p;
+        heap.push(offset[p], s);
+    }
+
+    while (!heap.empty()){
+        Radix_heap::entry_type top = heap.pop();
+        int v = top.second;
+        if (top.first != labeling.dist[v]) continue;  // superseded
+
+        int p = labeling.part[v];
+        labeling.weight[p] += graph.vwgt[v];
+        labeling.reach[p] = std::max(labeling.reach[p], top.first - offset[p]);
+
+        for (int e = graph.xadj[v]; e < graph.xadj[v + 1]; e++){
+            int u = graph.adjncy[e];
+            uint64_t d = top.first + graph.adjwgt[e];
+            // a source stays with its part, however cheap another part would reach it
+            if ((d >= labeling.dist[u]) || source_vertex[u]) continue;
+            labeling.dist[u] = d;
+            labeling.part[u] = p;
+            heap.push(d, u);
+        }
+    }
+
+    // along an edge across a border the two sources are that far apart, at least
+    for (int v=0; v<n; v++){
+        int p = labeling.part[v];
+        if (p < 0) continue;
+        bool border(false);
+        for (int e = graph.xadj[v]; e < graph.xadj[v + 1]; e++){
+            int q = labeling.part[graph.adjncy[e]];
+            if ((q == p) || (q < 0)) continue;
+            border = true;
+            uint64_t apart = (labeling.dist[v] - offset[p]) + (labeling.dist[graph.adjncy[e]] - offset[q]) + graph.adjwgt[e];
+            labeling.gap[p] = std::min(labeling.gap[p], apart);
+        }
+        if (border) labeling.border[p] += graph.vwgt[v];
+    }
+
+    labeling.imbalance = 0;
+    labeling.misplaced = 0;
+    for (int p=0; p<parts; p++){
+        labeling.misplaced += std::fabs(labeling.weight[p] - target_weight[p]);
+        if (target_weight[p] <= 0) continue;
+        labeling.imbalance = std::max(labeling.imbalance, std::fabs(labeling.weight[p] - target_weight[p]) / target_weight[p]);
+    }
+}
+
+} // namespace qtnp
@@ -0,0 +1,127 @@
+/**
+ * @file /test/cell_table_test.cpp
+ *
+ * @brief The ground under a cell, from a small raster through the mesh transform
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../include/qtnp/cdt_types.hpp"
+#include "../include/qtnp/cell_table.hpp"
+#include "../include/qtnp/geo_transform.hpp"
+#include "../include/qtnp/terrain_model.hpp"
+
+/*****************************************************************************
+** Helpers
+*****************************************************************************/
+
+namespace {
+
+using namespace qtnp;
+
+// posts a hundredth of a degree apart; the lon and lat ranges don't overlap, so a swapped
+// pair lands off the raster
+const int columns(5);
+const int rows(5);
+const double post_spacing(0.01);
+const double west_lon(23.70);
+const double south_lat(37.97);
+
+// distinct at every post, north row first as in the file
+float post_value(int row, int column){
+    return 100.0f + 10.0f * row + column;
+}
+
+// a GridFloat pair in a fresh directory, the path of the .hdr
+std::string write_raster(){
+
+    char directory[] = "/tmp/qtnp_cell_table_XXXXXX";
+    if (mkdtemp(directory) == NULL) return std::string();
+    std::string base = std::string(directory) + "/terrain";
+
+    std::ofstream header((base + ".hdr").c_str());
+    header << "ncols " << columns << "\n"
+           << "nrows " << rows << "\n"
+           << "xllcenter " << west_lon << "\n"
+           << "yllcenter " << south_lat << "\n"
+           << "cellsize " << post_spacing << "\n"
+           << "NODATA_value -9999\n"
+           << "byteorder lsbfirst\n";
+    header.close();
+
+    std::vector<float> posts;
+    for (int r=0; r<rows; r++){
+        for (int c=0; c<columns; c++) posts.push_back(post_value(r, c));
+    }
+    std::ofstream data((base + ".flt").c_str(), std::ios::binary);
+    data.write(reinterpret_cast<const char*>(&posts[0]), posts.size() * sizeof(float));
+    data.close();
+    return base + ".hdr";
+}
+
+}
+
+/*****************************************************************************
+** Tests
+*****************************************************************************/
+
+// the centroid of a small triangle sits on a post; its ground has to be that post
+TEST(Cell_table, GroundUnderCentroidIsThePost){
+
+    std::string path = write_raster();
+    ASSERT_FALSE(path.empty());
+    Terrain_model terrain;
+    std::string error;
+    ASSERT_TRUE(terrain.load(path, error)) << error;
+
+    // the mesh takes the kml pair, longitude first (see Geo_transform)
+    Geo_transform geo;
+    geo.set_projection(Geo_transform::Local_enu);
+    geo.fit(west_lon, west_lon + (columns - 1) * post_spacing,
+            south_lat, south_lat + (rows - 1) * post_spacing);
+
+    const int row(2), column(3);
+    double post_lon = west_lon + column * post_spacing;
+    double post_lat = south_lat + (rows - 1 - row) * post_spacing;
+    double x, y;
+    geo.to_mesh(post_lon, post_lat, x, y);
+
+    // centroid at (x, y), a metre or so across
+    double d = geo.mesh_length(1.0);
+    CDT cdt;
+    cdt.insert(CDT::Point(x - d, y - d));
+    cdt.insert(CDT::Point(x + d, y - d));
+    cdt.insert(CDT::Point(x, y + 2 * d));
+    ASSERT_EQ(1, (int) cdt.number_of_faces());
+
+    Cell_table cells;
+    CDT::Face_handle face = cdt.finite_faces_begin();
+    int id = cells.add(face, cdt.triangle(face));
+    cells.update_coordinates(geo);
+    cells.update_ground(terrain);
+
+    EXPECT_NEAR(post_lon, cells.lat(id), 1e-7);
+    EXPECT_NEAR(post_lat, cells.lon(id), 1e-7);
+    EXPECT_NEAR(post_value(row, column), cells.ground(id), 1e-3);
+
+    std::remove(path.c_str());
+    std::remove((path.substr(0, path.size() - 4) + ".flt").c_str());
+    std::remove(path.substr(0, path.rfind('/')).c_str());
+}
+
+int main(int argc, char **argv){
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,206 @@
+/**
+ * @file /test/partitioners_test.cpp
+ *
+ * @brief The partitioners on a triangulated grid, spread and clustered start cells
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "../include/qtnp/multilevel_partitioner.hpp"
+#include "../include/qtnp/planning_control.hpp"
+#include "../include/qtnp/thread_pool.hpp"
+#include "../include/qtnp/voronoi_partitioner.hpp"
+
+/*****************************************************************************
+** Helpers
+*****************************************************************************/
+
+namespace {
+
+using namespace qtnp;
+
+const int columns(120);
+const int rows(120);
+const int agents(8);
+// what the multilevel balancing promises, plus a cell
+const double balance_tolerance(0.03);
+// the tuned Voronoi weights alone, well short of the tuning stopping early
+const double tuned_tolerance(0.1);
+
+// two triangles per square, 2 * (row * columns + column) the lower one; the edge lengths
+// vary around 1000 like those of a mesh, the same both ways
+Partition_graph grid(){
+
+    int n = 2 * columns * rows;
+    std::vector<std::vector<int> > neighbours(n);
+    for (int r=0; r<rows; r++){
+        for (int c=0; c<columns; c++){
+            int lower = 2 * (r * columns + c), upper = lower + 1;
+            neighbours[lower].push_back(upper);
+            neighbours[upper].push_back(lower);
+            if (c + 1 < columns){
+                neighbours[upper].push_back(lower + 2);
+                neighbours[lower + 2].push_back(upper);
+            }
+            if (r + 1 < rows){
+                neighbours[lower].push_back(upper + 2 * columns);
+                neighbours[upper + 2 * columns].push_back(lower);
+            }
+        }
+    }
+
+    Partition_graph graph;
+    graph.xadj.push_back(0);
+    for (int v=0; v<n; v++){
+        for (int i=0; i<neighbours[v].size(); i++){
+            int u = neighbours[v][i];
+            unsigned a = std::min(u, v), b = std::max(u, v);
+            graph.adjncy.push_back(u);
+            graph.adjwgt.push_back(700 + (a * 7919u + b * 104729u) % 601);
+        }
+        graph.xadj.push_back(graph.adjncy.size());
+    }
+    graph.vwgt.assign(n, 1);
+    return graph;
+}
+
+// agent p wants p + 1 shares
+std::vector<double> uneven_targets(){
+
+    std::vector<double> targets(agents);
+    for (int p=0; p<agents; p++) targets[p] = p + 1;
+    return targets;
+}
+
+// the start cells in the squares next to each other along the middle row
+std::vector<int> clustered_starts(){
+
+    std::vector<int> pinned(agents);
+    for (int p=0; p<agents; p++) pinned[p] = 2 * ((rows / 2) * columns + columns / 2 + p);
+    return pinned;
+}
+
+std::vector<int> spread_starts(){
+
+    std::vector<int> pinned(agents);
+    for (int p=0; p<agents; p++) pinned[p] = 2 * (((p * 7919) % rows) * columns + (p * 104729) % columns);
+    return pinned;
+}
+
+double worst_imbalance(const Partition_graph &graph, const std::vector<double> &targets, const std::vector<int> &part){
+
+    double shares(0);
+    for (int p=0; p<targets.size(); p++) shares += targets[p];
+    std::vector<double> weight(targets.size(), 0);
+    for (int v=0; v<part.size(); v++){
+        if (part[v] >= 0) weight[part[v]] += graph.vwgt[v];
+    }
+    double worst(0);
+    for (int p=0; p<targets.size(); p++){
+        double target = graph.size() * targets[p] / shares;
+        worst = std::max(worst, std::fabs(weight[p] - target) / target);
+    }
+    return worst;
+}
+
+// every part one piece around its start cell
+void expect_connected(const Partition_graph &graph, const std::vector<int> &pinned, const std::vector<int> &part){
+
+    for (int p=0; p<pinned.size(); p++){
+        ASSERT_EQ(p, part[pinned[p]]);
+        std::vector<bool> seen(graph.size(), false);
+        std::deque<int> queue(1, pinned[p]);
+        seen[pinned[p]] = true;
+        int reached(1);
+        while (!queue.empty()){
+            int v = queue.front();
+            queue.pop_front();
+            for (int e = graph.xadj[v]; e < graph.xadj[v + 1]; e++){
+                int u = graph.adjncy[e];
+                if (seen[u] || (part[u] != p)) continue;
+                seen[u] = true;
+                reached++;
+                queue.push_back(u);
+            }
+        }
+        EXPECT_EQ(std::count(part.begin(), part.end(), p), reached) << "part " << p << " in pieces";
+    }
+}
+
+}
+
+/*****************************************************************************
+** Tests
+*****************************************************************************/
+
+TEST(Voronoi_partitioner, UnevenTargetsSpreadStarts){
+
+    Partition_graph graph = grid();
+    std::vector<double> targets = uneven_targets();
+    std::vector<int> pinned = spread_starts();
+    Planning_control control;
+    Thread_pool pool(2);
+
+    Voronoi_partitioner voronoi(control, &pool);
+    std::vector<int> part = voronoi.partition(graph, targets, pinned);
+    EXPECT_LE(voronoi.imbalance(), tuned_tolerance);
+    EXPECT_NEAR(voronoi.imbalance(), worst_imbalance(graph, targets, part), 1e-9);
+    expect_connected(graph, pinned, part);
+
+    Multilevel_partitioner multilevel(control);
+    multilevel.balance(graph, targets, pinned, part, 50);
+    double shares = agents * (agents + 1) / 2;
+    EXPECT_LE(worst_imbalance(graph, targets, part), balance_tolerance + shares / graph.size());
+    expect_connected(graph, pinned, part);
+}
+
+// the start cells box each other in, the weights leave most of it to the border balancing
+TEST(Voronoi_partitioner, UnevenTargetsClusteredStarts){
+
+    Partition_graph graph = grid();
+    std::vector<double> targets = uneven_targets();
+    std::vector<int> pinned = clustered_starts();
+    Planning_control control;
+
+    Voronoi_partitioner voronoi(control, NULL);
+    std::vector<int> part = voronoi.partition(graph, targets, pinned);
+    EXPECT_NEAR(voronoi.imbalance(), worst_imbalance(graph, targets, part), 1e-9);
+    expect_connected(graph, pinned, part);
+
+    Multilevel_partitioner multilevel(control);
+    multilevel.balance(graph, targets, pinned, part, 50);
+    double shares = agents * (agents + 1) / 2;
+    EXPECT_LE(worst_imbalance(graph, targets, part), balance_tolerance + shares / graph.size());
+    EXPECT_NEAR(multilevel.imbalance(), worst_imbalance(graph, targets, part), 1e-9);
+    expect_connected(graph, pinned, part);
+}
+
+TEST(Multilevel_partitioner, UnevenTargetsClusteredStarts){
+
+    Partition_graph graph = grid();
+    std::vector<double> targets = uneven_targets();
+    std::vector<int> pinned = clustered_starts();
+    Planning_control control;
+
+    Multilevel_partitioner multilevel(control);
+    std::vector<int> part = multilevel.partition(graph, targets, pinned);
+    double shares = agents * (agents + 1) / 2;
+    EXPECT_LE(worst_imbalance(graph, targets, part), balance_tolerance + shares / graph.size());
+    EXPECT_NEAR(multilevel.imbalance(), worst_imbalance(graph, targets, part), 1e-9);
+    expect_connected(graph, pinned, part);
+}
+
+int main(int argc, char **argv){
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,118 @@
+/**
+ * @file /tools/mock_mavros.cpp
+ *
+ * @brief Stand-in for the mission plugin of one mavros instance per UAS, to exercise
+ *        the mission upload without vehicles or autopilots.
+ *
+ * Parameters (private):
+ *   vehicles (int, 2)             number of /uas<id>/mavros namespaces to serve
+ *   namespace_prefix (str, /uas)  same meaning as qtnp's ~mavros_namespace_prefix
+ *   latency_per_waypoint (double, 0.02) simulated transfer time in seconds
+ *   fail_rate (double, 0.0)       probability of rejecting a push
+ *
+ * @date October 2026
+ **/
+
+/*****************************************************************************
+** Includes
+*****************************************************************************/
+
+#include <ros/ros.h>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "mavros_msgs/WaypointList.h"
+#include "mavros_msgs/WaypointPush.h"
+#include "mavros_msgs/WaypointClear.h"
+
+/*****************************************************************************
+** Mock vehicle
+*****************************************************************************/
+
+namespace {
+
+struct Mock_vehicle {
+    std::string ns;
+    double latency_per_waypoint;
+    double fail_rate;
+
+    ros::ServiceServer push_server, clear_server;
+    ros::Publisher waypoints_pub;
+    mavros_msgs::WaypointList mission;
+
+    bool push(mavros_msgs::WaypointPush::Request &req, mavros_msgs::WaypointPush::Response &res){
+
+        ros::Duration(latency_per_waypoint * req.waypoints.size()).sleep();
+
+        if ( (double) std::rand() / RAND_MAX < fail_rate ){
+            ROS_WARN("%s: rejecting a mission of %zu waypoints", ns.c_str(), req.waypoints.size());
+            res.success = false;
+            res.wp_transfered = 0;
+            return true;
+        }
+
+        mission.waypoints = req.waypoints;
+        mission.current_seq = 0;
+        waypoints_pub.publish(mission);
+
+        res.success = true;
+        res.wp_transfered = req.waypoints.size();
+        ROS_INFO("%s: stored a mission of %zu waypoints", ns.c_str(), req.waypoints.size());
+        return true;
+    }
+
+    bool clear(mavros_msgs::WaypointClear::Request &req, mavros_msgs::WaypointClear::Response &res){
+
+        mission.waypoints.clear();
+        waypoints_pub.publish(mission);
+        res.success = true;
+        return true;
+    }
+};
+
+}
+
+/*****************************************************************************
+** Main
+*****************************************************************************/
+
+int main(int argc, char **argv) {
+
+    ros::init(argc, argv, "qtnp_mock_mavros");
+    ros::NodeHandle n, private_n("~");
+
+    int vehicles;
+    std::string prefix;
+    double latency, fail_rate;
+    private_n.param("vehicles", vehicles, 2);
+    private_n.param("namespace_prefix", prefix, std::string("/uas"));
+    private_n.param("latency_per_waypoint", latency, 0.02);
+    private_n.param("fail_rate", fail_rate, 0.0);
+
+    std::vector<boost::shared_ptr<Mock_vehicle> > mock_vehicles;
+    for (int id = 1; id <= vehicles; id++){
+
+        boost::shared_ptr<Mock_vehicle> vehicle(new Mock_vehicle);
+        std::stringstream ns;
+        ns << prefix << id << "/mavros";
+        vehicle->ns = ns.str();
+        vehicle->latency_per_waypoint = latency;
+        vehicle->fail_rate = fail_rate;
+
+        vehicle->waypoints_pub = n.advertise<mavros_msgs::WaypointList>(vehicle->ns + "/mission/waypoints", 1, true);
+        vehicle->push_server = n.advertiseService(vehicle->ns + "/mission/push", &Mock_vehicle::push, vehicle.get());
+        vehicle->clear_server = n.advertiseService(vehicle->ns + "/mission/clear", &Mock_vehicle::clear, vehicle.get());
+        vehicle->waypoints_pub.publish(vehicle->mission);
+
+        mock_vehicles.push_back(vehicle);
+    }
+
+    // one thread per vehicle, so parallel uploads really overlap
+    ros::MultiThreadedSpinner spinner(vehicles > 0 ? vehicles : 1);
+    spinner.spin();
+
+    return 0;
+}